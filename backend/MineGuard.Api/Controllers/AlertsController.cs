@@ -1,4 +1,5 @@
 using Microsoft.AspNetCore.Mvc;
+using MineGuard.Api.Models;
 using MineGuard.Api.Services;
 
 namespace MineGuard.Api.Controllers;
@@ -17,14 +18,29 @@ public class AlertsController : ControllerBase
     [HttpGet]
     public IActionResult GetActive()
     {
-        var alerts = _fleetState.GetActiveAlerts();
-        return Ok(alerts);
+        return this.Snapshot(_fleetState.CurrentSnapshot.Alerts);
     }
 
     [HttpGet("history")]
-    public IActionResult GetHistory()
+    public IActionResult GetHistory(
+        [FromQuery] long? from,
+        [FromQuery] long? to,
+        [FromQuery] string? vehicle,
+        [FromQuery] int? minPriority,
+        [FromQuery] int? type,
+        [FromQuery] long? cursor,
+        [FromQuery] int limit = 100)
     {
-        var history = _fleetState.GetAlertHistory();
+        var history = _fleetState.GetAlertHistory(new AlertHistoryQuery
+        {
+            From = from,
+            To = to,
+            VehicleId = vehicle,
+            MinPriority = minPriority,
+            AlertType = type,
+            Cursor = cursor,
+            Limit = limit
+        });
         return Ok(history);
     }
 }
@@ -0,0 +1,24 @@
+using Microsoft.AspNetCore.Mvc;
+using MineGuard.Api.Services;
+
+namespace MineGuard.Api.Controllers;
+
+[ApiController]
+[Route("api/[controller]")]
+public class HeatmapController : ControllerBase
+{
+    private readonly FleetStateService _fleetState;
+
+    public HeatmapController(FleetStateService fleetState)
+    {
+        _fleetState = fleetState;
+    }
+
+    // Ultimo tile publicado pelo simulador, byte a byte como chegou
+    [HttpGet]
+    public IActionResult Get([FromQuery] string? source)
+    {
+        var tile = _fleetState.GetHeatmap(source);
+        return tile == null ? NotFound() : this.Snapshot(tile);
+    }
+}
@@ -0,0 +1,24 @@
+using Microsoft.AspNetCore.Mvc;
+using MineGuard.Api.Services;
+
+namespace MineGuard.Api.Controllers;
+
+[ApiController]
+[Route("api/[controller]")]
+public class KpiController : ControllerBase
+{
+    private readonly FleetStateService _fleetState;
+
+    public KpiController(FleetStateService fleetState)
+    {
+        _fleetState = fleetState;
+    }
+
+    // Ultimo frame de KPIs de producao da fonte, byte a byte como chegou
+    [HttpGet]
+    public IActionResult Get([FromQuery] string? source)
+    {
+        var kpi = _fleetState.GetKpi(source);
+        return kpi == null ? NotFound() : this.Snapshot(kpi);
+    }
+}
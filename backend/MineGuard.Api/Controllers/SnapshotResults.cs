@@ -0,0 +1,18 @@
+using Microsoft.AspNetCore.Mvc;
+using Microsoft.Net.Http.Headers;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Controllers;
+
+internal static class SnapshotResults
+{
+    // Devolve os bytes ja serializados do snapshot. O FileContentResult
+    // emite o ETag e responde 304 sozinho quando o If-None-Match bate.
+    public static IActionResult Snapshot(this ControllerBase controller, SnapshotEntry entry)
+    {
+        // Navegador sempre revalida, mas pode reusar o corpo em cache
+        controller.Response.Headers.CacheControl = "no-cache";
+        return controller.File(entry.Json, "application/json; charset=utf-8",
+            lastModified: null, entityTag: new EntityTagHeaderValue(entry.ETag));
+    }
+}
@@ -0,0 +1,23 @@
+using Microsoft.AspNetCore.Mvc;
+using MineGuard.Api.Services;
+
+namespace MineGuard.Api.Controllers;
+
+[ApiController]
+[Route("api/[controller]")]
+public class SourcesController : ControllerBase
+{
+    private readonly FleetStateService _fleetState;
+
+    public SourcesController(FleetStateService fleetState)
+    {
+        _fleetState = fleetState;
+    }
+
+    [HttpGet]
+    public IActionResult GetAll()
+    {
+        var sources = _fleetState.GetSources();
+        return Ok(sources);
+    }
+}
@@ -0,0 +1,75 @@
+using System.Text;
+using Microsoft.AspNetCore.Mvc;
+using MineGuard.Api.Services;
+
+namespace MineGuard.Api.Controllers;
+
+[ApiController]
+[Route("api/[controller]")]
+public class StreamController : ControllerBase
+{
+    private static readonly byte[] KeepAlive = Encoding.UTF8.GetBytes(": keepalive\n\n");
+    private static readonly TimeSpan KeepAliveInterval = TimeSpan.FromSeconds(15);
+
+    private readonly FleetStreamHub _hub;
+
+    public StreamController(FleetStreamHub hub)
+    {
+        _hub = hub;
+    }
+
+    // Server-Sent Events: snapshot na conexao, depois um delta por tick
+    [HttpGet]
+    public async Task Get()
+    {
+        var ct = HttpContext.RequestAborted;
+
+        Response.Headers.ContentType = "text/event-stream";
+        Response.Headers.CacheControl = "no-cache";
+        Response.Headers["X-Accel-Buffering"] = "no";
+
+        var sub = _hub.Subscribe(out var snapshot);
+        try
+        {
+            await Response.Body.WriteAsync(snapshot, ct);
+            await Response.Body.FlushAsync(ct);
+
+            while (!ct.IsCancellationRequested)
+            {
+                if (sub.NeedsResync)
+                {
+                    await Response.Body.WriteAsync(_hub.Resync(sub), ct);
+                    await Response.Body.FlushAsync(ct);
+                    continue;
+                }
+
+                // Espera o proximo delta; sem tick, manda comentario pra manter a conexao
+                using var wait = CancellationTokenSource.CreateLinkedTokenSource(ct);
+                wait.CancelAfter(KeepAliveInterval);
+                try
+                {
+                    if (!await sub.Reader.WaitToReadAsync(wait.Token)) break;
+                }
+                catch (OperationCanceledException) when (!ct.IsCancellationRequested)
+                {
+                    await Response.Body.WriteAsync(KeepAlive, ct);
+                    await Response.Body.FlushAsync(ct);
+                    continue;
+                }
+
+                while (sub.Reader.TryRead(out var message))
+                {
+                    await Response.Body.WriteAsync(message, ct);
+                }
+                await Response.Body.FlushAsync(ct);
+            }
+        }
+        catch (OperationCanceledException)
+        {
+        }
+        finally
+        {
+            _hub.Unsubscribe(sub);
+        }
+    }
+}
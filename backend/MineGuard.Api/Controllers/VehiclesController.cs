@@ -17,8 +17,7 @@ public class VehiclesController : ControllerBase
     [HttpGet]
     public IActionResult GetAll()
     {
-        var vehicles = _fleetState.GetAllVehicles();
-        return Ok(vehicles);
+        return this.Snapshot(_fleetState.CurrentSnapshot.Vehicles);
     }
 
     [HttpGet("{id}")]
@@ -30,4 +29,20 @@ public class VehiclesController : ControllerBase
 
         return Ok(vehicle);
     }
+
+    // Rastro dos ultimos seconds (padrao 10 min, no maximo o turno):
+    // 1 amostra/s ate 30 min, depois 1 a cada 5 s
+    [HttpGet("{id}/trail")]
+    public IActionResult GetTrail(string id, [FromQuery] int seconds = 600)
+    {
+        if (seconds <= 0)
+            return BadRequest(new { error = "seconds must be positive" });
+
+        var window = TimeSpan.FromSeconds(Math.Min(seconds, VehicleTrail.CoarseWindow.TotalSeconds));
+        var trail = _fleetState.GetVehicleTrail(id, window);
+        if (trail == null)
+            return NotFound(new { error = $"Vehicle '{id}' not found" });
+
+        return Ok(trail);
+    }
 }
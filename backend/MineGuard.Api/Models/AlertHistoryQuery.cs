@@ -0,0 +1,22 @@
+namespace MineGuard.Api.Models;
+
+// Filtros de /api/alerts/history (todos opcionais)
+public class AlertHistoryQuery
+{
+    public long? From { get; set; }          // epoch ms, inclusivo
+    public long? To { get; set; }            // epoch ms, inclusivo
+    public string? VehicleId { get; set; }   // qualquer um dos dois veiculos do alerta
+    public int? MinPriority { get; set; }    // 1=LOW .. 4=CRITICAL
+    public int? AlertType { get; set; }
+    public long? Cursor { get; set; }        // devolve so alertas mais antigos que o cursor
+    public int Limit { get; set; } = 100;
+}
+
+// Pagina de resultados, do mais novo pro mais antigo
+public class AlertHistoryPage
+{
+    public List<CollisionAlert> Items { get; set; } = new();
+
+    // Passar como cursor pra buscar a proxima pagina (null = acabou)
+    public long? NextCursor { get; set; }
+}
@@ -22,6 +22,16 @@ public class CollisionAlert
     [JsonPropertyName("distance")]
     public double Distance { get; set; }
 
+    // Probabilidade de colisao no horizonte (modo de risco do simulador);
+    // 1 quando o simulador roda deterministico ou nao manda o campo
+    [JsonPropertyName("probability")]
+    public double Probability { get; set; } = 1.0;
+
+    // Ponto previsto de maior aproximacao do par (ponto medio entre
+    // os dois); null quando o simulador nao manda o campo
+    [JsonPropertyName("cpa")]
+    public Position? Cpa { get; set; }
+
     [JsonPropertyName("timestamp")]
     public long Timestamp { get; set; }
 
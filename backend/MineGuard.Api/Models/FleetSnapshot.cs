@@ -0,0 +1,47 @@
+namespace MineGuard.Api.Models;
+
+// Corpo JSON ja serializado de um recurso, com versao propria.
+// A versao so muda quando os bytes mudam, entao o ETag continua
+// valido entre ticks em que o recurso ficou igual.
+//
+// A versao e um contador do processo: o ETag leva a epoca do processo
+// (reinicio do backend nao repete ETag com outros bytes) e, nos
+// recursos por fonte, o escopo da fonte (heatmap/kpi sem ?source podem
+// trocar de fonte entre duas consultas).
+public sealed class SnapshotEntry
+{
+    public static readonly string ProcessEpoch = DateTime.UtcNow.Ticks.ToString("x");
+
+    public static readonly SnapshotEntry EmptyArray = new(0, "[]"u8.ToArray());
+
+    public long Version { get; }
+    public byte[] Json { get; }
+    public string ETag { get; }
+
+    // scope: so caracteres validos em ETag (sem aspas)
+    public SnapshotEntry(long version, byte[] json, string scope = "")
+    {
+        Version = version;
+        Json = json;
+        ETag = scope.Length == 0
+            ? $"\"{ProcessEpoch}.v{version}\""
+            : $"\"{ProcessEpoch}.{scope}.v{version}\"";
+    }
+}
+
+// Estado imutavel publicado uma vez por tick ingerido
+public sealed class FleetSnapshot
+{
+    public static readonly FleetSnapshot Empty = new(0, SnapshotEntry.EmptyArray, SnapshotEntry.EmptyArray);
+
+    public long Version { get; }
+    public SnapshotEntry Vehicles { get; }
+    public SnapshotEntry Alerts { get; }
+
+    public FleetSnapshot(long version, SnapshotEntry vehicles, SnapshotEntry alerts)
+    {
+        Version = version;
+        Vehicles = vehicles;
+        Alerts = alerts;
+    }
+}
@@ -0,0 +1,26 @@
+namespace MineGuard.Api.Models;
+
+// Contadores do GC do processo, acumulados desde o inicio. O gerador
+// de carga le antes e depois de cada passo e reporta a diferenca.
+public class GcStats
+{
+    public long AllocatedBytes { get; set; }    // GC.GetTotalAllocatedBytes
+    public long HeapBytes { get; set; }         // heap gerenciado em uso
+    public int Gen0Collections { get; set; }
+    public int Gen1Collections { get; set; }
+    public int Gen2Collections { get; set; }
+    public double PauseMs { get; set; }         // tempo total em pausa de GC
+
+    public static GcStats Capture()
+    {
+        return new GcStats
+        {
+            AllocatedBytes = GC.GetTotalAllocatedBytes(precise: false),
+            HeapBytes = GC.GetTotalMemory(forceFullCollection: false),
+            Gen0Collections = GC.CollectionCount(0),
+            Gen1Collections = GC.CollectionCount(1),
+            Gen2Collections = GC.CollectionCount(2),
+            PauseMs = GC.GetTotalPauseDuration().TotalMilliseconds
+        };
+    }
+}
@@ -0,0 +1,35 @@
+namespace MineGuard.Api.Models;
+
+// Percentis de um segmento do pipeline (em milissegundos)
+public class LatencyStats
+{
+    public long Count { get; set; }
+    public double P50Ms { get; set; }
+    public double P99Ms { get; set; }
+    public double MaxMs { get; set; }
+}
+
+// Latencia por segmento: simulador -> rede -> parse -> estado aplicado
+// -> snapshot da API publicado
+public class PipelineLatency
+{
+    // Geracao do pacote (Vehicle::generate_packet) ate o envio
+    public LatencyStats TickToSend { get; set; } = new();
+
+    // Envio ate o frame completo recebido (depende de relogios sincronizados)
+    public LatencyStats Network { get; set; } = new();
+
+    // Frame recebido ate o JSON lido (nada aplicado ainda)
+    public LatencyStats Parse { get; set; } = new();
+
+    // JSON lido ate o frame aplicado e registrado na particao da fonte
+    public LatencyStats Apply { get; set; } = new();
+
+    // Geracao do pacote ate o frame aplicado
+    public LatencyStats EndToEnd { get; set; } = new();
+
+    // Geracao do pacote mais antigo ainda nao publicado ate o snapshot
+    // da API com ele no ar (SLO de visibilidade dos alertas). Inclui a
+    // espera pelo ciclo do publicador, ate PublishInterval.
+    public LatencyStats Visible { get; set; } = new();
+}
@@ -0,0 +1,21 @@
+namespace MineGuard.Api.Models;
+
+// Saude e estatisticas de uma fonte de ingestao (gateway/simulador)
+public class SourceStatus
+{
+    public string SourceId { get; set; } = string.Empty;
+    public long SessionId { get; set; }
+    public bool Connected { get; set; }
+    public string Health { get; set; } = "OFFLINE";   // ONLINE, STALE, OFFLINE
+    public string RemoteEndpoint { get; set; } = string.Empty;
+    public long ConnectedAt { get; set; }
+    public long LastFrameAt { get; set; }
+    public long LastTickId { get; set; }
+    public int Sessions { get; set; }
+    public int Vehicles { get; set; }
+    public int ActiveAlerts { get; set; }
+    public long FramesReceived { get; set; }
+    public long TelemetryReceived { get; set; }
+    public long AlertsReceived { get; set; }
+    public long ParseErrors { get; set; }
+}
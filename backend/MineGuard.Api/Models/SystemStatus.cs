@@ -2,11 +2,15 @@ namespace MineGuard.Api.Models;
 
 public class SystemStatus
 {
-    public bool SimulatorConnected { get; set; }
+    public bool SimulatorConnected { get; set; }   // alguma fonte conectada
+    public int ConnectedSources { get; set; }
     public int TotalVehicles { get; set; }
     public int OnlineVehicles { get; set; }
     public int ActiveAlerts { get; set; }
     public int TotalAlertsReceived { get; set; }
     public long UptimeSeconds { get; set; }
     public long LastTelemetryTimestamp { get; set; }
+    public long LastTickId { get; set; }
+    public PipelineLatency Latency { get; set; } = new();
+    public GcStats Gc { get; set; } = new();
 }
@@ -0,0 +1,21 @@
+namespace MineGuard.Api.Models;
+
+// Telemetria de um veiculo lida direto do frame TCP (sem DTO intermediario).
+// Struct reaproveitada pelo parser a cada pacote: nao aloca no caminho de ingestao.
+public struct TelemetryFrame
+{
+    public string VehicleId;
+    public long Timestamp;
+    public int VehicleType;
+    public int CycleState;
+
+    public double Latitude;
+    public double Longitude;
+    public double Altitude;
+
+    public double Speed;
+    public double Heading;
+    public double Payload;
+    public double FuelLevel;
+    public double EngineRpm;
+}
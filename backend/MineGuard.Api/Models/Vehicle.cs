@@ -10,6 +10,9 @@ public class Vehicle
     public long LastUpdate { get; set; }
     public bool Online { get; set; }
 
+    // 1 = ja esta na fila de mudancas da fonte pro proximo delta do stream
+    internal int StreamQueued;
+
     public string VehicleTypeName => VehicleType switch
     {
         0 => "HaulTruck",
@@ -27,4 +30,51 @@ public class Vehicle
         4 => "RETURNING",
         _ => "UNKNOWN"
     };
+
+    // Atualiza no lugar a partir do frame (caminho de ingestao, sem alocar)
+    public void Apply(in TelemetryFrame frame)
+    {
+        VehicleType = frame.VehicleType;
+        CycleState = frame.CycleState;
+
+        Position.Latitude = frame.Latitude;
+        Position.Longitude = frame.Longitude;
+        Position.Altitude = frame.Altitude;
+
+        Telemetry.Speed = frame.Speed;
+        Telemetry.Heading = frame.Heading;
+        Telemetry.Payload = frame.Payload;
+        Telemetry.FuelLevel = frame.FuelLevel;
+        Telemetry.EngineRpm = frame.EngineRpm;
+
+        LastUpdate = frame.Timestamp;
+        Online = true;
+    }
+
+    // Copia independente pra leitura pela API
+    public Vehicle Clone()
+    {
+        return new Vehicle
+        {
+            Id = Id,
+            VehicleType = VehicleType,
+            CycleState = CycleState,
+            Position = new Position
+            {
+                Latitude = Position.Latitude,
+                Longitude = Position.Longitude,
+                Altitude = Position.Altitude
+            },
+            Telemetry = new VehicleTelemetry
+            {
+                Speed = Telemetry.Speed,
+                Heading = Telemetry.Heading,
+                Payload = Telemetry.Payload,
+                FuelLevel = Telemetry.FuelLevel,
+                EngineRpm = Telemetry.EngineRpm
+            },
+            LastUpdate = LastUpdate,
+            Online = Online
+        };
+    }
 }
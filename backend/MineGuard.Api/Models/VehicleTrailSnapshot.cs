@@ -0,0 +1,15 @@
+namespace MineGuard.Api.Models;
+
+// Trecho do rastro de um veiculo, no formato do anel (ver TrailRing).
+// Slot i fica em start + i * resolutionMs; pares (leste, norte) em
+// decimetros a partir da amostra anterior do bloco, ou do keyframe
+// (lat, lon) na primeira amostra do bloco. -32768 = slot sem amostra.
+public class VehicleTrailSnapshot
+{
+    public string Id { get; set; } = string.Empty;
+    public long ResolutionMs { get; set; }
+    public int BlockSize { get; set; }
+    public long Start { get; set; }
+    public double[] Keyframes { get; set; } = Array.Empty<double>();
+    public short[] Points { get; set; } = Array.Empty<short>();
+}
@@ -10,8 +10,12 @@ builder.Services.AddControllers()
         // API responde em camelCase pro dashboard JS
         options.JsonSerializerOptions.PropertyNamingPolicy = JsonNamingPolicy.CamelCase;
     });
+builder.Services.AddSingleton<LatencyTracker>();
+builder.Services.AddSingleton<AlertHistoryStore>();
 builder.Services.AddSingleton<FleetStateService>();
+builder.Services.AddSingleton<FleetStreamHub>();
 builder.Services.AddHostedService<TcpListenerService>();
+builder.Services.AddHostedService<FleetPublisherService>();
 
 // CORS - permitir dashboard acessar a API
 builder.Services.AddCors(options =>
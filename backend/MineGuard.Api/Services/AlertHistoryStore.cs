@@ -0,0 +1,401 @@
+using System.Text;
+using System.Text.Json;
+using System.Threading.Channels;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// ============================================================
+// Historico de alertas limitado e indexado por tempo
+//
+// Anel de chunks de tamanho fixo em memoria. Cada chunk guarda
+// min/max timestamp, mascaras de prioridade/tipo e um bloom filter
+// dos veiculos, entao uma consulta so abre os chunks relevantes.
+// Chunks que saem do anel sao gravados em arquivos append-only
+// (JSON lines); o indice desses segmentos continua em memoria e
+// consultas antigas leem so os trechos do arquivo que batem.
+//
+// Os arquivos giram a cada SegmentsPerFile segmentos e so os
+// MaxSpillFiles mais novos ficam: o mais antigo sai do indice e do
+// disco junto. Memoria do indice limitada a MaxSpillFiles x
+// SegmentsPerFile segmentos (~2 KB de bloom cada, ~2 MB no total);
+// retencao no disco de ~4M alertas.
+// ============================================================
+
+public sealed class AlertHistoryStore : IDisposable
+{
+    public const int ChunkSize = 4096;
+    public const int MaxChunksInMemory = 64;
+    public const int MaxPageSize = 1000;
+    public const int SegmentsPerFile = 64;
+    public const int MaxSpillFiles = 16;
+
+    private static readonly JsonSerializerOptions SpillJsonOptions = new()
+    {
+        IgnoreReadOnlyProperties = true
+    };
+
+    // Metadados comuns a chunks em memoria e segmentos no disco
+    private class SegmentInfo
+    {
+        public long FirstSequence;
+        public long MinTimestamp = long.MaxValue;
+        public long MaxTimestamp = long.MinValue;
+        public int PriorityMask;
+        public int TypeMask;
+        public VehicleBloom Vehicles = null!;
+
+        public void Include(CollisionAlert alert)
+        {
+            if (alert.Timestamp < MinTimestamp) MinTimestamp = alert.Timestamp;
+            if (alert.Timestamp > MaxTimestamp) MaxTimestamp = alert.Timestamp;
+            PriorityMask |= 1 << (alert.Priority & 31);
+            TypeMask |= 1 << (alert.AlertType & 31);
+            Vehicles.Add(VehicleKey.From(alert.VehicleId1));
+            Vehicles.Add(VehicleKey.From(alert.VehicleId2));
+        }
+
+        public bool Matches(AlertHistoryQuery q, VehicleKey? vehicle, int priorityBits)
+        {
+            if (q.Cursor.HasValue && FirstSequence >= q.Cursor.Value) return false;
+            if (q.From.HasValue && MaxTimestamp < q.From.Value) return false;
+            if (q.To.HasValue && MinTimestamp > q.To.Value) return false;
+            if ((PriorityMask & priorityBits) == 0) return false;
+            if (q.AlertType.HasValue && (TypeMask & (1 << (q.AlertType.Value & 31))) == 0) return false;
+            if (vehicle.HasValue && !Vehicles.MayContain(vehicle.Value)) return false;
+            return true;
+        }
+    }
+
+    private sealed class Chunk : SegmentInfo
+    {
+        public Chunk() { Vehicles = new VehicleBloom(); }
+
+        public readonly CollisionAlert[] Items = new CollisionAlert[ChunkSize];
+        public int Count;   // publicado com Volatile depois dos metadados
+    }
+
+    private sealed class SpilledSegment : SegmentInfo
+    {
+        public string Path = string.Empty;
+        public int Count;
+        public long Offset;
+        public int Length;
+    }
+
+    private readonly object _lock = new();
+    private readonly object _appendLock = new();
+    private readonly Queue<Chunk> _chunks = new();
+    private readonly List<Chunk> _pendingSpill = new();
+    private readonly List<SpilledSegment> _spilled = new();
+    private readonly Channel<Chunk> _spillQueue = Channel.CreateUnbounded<Chunk>(
+        new UnboundedChannelOptions { SingleReader = true });
+    private readonly Task _spillTask;
+    private readonly string _spillPrefix;
+    private readonly Queue<string> _spillFiles = new();   // so a task de spill mexe
+    private readonly ILogger<AlertHistoryStore> _logger;
+
+    private Chunk? _head;
+    private long _nextSequence;
+
+    public AlertHistoryStore(IHostEnvironment env, ILogger<AlertHistoryStore> logger)
+    {
+        _logger = logger;
+
+        var dir = Path.Combine(env.ContentRootPath, "data");
+        Directory.CreateDirectory(dir);
+        _spillPrefix = Path.Combine(dir, $"alert-history-{DateTime.UtcNow:yyyyMMddHHmmss}");
+
+        _spillTask = Task.Run(SpillLoop);
+    }
+
+    // Varias sessoes de ingestao podem anexar; leitores nao pegam este lock
+    public void Append(CollisionAlert alert)
+    {
+        lock (_appendLock)
+        {
+            var head = _head;
+            if (head == null || head.Count == ChunkSize)
+            {
+                head = new Chunk { FirstSequence = _nextSequence };
+                lock (_lock)
+                {
+                    _chunks.Enqueue(head);
+                    if (_chunks.Count > MaxChunksInMemory)
+                    {
+                        var oldest = _chunks.Dequeue();
+                        _pendingSpill.Add(oldest);
+                        _spillQueue.Writer.TryWrite(oldest);
+                    }
+                }
+                _head = head;
+            }
+
+            head.Items[head.Count] = alert;
+            head.Include(alert);
+            Volatile.Write(ref head.Count, head.Count + 1);
+            _nextSequence++;
+        }
+    }
+
+    public AlertHistoryPage Query(AlertHistoryQuery query)
+    {
+        int limit = Math.Clamp(query.Limit, 1, MaxPageSize);
+        VehicleKey? vehicle = string.IsNullOrEmpty(query.VehicleId) ? null : VehicleKey.From(query.VehicleId);
+        int priorityBits = PriorityBits(query.MinPriority);
+
+        Chunk[] memory;
+        SpilledSegment[] spilled;
+        lock (_lock)
+        {
+            // Pendentes de gravacao ainda sao consultados em memoria
+            memory = _pendingSpill.Concat(_chunks).ToArray();
+            spilled = _spilled.ToArray();
+        }
+
+        var page = new AlertHistoryPage();
+
+        // Do mais novo pro mais antigo
+        for (int c = memory.Length - 1; c >= 0 && page.Items.Count < limit; c--)
+        {
+            var chunk = memory[c];
+            int count = Volatile.Read(ref chunk.Count);
+            if (count == 0 || !chunk.Matches(query, vehicle, priorityBits)) continue;
+
+            for (int i = count - 1; i >= 0 && page.Items.Count < limit; i--)
+            {
+                long sequence = chunk.FirstSequence + i;
+                if (Accept(chunk.Items[i], sequence, query))
+                {
+                    page.Items.Add(chunk.Items[i]);
+                    page.NextCursor = sequence;
+                }
+            }
+        }
+
+        for (int s = spilled.Length - 1; s >= 0 && page.Items.Count < limit; s--)
+        {
+            var segment = spilled[s];
+            if (!segment.Matches(query, vehicle, priorityBits)) continue;
+
+            var alerts = ReadSegment(segment);
+            for (int i = alerts.Count - 1; i >= 0 && page.Items.Count < limit; i--)
+            {
+                long sequence = segment.FirstSequence + i;
+                if (Accept(alerts[i], sequence, query))
+                {
+                    page.Items.Add(alerts[i]);
+                    page.NextCursor = sequence;
+                }
+            }
+        }
+
+        if (page.Items.Count < limit) page.NextCursor = null;
+        return page;
+    }
+
+    private static bool Accept(CollisionAlert alert, long sequence, AlertHistoryQuery q)
+    {
+        if (q.Cursor.HasValue && sequence >= q.Cursor.Value) return false;
+        if (q.From.HasValue && alert.Timestamp < q.From.Value) return false;
+        if (q.To.HasValue && alert.Timestamp > q.To.Value) return false;
+        if (q.MinPriority.HasValue && alert.Priority < q.MinPriority.Value) return false;
+        if (q.AlertType.HasValue && alert.AlertType != q.AlertType.Value) return false;
+        if (!string.IsNullOrEmpty(q.VehicleId) &&
+            alert.VehicleId1 != q.VehicleId && alert.VehicleId2 != q.VehicleId) return false;
+        return true;
+    }
+
+    // ============================================================
+    // Spill pro disco (task em background)
+    // ============================================================
+
+    private async Task SpillLoop()
+    {
+        FileStream? file = null;
+        string path = string.Empty;
+        int segmentsInFile = 0;
+        int fileIndex = 0;
+
+        try
+        {
+            await foreach (var chunk in _spillQueue.Reader.ReadAllAsync())
+            {
+                try
+                {
+                    if (file == null || segmentsInFile == SegmentsPerFile)
+                    {
+                        if (file != null) await file.DisposeAsync();
+                        file = null;
+                        path = $"{_spillPrefix}-{fileIndex++:D4}.jsonl";
+                        file = new FileStream(path, FileMode.Append, FileAccess.Write, FileShare.Read | FileShare.Delete);
+                        segmentsInFile = 0;
+
+                        _spillFiles.Enqueue(path);
+                        if (_spillFiles.Count > MaxSpillFiles) DropSpillFile(_spillFiles.Dequeue());
+                    }
+
+                    var buffer = new MemoryStream();
+                    for (int i = 0; i < chunk.Count; i++)
+                    {
+                        JsonSerializer.Serialize(buffer, chunk.Items[i], SpillJsonOptions);
+                        buffer.WriteByte((byte)'\n');
+                    }
+
+                    long offset = file.Position;
+                    buffer.Position = 0;
+                    await buffer.CopyToAsync(file);
+                    await file.FlushAsync();
+                    segmentsInFile++;
+
+                    var segment = new SpilledSegment
+                    {
+                        FirstSequence = chunk.FirstSequence,
+                        MinTimestamp = chunk.MinTimestamp,
+                        MaxTimestamp = chunk.MaxTimestamp,
+                        PriorityMask = chunk.PriorityMask,
+                        TypeMask = chunk.TypeMask,
+                        Vehicles = chunk.Vehicles,
+                        Path = path,
+                        Count = chunk.Count,
+                        Offset = offset,
+                        Length = (int)buffer.Length
+                    };
+
+                    lock (_lock)
+                    {
+                        _spilled.Add(segment);
+                        _pendingSpill.Remove(chunk);
+                    }
+                }
+                catch (Exception ex)
+                {
+                    // Sem disco o segmento se perde, mas a memoria continua limitada
+                    _logger.LogError(ex, "[HISTORY] Failed to spill alert segment");
+                    lock (_lock)
+                    {
+                        _pendingSpill.Remove(chunk);
+                    }
+                }
+            }
+        }
+        finally
+        {
+            if (file != null) await file.DisposeAsync();
+        }
+    }
+
+    // Arquivo mais antigo sai do indice (os segmentos dele estao no
+    // comeco, na ordem do spill) e depois do disco. Consulta que ja
+    // pegou o indice antigo pula os segmentos que nao acha mais.
+    private void DropSpillFile(string path)
+    {
+        lock (_lock)
+        {
+            int count = 0;
+            while (count < _spilled.Count && _spilled[count].Path == path) count++;
+            _spilled.RemoveRange(0, count);
+        }
+
+        try
+        {
+            File.Delete(path);
+        }
+        catch (IOException ex)
+        {
+            _logger.LogWarning("[HISTORY] Failed to delete expired spill file {Path}: {Error}", path, ex.Message);
+        }
+    }
+
+    private List<CollisionAlert> ReadSegment(SpilledSegment segment)
+    {
+        var alerts = new List<CollisionAlert>(segment.Count);
+
+        byte[] bytes;
+        try
+        {
+            using var file = new FileStream(segment.Path, FileMode.Open, FileAccess.Read,
+                FileShare.ReadWrite | FileShare.Delete);
+            file.Seek(segment.Offset, SeekOrigin.Begin);
+
+            bytes = new byte[segment.Length];
+            file.ReadExactly(bytes);
+        }
+        catch (IOException)
+        {
+            // Arquivo expirou (DropSpillFile) depois da copia do indice
+            return alerts;
+        }
+
+        using var reader = new StringReader(Encoding.UTF8.GetString(bytes));
+        string? line;
+        while ((line = reader.ReadLine()) != null)
+        {
+            var alert = JsonSerializer.Deserialize<CollisionAlert>(line, SpillJsonOptions);
+            if (alert != null) alerts.Add(alert);
+        }
+
+        return alerts;
+    }
+
+    // ============================================================
+    // Helpers de mascara
+    // ============================================================
+
+    // Dois hashes do ID (estaveis so dentro do processo); as posicoes
+    // do bloom saem por double hashing
+    private readonly record struct VehicleKey(uint H1, uint H2)
+    {
+        public static VehicleKey From(string id)
+        {
+            uint h1 = (uint)id.GetHashCode();
+            uint h2 = (uint)((h1 * 0x9E3779B97F4A7C15UL) >> 32) | 1;   // impar: posicoes distintas
+            return new VehicleKey(h1, h2);
+        }
+    }
+
+    // Bloom dos veiculos de um chunk: 2 KB, 3 bits por ID. Um chunk tem
+    // no maximo 2 x ChunkSize IDs; com ate ~2000 veiculos distintos o
+    // falso positivo fica perto de 3%. O escritor seta bits sem lock; o
+    // leitor no pior caso ve um bit a mais que o Count publicado.
+    private sealed class VehicleBloom
+    {
+        private const int Bits = 16384;
+        private const int Hashes = 3;
+
+        private readonly ulong[] _words = new ulong[Bits / 64];
+
+        public void Add(VehicleKey key)
+        {
+            for (uint i = 0; i < Hashes; i++)
+            {
+                uint bit = (key.H1 + i * key.H2) & (Bits - 1);
+                _words[bit >> 6] |= 1UL << (int)(bit & 63);
+            }
+        }
+
+        public bool MayContain(VehicleKey key)
+        {
+            for (uint i = 0; i < Hashes; i++)
+            {
+                uint bit = (key.H1 + i * key.H2) & (Bits - 1);
+                if ((_words[bit >> 6] & (1UL << (int)(bit & 63))) == 0) return false;
+            }
+            return true;
+        }
+    }
+
+    private static int PriorityBits(int? minPriority)
+    {
+        int min = minPriority ?? 0;
+        int bits = 0;
+        for (int p = Math.Max(min, 0); p < 31; p++) bits |= 1 << p;
+        return bits;
+    }
+
+    public void Dispose()
+    {
+        _spillQueue.Writer.TryComplete();
+        _spillTask.Wait(TimeSpan.FromSeconds(5));
+    }
+}
@@ -0,0 +1,309 @@
+using System.Buffers;
+using System.Runtime.InteropServices;
+using System.Text.Json;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// Resumo do frame pra metricas de latencia
+public struct BatchFrameInfo
+{
+    public long TickId;
+    public long SentAt;
+    public long OldestTimestamp;   // pacote mais antigo do tick (0 = sem telemetria)
+    public int TelemetryCount;
+    public int AlertCount;
+}
+
+// Parser do frame batch direto dos bytes UTF-8 (Utf8JsonReader), sem
+// string intermediaria nem DTO por pacote. Parse so le: a telemetria
+// fica num buffer de structs reaproveitado e Apply aplica na particao
+// depois do frame inteiro ser lido. Frame malformado no meio nao deixa
+// atualizacao parcial, e quem chama mede leitura e aplicacao em
+// separado. Uma instancia por conexao.
+public sealed class BatchFrameParser
+{
+    private const int MaxIdLength = 256;
+
+    private readonly FleetStateService _fleetState;
+    private readonly SourcePartition _source;
+    private readonly Utf8StringCache _ids = new();
+    private readonly List<CollisionAlert> _alerts = new();
+    private readonly List<TelemetryFrame> _telemetry = new();
+    private byte[]? _heatmap;
+    private byte[]? _kpi;
+
+    public BatchFrameParser(FleetStateService fleetState, SourcePartition source)
+    {
+        _fleetState = fleetState;
+        _source = source;
+    }
+
+    // Handshake: {"type":"hello","protocol":1,"source_id":"...","ack":true}.
+    // ack (opcional) pede um frame de ack por batch processado.
+    // Retorna false se o frame nao e um hello (cliente sem handshake).
+    public static bool TryParseHello(ReadOnlySequence<byte> payload, out string sourceId, out bool ack)
+    {
+        sourceId = string.Empty;
+        ack = false;
+        bool isHello = false;
+
+        try
+        {
+            var reader = new Utf8JsonReader(payload, isFinalBlock: true, state: default);
+            Expect(ref reader, JsonTokenType.StartObject);
+            while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+            {
+                if (reader.ValueTextEquals("type"u8))
+                {
+                    reader.Read();
+                    isHello = reader.TokenType == JsonTokenType.String && reader.ValueTextEquals("hello"u8);
+                    if (!isHello) return false;
+                }
+                else if (reader.ValueTextEquals("source_id"u8))
+                {
+                    reader.Read();
+                    sourceId = reader.GetString() ?? string.Empty;
+                }
+                else if (reader.ValueTextEquals("ack"u8))
+                {
+                    reader.Read();
+                    ack = reader.TokenType == JsonTokenType.True;
+                }
+                else
+                {
+                    reader.Read();
+                    reader.Skip();
+                }
+            }
+        }
+        catch (Exception ex) when (ex is JsonException or InvalidOperationException or FormatException)
+        {
+            return false;
+        }
+
+        return isHello && sourceId.Length > 0 && sourceId.Length <= MaxIdLength;
+    }
+
+    // Le o frame sem aplicar nada. Lanca JsonException se estiver
+    // malformado (inclusive valor com tipo ou faixa errados, que o
+    // reader acusa com outras excecoes)
+    public BatchFrameInfo Parse(ReadOnlySequence<byte> payload)
+    {
+        try
+        {
+            return ParseFrame(payload);
+        }
+        catch (Exception ex) when (ex is InvalidOperationException or FormatException)
+        {
+            throw new JsonException(ex.Message, ex);
+        }
+    }
+
+    private BatchFrameInfo ParseFrame(ReadOnlySequence<byte> payload)
+    {
+        var info = new BatchFrameInfo();
+        var reader = new Utf8JsonReader(payload, isFinalBlock: true, state: default);
+
+        _alerts.Clear();
+        _telemetry.Clear();
+        _heatmap = null;
+        _kpi = null;
+
+        Expect(ref reader, JsonTokenType.StartObject);
+        while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+        {
+            if (reader.ValueTextEquals("tick_id"u8))
+            {
+                reader.Read();
+                info.TickId = reader.GetInt64();
+            }
+            else if (reader.ValueTextEquals("sent_at"u8))
+            {
+                reader.Read();
+                info.SentAt = reader.GetInt64();
+            }
+            else if (reader.ValueTextEquals("telemetry"u8))
+            {
+                Expect(ref reader, JsonTokenType.StartArray);
+                while (reader.Read() && reader.TokenType == JsonTokenType.StartObject)
+                {
+                    var frame = new TelemetryFrame();
+                    ReadTelemetry(ref reader, ref frame);
+
+                    _telemetry.Add(frame);
+                    info.TelemetryCount++;
+
+                    if (info.OldestTimestamp == 0 || frame.Timestamp < info.OldestTimestamp)
+                        info.OldestTimestamp = frame.Timestamp;
+                }
+            }
+            else if (reader.ValueTextEquals("alerts"u8))
+            {
+                Expect(ref reader, JsonTokenType.StartArray);
+                while (reader.Read() && reader.TokenType == JsonTokenType.StartObject)
+                {
+                    _alerts.Add(ReadAlert(ref reader));
+                }
+            }
+            else if (reader.ValueTextEquals("heatmap"u8))
+            {
+                // Tile ja pronto do simulador: guardado como veio, a API
+                // serve esses bytes sem decodificar
+                _heatmap = ReadRawObject(ref reader, payload);
+            }
+            else if (reader.ValueTextEquals("kpi"u8))
+            {
+                // Frame de KPIs de producao, mesmo tratamento do tile
+                _kpi = ReadRawObject(ref reader, payload);
+            }
+            else
+            {
+                reader.Read();
+                reader.Skip();
+            }
+        }
+
+        info.AlertCount = _alerts.Count;
+        return info;
+    }
+
+    // Aplica na particao o ultimo frame lido por Parse
+    public void Apply()
+    {
+        foreach (ref readonly var frame in CollectionsMarshal.AsSpan(_telemetry))
+        {
+            _source.UpdateVehicle(in frame);
+        }
+
+        _fleetState.UpdateAlerts(_source, _alerts);
+
+        if (_heatmap != null) _source.UpdateHeatmap(_heatmap);
+        if (_kpi != null) _source.UpdateKpi(_kpi);
+    }
+
+    // Copia o objeto inteiro (da chave ao fecha-chave) sem decodificar
+    private static byte[] ReadRawObject(ref Utf8JsonReader reader, ReadOnlySequence<byte> payload)
+    {
+        Expect(ref reader, JsonTokenType.StartObject);
+        long start = reader.TokenStartIndex;
+        reader.Skip();
+        return payload.Slice(start, reader.BytesConsumed - start).ToArray();
+    }
+
+    private void ReadTelemetry(ref Utf8JsonReader reader, ref TelemetryFrame frame)
+    {
+        while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+        {
+            if (reader.ValueTextEquals("vehicle_id"u8))
+            {
+                reader.Read();
+                frame.VehicleId = ReadId(ref reader);
+            }
+            else if (reader.ValueTextEquals("timestamp"u8))
+            {
+                reader.Read();
+                frame.Timestamp = reader.GetInt64();
+            }
+            else if (reader.ValueTextEquals("vehicle_type"u8))
+            {
+                reader.Read();
+                frame.VehicleType = reader.GetInt32();
+            }
+            else if (reader.ValueTextEquals("cycle_state"u8))
+            {
+                reader.Read();
+                frame.CycleState = reader.GetInt32();
+            }
+            else if (reader.ValueTextEquals("position"u8))
+            {
+                Expect(ref reader, JsonTokenType.StartObject);
+                while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+                {
+                    if (reader.ValueTextEquals("latitude"u8)) { reader.Read(); frame.Latitude = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("longitude"u8)) { reader.Read(); frame.Longitude = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("altitude"u8)) { reader.Read(); frame.Altitude = reader.GetDouble(); }
+                    else { reader.Read(); reader.Skip(); }
+                }
+            }
+            else if (reader.ValueTextEquals("telemetry"u8))
+            {
+                Expect(ref reader, JsonTokenType.StartObject);
+                while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+                {
+                    if (reader.ValueTextEquals("speed"u8)) { reader.Read(); frame.Speed = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("heading"u8)) { reader.Read(); frame.Heading = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("payload"u8)) { reader.Read(); frame.Payload = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("fuel_level"u8)) { reader.Read(); frame.FuelLevel = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("engine_rpm"u8)) { reader.Read(); frame.EngineRpm = reader.GetDouble(); }
+                    else { reader.Read(); reader.Skip(); }
+                }
+            }
+            else
+            {
+                reader.Read();
+                reader.Skip();
+            }
+        }
+
+        if (string.IsNullOrEmpty(frame.VehicleId))
+            throw new JsonException("Telemetry packet without vehicle_id");
+    }
+
+    // Alertas sao guardados no historico: aqui a alocacao e inevitavel
+    private CollisionAlert ReadAlert(ref Utf8JsonReader reader)
+    {
+        var alert = new CollisionAlert();
+
+        while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+        {
+            if (reader.ValueTextEquals("vehicle_id_1"u8)) { reader.Read(); alert.VehicleId1 = ReadId(ref reader); }
+            else if (reader.ValueTextEquals("vehicle_id_2"u8)) { reader.Read(); alert.VehicleId2 = ReadId(ref reader); }
+            else if (reader.ValueTextEquals("priority"u8)) { reader.Read(); alert.Priority = reader.GetInt32(); }
+            else if (reader.ValueTextEquals("alert_type"u8)) { reader.Read(); alert.AlertType = reader.GetInt32(); }
+            else if (reader.ValueTextEquals("time_to_impact"u8)) { reader.Read(); alert.TimeToImpact = reader.GetDouble(); }
+            else if (reader.ValueTextEquals("distance"u8)) { reader.Read(); alert.Distance = reader.GetDouble(); }
+            else if (reader.ValueTextEquals("probability"u8)) { reader.Read(); alert.Probability = reader.GetDouble(); }
+            else if (reader.ValueTextEquals("cpa"u8))
+            {
+                var cpa = new Position();
+                Expect(ref reader, JsonTokenType.StartObject);
+                while (reader.Read() && reader.TokenType == JsonTokenType.PropertyName)
+                {
+                    if (reader.ValueTextEquals("latitude"u8)) { reader.Read(); cpa.Latitude = reader.GetDouble(); }
+                    else if (reader.ValueTextEquals("longitude"u8)) { reader.Read(); cpa.Longitude = reader.GetDouble(); }
+                    else { reader.Read(); reader.Skip(); }
+                }
+                alert.Cpa = cpa;
+            }
+            else if (reader.ValueTextEquals("timestamp"u8)) { reader.Read(); alert.Timestamp = reader.GetInt64(); }
+            else { reader.Read(); reader.Skip(); }
+        }
+
+        return alert;
+    }
+
+    // ID interned: sem alocar depois da primeira ocorrencia
+    private string ReadId(ref Utf8JsonReader reader)
+    {
+        if (reader.TokenType != JsonTokenType.String)
+            throw new JsonException("Expected string id");
+
+        if (!reader.HasValueSequence && !reader.ValueIsEscaped)
+            return _ids.Get(reader.ValueSpan);
+
+        long rawLength = reader.HasValueSequence ? reader.ValueSequence.Length : reader.ValueSpan.Length;
+        if (rawLength > MaxIdLength)
+            throw new JsonException("Vehicle id too long");
+
+        Span<byte> buffer = stackalloc byte[MaxIdLength];
+        int length = reader.CopyString(buffer);
+        return _ids.Get(buffer[..length]);
+    }
+
+    private static void Expect(ref Utf8JsonReader reader, JsonTokenType type)
+    {
+        if (!reader.Read() || reader.TokenType != type)
+            throw new JsonException($"Expected {type}");
+    }
+}
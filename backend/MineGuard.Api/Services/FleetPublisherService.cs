@@ -0,0 +1,58 @@
+namespace MineGuard.Api.Services;
+
+// ============================================================
+// Publicacao periodica do estado da frota
+//
+// A ingestao so marca o que mudou. Este loop e o unico que
+// reconstroi o snapshot da API e monta o delta do stream, no maximo
+// uma vez por PublishInterval: varios frames no intervalo viram uma
+// publicacao e o custo de serializar sai do caminho de ingestao.
+// ============================================================
+
+public class FleetPublisherService : BackgroundService
+{
+    public static readonly TimeSpan PublishInterval = TimeSpan.FromMilliseconds(100);
+
+    private readonly FleetStateService _fleetState;
+    private readonly FleetStreamHub _stream;
+    private readonly ILogger<FleetPublisherService> _logger;
+
+    public FleetPublisherService(FleetStateService fleetState, FleetStreamHub stream,
+                                 ILogger<FleetPublisherService> logger)
+    {
+        _fleetState = fleetState;
+        _stream = stream;
+        _logger = logger;
+    }
+
+    protected override async Task ExecuteAsync(CancellationToken stoppingToken)
+    {
+        using var timer = new PeriodicTimer(PublishInterval);
+        try
+        {
+            while (await timer.WaitForNextTickAsync(stoppingToken))
+            {
+                try
+                {
+                    _fleetState.PublishSnapshot();
+                }
+                catch (Exception ex)
+                {
+                    _logger.LogError(ex, "[PUBLISH] Failed to publish fleet snapshot");
+                }
+
+                try
+                {
+                    _stream.PublishDelta();
+                }
+                catch (Exception ex)
+                {
+                    _logger.LogError(ex, "[PUBLISH] Failed to publish stream delta");
+                }
+            }
+        }
+        catch (OperationCanceledException)
+        {
+        }
+    }
+}
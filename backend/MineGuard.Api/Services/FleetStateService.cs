@@ -1,86 +1,382 @@
+using System.Buffers;
 using System.Collections.Concurrent;
+using System.Text.Json;
 using MineGuard.Api.Models;
 
 namespace MineGuard.Api.Services;
 
 public class FleetStateService
 {
-    private readonly ConcurrentDictionary<string, Vehicle> _vehicles = new();
-    private readonly ConcurrentBag<CollisionAlert> _activeAlerts = new();
-    private readonly ConcurrentBag<CollisionAlert> _alertHistory = new();
+    // Fonte usada por clientes que nao fazem handshake (simulador antigo)
+    public const string DefaultSourceId = "default";
+
+    // Sem frame ha mais que isso a fonte conectada aparece como STALE
+    private const long StaleAfterMs = 5000;
+
+    private readonly ConcurrentDictionary<string, SourcePartition> _sources = new();
     private readonly DateTime _startTime = DateTime.UtcNow;
+    private readonly LatencyTracker _latency;
+    private readonly AlertHistoryStore _history;
+    private readonly object _snapshotLock = new();
+
+    // Mesmo formato das respostas dos controllers (camelCase)
+    private static readonly JsonSerializerOptions SnapshotJsonOptions = new(JsonSerializerDefaults.Web);
 
-    private long _lastTelemetryTimestamp;
+    private FleetSnapshot _snapshot = FleetSnapshot.Empty;
+
+    // Buffers do publicador (so usados sob _snapshotLock)
+    private readonly Utf8JsonWriter _snapshotWriter = new(new ArrayBufferWriter<byte>());
+    private readonly ArrayBufferWriter<byte> _joinBuffer = new();
+    private long _nextSessionId;
     private int _totalAlertsReceived;
-    private bool _simulatorConnected;
 
-    public void UpdateVehicle(TelemetryPacket packet)
+    public FleetStateService(LatencyTracker latency, AlertHistoryStore history)
     {
-        var vehicle = new Vehicle
-        {
-            Id = packet.VehicleId,
-            VehicleType = packet.VehicleType,
-            CycleState = packet.CycleState,
-            Position = packet.Position,
-            Telemetry = packet.Telemetry,
-            LastUpdate = packet.Timestamp,
-            Online = true
-        };
+        _latency = latency;
+        _history = history;
+    }
+
+    // ============================================================
+    // Sessoes de ingestao
+    // ============================================================
+
+    // Abre sessao pra fonte; reconexao da mesma fonte reaproveita a particao
+    public SourcePartition OpenSession(string sourceId, string remoteEndpoint)
+    {
+        var source = _sources.GetOrAdd(sourceId, id => new SourcePartition(id));
+
+        Interlocked.Exchange(ref source.SessionId, Interlocked.Increment(ref _nextSessionId));
+        source.RemoteEndpoint = remoteEndpoint;
+        Interlocked.Exchange(ref source.ConnectedAt, DateTimeOffset.UtcNow.ToUnixTimeMilliseconds());
+        Interlocked.Increment(ref source.TotalSessions);
+        Interlocked.Increment(ref source.OpenSessions);
+        Volatile.Write(ref source.StreamDirty, 1);
 
-        _vehicles.AddOrUpdate(packet.VehicleId, vehicle, (_, _) => vehicle);
-        _lastTelemetryTimestamp = packet.Timestamp;
+        return source;
     }
 
-    public void UpdateAlerts(List<CollisionAlert> alerts)
+    public void CloseSession(SourcePartition source)
     {
-        // Limpa alertas ativos e substitui pelos novos
-        while (_activeAlerts.TryTake(out _)) { }
+        Interlocked.Decrement(ref source.OpenSessions);
+        Volatile.Write(ref source.StreamDirty, 1);
+    }
 
-        foreach (var alert in alerts)
+    internal ICollection<SourcePartition> Sources => _sources.Values;
+
+    public void UpdateAlerts(SourcePartition source, IReadOnlyList<CollisionAlert> alerts)
+    {
+        // Substitui os alertas ativos de uma vez (leitores nunca veem lista pela metade)
+        var active = alerts.Count == 0 ? Array.Empty<CollisionAlert>() : new CollisionAlert[alerts.Count];
+        for (int i = 0; i < alerts.Count; i++)
         {
-            _activeAlerts.Add(alert);
-            _alertHistory.Add(alert);
-            Interlocked.Increment(ref _totalAlertsReceived);
+            active[i] = alerts[i];
+            _history.Append(alerts[i]);
+        }
+
+        Interlocked.Add(ref _totalAlertsReceived, alerts.Count);
+        Volatile.Write(ref source.ActiveAlerts, active);
+    }
+
+    // ============================================================
+    // Snapshot publicado fora da ingestao
+    //
+    // A ingestao so marca a fonte como suja no fim do frame. O
+    // publicador (FleetPublisherService) chama PublishSnapshot a cada
+    // intervalo: reserializa so as fontes sujas e junta o JSON de todas
+    // num snapshot imutavel. Os controllers so
+    // copiam esses bytes, independente de quantos clientes consultam.
+    // ============================================================
+
+    public FleetSnapshot CurrentSnapshot => Volatile.Read(ref _snapshot);
+
+    // Chamado pelo publicador; nao faz nada se nenhuma fonte mudou.
+    // Serializa direto dos veiculos vivos (sob o lock de cada um) em
+    // buffers reaproveitados: so aloca o corpo novo quando os bytes mudam.
+    public void PublishSnapshot()
+    {
+        lock (_snapshotLock)
+        {
+            bool changed = false;
+            long oldestGenerated = long.MaxValue;
+            foreach (var source in _sources.Values)
+            {
+                if (Interlocked.Exchange(ref source.SnapshotDirty, 0) == 0) continue;
+
+                // Frame aplicado entre as duas trocas entra agora (ou no
+                // proximo ciclo) mas o tempo dele conta nesta publicacao
+                long generated = Interlocked.Exchange(ref source.UnpublishedSince, 0);
+                if (generated > 0) oldestGenerated = Math.Min(oldestGenerated, generated);
+
+                StartArray(source.VehiclesJson);
+                foreach (var vehicle in source.Vehicles.Values)
+                {
+                    lock (vehicle)
+                    {
+                        WriteVehicle(_snapshotWriter, vehicle);
+                    }
+                }
+                EndArray();
+
+                StartArray(source.AlertsJson);
+                foreach (var alert in Volatile.Read(ref source.ActiveAlerts))
+                {
+                    JsonSerializer.Serialize(_snapshotWriter, alert, SnapshotJsonOptions);
+                }
+                EndArray();
+
+                changed = true;
+            }
+            if (!changed) return;
+
+            var previous = _snapshot;
+            long version = previous.Version + 1;
+
+            var vehicles = NextEntry(previous.Vehicles, version, JoinArrays(s => s.VehiclesJson));
+            var alerts = NextEntry(previous.Alerts, version, JoinArrays(s => s.AlertsJson));
+
+            Volatile.Write(ref _snapshot, new FleetSnapshot(version, vehicles, alerts));
+
+            if (oldestGenerated != long.MaxValue)
+                _latency.RecordVisible(oldestGenerated, DateTimeOffset.UtcNow.ToUnixTimeMilliseconds());
         }
     }
 
-    public void SetSimulatorConnected(bool connected)
+    private void StartArray(ArrayBufferWriter<byte> buffer)
+    {
+        buffer.ResetWrittenCount();
+        _snapshotWriter.Reset(buffer);
+        _snapshotWriter.WriteStartArray();
+    }
+
+    private void EndArray()
     {
-        _simulatorConnected = connected;
+        _snapshotWriter.WriteEndArray();
+        _snapshotWriter.Flush();
     }
 
+    // Mesmo JSON que JsonSerializer gera pro Vehicle (nomes e ordem das
+    // propriedades), escrito a mao: o serializer aloca ~300 B por objeto
+    // com filhos aninhados, e aqui e um objeto por veiculo a cada publicacao.
+    // Position e Telemetry nao tem filhos e saem pelo serializer sem alocar.
+    // Propriedade nova no Vehicle precisa entrar aqui tambem.
+    private static readonly JsonEncodedText IdName = JsonEncodedText.Encode("id");
+    private static readonly JsonEncodedText VehicleTypeName = JsonEncodedText.Encode("vehicleType");
+    private static readonly JsonEncodedText CycleStateName = JsonEncodedText.Encode("cycleState");
+    private static readonly JsonEncodedText PositionName = JsonEncodedText.Encode("position");
+    private static readonly JsonEncodedText TelemetryName = JsonEncodedText.Encode("telemetry");
+    private static readonly JsonEncodedText LastUpdateName = JsonEncodedText.Encode("lastUpdate");
+    private static readonly JsonEncodedText OnlineName = JsonEncodedText.Encode("online");
+    private static readonly JsonEncodedText VehicleTypeNameName = JsonEncodedText.Encode("vehicleTypeName");
+    private static readonly JsonEncodedText CycleStateNameName = JsonEncodedText.Encode("cycleStateName");
+
+    private static void WriteVehicle(Utf8JsonWriter writer, Vehicle vehicle)
+    {
+        writer.WriteStartObject();
+        writer.WriteString(IdName, vehicle.Id);
+        writer.WriteNumber(VehicleTypeName, vehicle.VehicleType);
+        writer.WriteNumber(CycleStateName, vehicle.CycleState);
+        writer.WritePropertyName(PositionName);
+        JsonSerializer.Serialize(writer, vehicle.Position, SnapshotJsonOptions);
+        writer.WritePropertyName(TelemetryName);
+        JsonSerializer.Serialize(writer, vehicle.Telemetry, SnapshotJsonOptions);
+        writer.WriteNumber(LastUpdateName, vehicle.LastUpdate);
+        writer.WriteBoolean(OnlineName, vehicle.Online);
+        writer.WriteString(VehicleTypeNameName, vehicle.VehicleTypeName);
+        writer.WriteString(CycleStateNameName, vehicle.CycleStateName);
+        writer.WriteEndObject();
+    }
+
+    private static SnapshotEntry NextEntry(SnapshotEntry previous, long version, ReadOnlySpan<byte> json)
+    {
+        // Conteudo igual mantem a versao (e o ETag) anterior
+        return previous.Json.AsSpan().SequenceEqual(json) ? previous : new SnapshotEntry(version, json.ToArray());
+    }
+
+    // Junta os arrays das fontes num so (tira os colchetes de cada um)
+    private ReadOnlySpan<byte> JoinArrays(Func<SourcePartition, ArrayBufferWriter<byte>> json)
+    {
+        _joinBuffer.ResetWrittenCount();
+        _joinBuffer.Write("["u8);
+        bool first = true;
+        foreach (var source in _sources.Values)
+        {
+            var array = json(source).WrittenSpan;
+            if (array.Length <= 2) continue;
+            if (!first) _joinBuffer.Write(","u8);
+            _joinBuffer.Write(array[1..^1]);
+            first = false;
+        }
+        _joinBuffer.Write("]"u8);
+        return _joinBuffer.WrittenSpan;
+    }
+
+    // ============================================================
+    // Visao combinada de todas as fontes
+    // ============================================================
+
+    // Leitura: copia sob lock pra nao pegar um veiculo no meio da atualizacao
     public List<Vehicle> GetAllVehicles()
     {
-        return _vehicles.Values.ToList();
+        var result = new List<Vehicle>();
+        foreach (var source in _sources.Values)
+        {
+            CloneVehicles(source, result);
+        }
+        return result;
+    }
+
+    private static void CloneVehicles(SourcePartition source, List<Vehicle> result)
+    {
+        foreach (var vehicle in source.Vehicles.Values)
+        {
+            lock (vehicle)
+            {
+                result.Add(vehicle.Clone());
+            }
+        }
     }
 
     public Vehicle? GetVehicle(string id)
     {
-        _vehicles.TryGetValue(id, out var vehicle);
-        return vehicle;
+        foreach (var source in _sources.Values)
+        {
+            if (!source.Vehicles.TryGetValue(id, out var vehicle)) continue;
+
+            lock (vehicle)
+            {
+                return vehicle.Clone();
+            }
+        }
+        return null;
+    }
+
+    // Ultimos window do rastro, a partir da amostra mais recente
+    public VehicleTrailSnapshot? GetVehicleTrail(string id, TimeSpan window)
+    {
+        foreach (var source in _sources.Values)
+        {
+            if (!source.Vehicles.TryGetValue(id, out var vehicle)) continue;
+            if (!source.Trails.TryGetValue(id, out var trail)) continue;
+
+            lock (vehicle)
+            {
+                return trail.Read(id, window);
+            }
+        }
+        return null;
     }
 
     public List<CollisionAlert> GetActiveAlerts()
     {
-        return _activeAlerts.ToList();
+        var result = new List<CollisionAlert>();
+        foreach (var source in _sources.Values)
+        {
+            result.AddRange(Volatile.Read(ref source.ActiveAlerts));
+        }
+        return result;
     }
 
-    public List<CollisionAlert> GetAlertHistory()
+    // Cada fonte tem a propria grade: sem sourceId, o tile da primeira
+    // fonte (ordem do ID) que ja publicou um
+    public SnapshotEntry? GetHeatmap(string? sourceId)
     {
-        return _alertHistory.ToList();
+        return GetSourceSnapshot(sourceId, source => Volatile.Read(ref source.Heatmap));
+    }
+
+    // KPIs sao por frota (fonte); mesma regra do mapa de calor
+    public SnapshotEntry? GetKpi(string? sourceId)
+    {
+        return GetSourceSnapshot(sourceId, source => Volatile.Read(ref source.Kpi));
+    }
+
+    private SnapshotEntry? GetSourceSnapshot(string? sourceId, Func<SourcePartition, SnapshotEntry?> read)
+    {
+        if (sourceId != null)
+        {
+            return _sources.TryGetValue(sourceId, out var source) ? read(source) : null;
+        }
+
+        SnapshotEntry? result = null;
+        string? resultSource = null;
+        foreach (var source in _sources.Values)
+        {
+            var entry = read(source);
+            if (entry == null) continue;
+            if (resultSource == null || string.CompareOrdinal(source.SourceId, resultSource) < 0)
+            {
+                result = entry;
+                resultSource = source.SourceId;
+            }
+        }
+        return result;
+    }
+
+    public AlertHistoryPage GetAlertHistory(AlertHistoryQuery query)
+    {
+        return _history.Query(query);
+    }
+
+    public List<SourceStatus> GetSources()
+    {
+        long now = DateTimeOffset.UtcNow.ToUnixTimeMilliseconds();
+        var result = new List<SourceStatus>(_sources.Count);
+
+        foreach (var source in _sources.Values)
+        {
+            long lastFrameAt = Volatile.Read(ref source.LastFrameAt);
+            string health = !source.Connected ? "OFFLINE"
+                : now - lastFrameAt > StaleAfterMs ? "STALE"
+                : "ONLINE";
+
+            result.Add(new SourceStatus
+            {
+                SourceId = source.SourceId,
+                SessionId = Interlocked.Read(ref source.SessionId),
+                Connected = source.Connected,
+                Health = health,
+                RemoteEndpoint = source.RemoteEndpoint,
+                ConnectedAt = Interlocked.Read(ref source.ConnectedAt),
+                LastFrameAt = lastFrameAt,
+                LastTickId = Volatile.Read(ref source.LastTickId),
+                Sessions = Volatile.Read(ref source.TotalSessions),
+                Vehicles = source.Vehicles.Count,
+                ActiveAlerts = Volatile.Read(ref source.ActiveAlerts).Length,
+                FramesReceived = Interlocked.Read(ref source.FramesReceived),
+                TelemetryReceived = Interlocked.Read(ref source.TelemetryReceived),
+                AlertsReceived = Interlocked.Read(ref source.AlertsReceived),
+                ParseErrors = Interlocked.Read(ref source.ParseErrors)
+            });
+        }
+
+        return result.OrderBy(s => s.SourceId, StringComparer.Ordinal).ToList();
     }
 
     public SystemStatus GetStatus()
     {
-        return new SystemStatus
+        var status = new SystemStatus
         {
-            SimulatorConnected = _simulatorConnected,
-            TotalVehicles = _vehicles.Count,
-            OnlineVehicles = _vehicles.Values.Count(v => v.Online),
-            ActiveAlerts = _activeAlerts.Count,
             TotalAlertsReceived = _totalAlertsReceived,
             UptimeSeconds = (long)(DateTime.UtcNow - _startTime).TotalSeconds,
-            LastTelemetryTimestamp = _lastTelemetryTimestamp
+            Latency = _latency.GetLatency(),
+            Gc = GcStats.Capture()
         };
+
+        foreach (var source in _sources.Values)
+        {
+            if (source.Connected)
+            {
+                status.SimulatorConnected = true;
+                status.ConnectedSources++;
+            }
+
+            status.TotalVehicles += source.Vehicles.Count;
+            status.OnlineVehicles += Volatile.Read(ref source.OnlineVehicles);
+            status.ActiveAlerts += Volatile.Read(ref source.ActiveAlerts).Length;
+            status.LastTelemetryTimestamp = Math.Max(status.LastTelemetryTimestamp,
+                Volatile.Read(ref source.LastTelemetryTimestamp));
+            status.LastTickId = Math.Max(status.LastTickId, Volatile.Read(ref source.LastTickId));
+        }
+
+        return status;
     }
 }
@@ -0,0 +1,226 @@
+using System.Buffers;
+using System.Text;
+using System.Text.Json;
+using System.Threading.Channels;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// ============================================================
+// Push do estado da frota pro dashboard (Server-Sent Events)
+//
+// A ingestao so enfileira os veiculos que mudaram (cada um uma vez
+// por delta) e marca a fonte. O publicador chama PublishDelta uma vez
+// por intervalo: o hub drena as filas, monta UM delta (veiculos que
+// mudaram, alertas se mudaram, status) ja serializado em UTF-8 e
+// entrega o mesmo buffer pra todos os assinantes. Custo por delta
+// cresce com as mudancas, nao com frames x frota nem clientes x frota.
+//
+// Cada assinante tem uma fila limitada. Cliente lento que enche a
+// fila perde os deltas pendentes e recebe um snapshot completo.
+// ============================================================
+
+public sealed class FleetStreamHub
+{
+    public const int SubscriberQueueCapacity = 16;
+
+    private static readonly JsonSerializerOptions JsonOptions = new(JsonSerializerDefaults.Web);
+    private static readonly byte[] SnapshotPrefix = Encoding.UTF8.GetBytes("event: snapshot\ndata: ");
+    private static readonly byte[] DeltaPrefix = Encoding.UTF8.GetBytes("event: delta\ndata: ");
+    private static readonly byte[] EventSuffix = Encoding.UTF8.GetBytes("\n\n");
+
+    // Campos que o dashboard mostra; mudou qualquer um, vai no delta
+    private readonly record struct VehicleSignature(
+        int VehicleType, int CycleState,
+        double Latitude, double Longitude,
+        double Speed, double Heading,
+        double Payload, double FuelLevel, double EngineRpm,
+        bool Online)
+    {
+        public static VehicleSignature From(Vehicle v) => new(
+            v.VehicleType, v.CycleState,
+            v.Position.Latitude, v.Position.Longitude,
+            v.Telemetry.Speed, v.Telemetry.Heading,
+            v.Telemetry.Payload, v.Telemetry.FuelLevel, v.Telemetry.EngineRpm,
+            v.Online);
+    }
+
+    public sealed class Subscription
+    {
+        internal readonly Channel<byte[]> Queue = Channel.CreateBounded<byte[]>(
+            new BoundedChannelOptions(SubscriberQueueCapacity)
+            {
+                SingleReader = true,
+                SingleWriter = true,
+                FullMode = BoundedChannelFullMode.Wait
+            });
+
+        // Fila estourou: deltas descartados, proximo envio e snapshot
+        internal volatile bool NeedsResync;
+
+        public ChannelReader<byte[]> Reader => Queue.Reader;
+    }
+
+    private readonly FleetStateService _fleetState;
+    private readonly ILogger<FleetStreamHub> _logger;
+
+    // Publicacao, inscricao e resync sao serializados por este lock pra
+    // que nenhum delta chegue ao cliente antes do snapshot que o precede
+    private readonly object _publishLock = new();
+    private readonly List<Subscription> _subscribers = new();
+    private readonly Dictionary<string, VehicleSignature> _lastSent = new();
+    private List<CollisionAlert> _lastAlerts = new();
+    private long _version;
+
+    public FleetStreamHub(FleetStateService fleetState, ILogger<FleetStreamHub> logger)
+    {
+        _fleetState = fleetState;
+        _logger = logger;
+    }
+
+    public int SubscriberCount
+    {
+        get { lock (_publishLock) return _subscribers.Count; }
+    }
+
+    // Registra o cliente e devolve o snapshot inicial ja serializado
+    public Subscription Subscribe(out byte[] snapshot)
+    {
+        var sub = new Subscription();
+        lock (_publishLock)
+        {
+            snapshot = BuildSnapshot();
+            _subscribers.Add(sub);
+        }
+        return sub;
+    }
+
+    public void Unsubscribe(Subscription sub)
+    {
+        lock (_publishLock)
+        {
+            _subscribers.Remove(sub);
+        }
+        sub.Queue.Writer.TryComplete();
+    }
+
+    // Descarta deltas pendentes e gera snapshot novo pro cliente lento
+    public byte[] Resync(Subscription sub)
+    {
+        lock (_publishLock)
+        {
+            while (sub.Queue.Reader.TryRead(out _)) { }
+            sub.NeedsResync = false;
+            return BuildSnapshot();
+        }
+    }
+
+    // Chamado pelo publicador a cada intervalo (nunca pela ingestao)
+    public void PublishDelta()
+    {
+        lock (_publishLock)
+        {
+            bool sourcesChanged = false;
+            var changed = new List<Vehicle>();
+            foreach (var source in _fleetState.Sources)
+            {
+                if (Interlocked.Exchange(ref source.StreamDirty, 0) != 0) sourcesChanged = true;
+
+                while (source.ChangedVehicles.TryDequeue(out var vehicle))
+                {
+                    // Liberado antes da copia: mudanca depois disso volta pra fila
+                    Volatile.Write(ref vehicle.StreamQueued, 0);
+
+                    // Sem assinantes so a base do delta anda: nada de copia
+                    lock (vehicle)
+                    {
+                        var sig = VehicleSignature.From(vehicle);
+                        if (!_lastSent.TryGetValue(vehicle.Id, out var last) || last != sig)
+                        {
+                            _lastSent[vehicle.Id] = sig;
+                            if (_subscribers.Count > 0) changed.Add(vehicle.Clone());
+                        }
+                    }
+                }
+            }
+            if (!sourcesChanged && changed.Count == 0) return;
+
+            _version++;
+
+            // Alertas e status so mudam com frame ou sessao novos
+            bool alertsChanged = false;
+            var alerts = _lastAlerts;
+            if (sourcesChanged)
+            {
+                alerts = _fleetState.GetActiveAlerts();
+                alertsChanged = !SameAlerts(alerts, _lastAlerts);
+                if (alertsChanged) _lastAlerts = alerts;
+            }
+
+            // Sem ninguem ouvindo, so mantem a base do delta em dia
+            if (_subscribers.Count == 0) return;
+
+            var message = Serialize(DeltaPrefix, new
+            {
+                version = _version,
+                vehicles = changed,
+                alerts = alertsChanged ? alerts : null,
+                status = _fleetState.GetStatus()
+            });
+
+            foreach (var sub in _subscribers)
+            {
+                if (sub.NeedsResync) continue;
+
+                if (!sub.Queue.Writer.TryWrite(message))
+                {
+                    sub.NeedsResync = true;
+                    _logger.LogDebug("[STREAM] Subscriber queue full, scheduling resync");
+                }
+            }
+        }
+    }
+
+    private byte[] BuildSnapshot()
+    {
+        return Serialize(SnapshotPrefix, new
+        {
+            version = _version,
+            vehicles = _fleetState.GetAllVehicles(),
+            alerts = _fleetState.GetActiveAlerts(),
+            status = _fleetState.GetStatus()
+        });
+    }
+
+    // Monta o evento SSE inteiro: "event: ...\ndata: <json>\n\n"
+    private static byte[] Serialize(byte[] prefix, object payload)
+    {
+        var buffer = new ArrayBufferWriter<byte>(4096);
+        buffer.Write(prefix);
+        using (var writer = new Utf8JsonWriter(buffer))
+        {
+            JsonSerializer.Serialize(writer, payload, JsonOptions);
+        }
+        buffer.Write(EventSuffix);
+        return buffer.WrittenSpan.ToArray();
+    }
+
+    private static bool SameAlerts(List<CollisionAlert> a, List<CollisionAlert> b)
+    {
+        if (a.Count != b.Count) return false;
+        for (int i = 0; i < a.Count; i++)
+        {
+            var x = a[i];
+            var y = b[i];
+            if (x.VehicleId1 != y.VehicleId1 || x.VehicleId2 != y.VehicleId2 ||
+                x.Priority != y.Priority || x.AlertType != y.AlertType ||
+                x.TimeToImpact != y.TimeToImpact || x.Distance != y.Distance ||
+                x.Probability != y.Probability ||
+                x.Cpa?.Latitude != y.Cpa?.Latitude || x.Cpa?.Longitude != y.Cpa?.Longitude)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,82 @@
+using System.Numerics;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// Histograma log-linear de latencias em microssegundos.
+// Valores < 64us sao exatos; acima disso cada potencia de 2 tem 32
+// sub-buckets (~3% de erro). Record e lock-free e nao aloca.
+public class LatencyHistogram
+{
+    private const int SubBucketBits = 5;
+    private const int SubBucketCount = 1 << SubBucketBits;
+    private const int BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    private readonly long[] _counts = new long[BucketCount];
+    private long _total;
+    private long _max;
+
+    public void Record(long valueUs)
+    {
+        if (valueUs < 0) valueUs = 0; // relogios fora de sincronia
+
+        Interlocked.Increment(ref _counts[IndexOf(valueUs)]);
+        Interlocked.Increment(ref _total);
+
+        long currentMax = Interlocked.Read(ref _max);
+        while (valueUs > currentMax)
+        {
+            long previous = Interlocked.CompareExchange(ref _max, valueUs, currentMax);
+            if (previous == currentMax) break;
+            currentMax = previous;
+        }
+    }
+
+    public LatencyStats GetStats()
+    {
+        long total = Interlocked.Read(ref _total);
+        long max = Interlocked.Read(ref _max);
+
+        return new LatencyStats
+        {
+            Count = total,
+            P50Ms = Percentile(0.50, total, max) / 1000.0,
+            P99Ms = Percentile(0.99, total, max) / 1000.0,
+            MaxMs = max / 1000.0
+        };
+    }
+
+    private long Percentile(double p, long total, long max)
+    {
+        if (total == 0) return 0;
+
+        long target = (long)Math.Ceiling(p * total);
+        long cumulative = 0;
+
+        for (int i = 0; i < BucketCount; i++)
+        {
+            cumulative += Interlocked.Read(ref _counts[i]);
+            if (cumulative >= target)
+                return Math.Min(UpperBound(i), max);
+        }
+        return max;
+    }
+
+    private static int IndexOf(long value)
+    {
+        if (value < 2 * SubBucketCount) return (int)value;
+
+        int msb = 63 - BitOperations.LeadingZeroCount((ulong)value);
+        int shift = msb - SubBucketBits;
+        return shift * SubBucketCount + (int)(value >> shift);
+    }
+
+    private static long UpperBound(int index)
+    {
+        if (index < 2 * SubBucketCount) return index;
+
+        int shift = index / SubBucketCount - 1;
+        long sub = index - shift * SubBucketCount;
+        return ((sub + 1) << shift) - 1;
+    }
+}
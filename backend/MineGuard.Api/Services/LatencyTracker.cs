@@ -0,0 +1,58 @@
+using System.Diagnostics;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// Mede a idade dos dados em cada etapa do pipeline de ingestao
+public class LatencyTracker
+{
+    private readonly LatencyHistogram _tickToSend = new();
+    private readonly LatencyHistogram _network = new();
+    private readonly LatencyHistogram _parse = new();
+    private readonly LatencyHistogram _apply = new();
+    private readonly LatencyHistogram _endToEnd = new();
+    private readonly LatencyHistogram _visible = new();
+
+    // generatedAt/sentAt/receivedAt/appliedAt: epoch ms (relogio de parede)
+    // receivedTicks/parsedTicks/appliedTicks: Stopwatch.GetTimestamp() local
+    public void RecordFrame(
+        long generatedAt, long sentAt, long receivedAt, long appliedAt,
+        long receivedTicks, long parsedTicks, long appliedTicks)
+    {
+        if (generatedAt > 0 && sentAt > 0)
+            _tickToSend.Record((sentAt - generatedAt) * 1000);
+
+        if (sentAt > 0)
+            _network.Record((receivedAt - sentAt) * 1000);
+
+        _parse.Record(TicksToMicroseconds(parsedTicks - receivedTicks));
+        _apply.Record(TicksToMicroseconds(appliedTicks - parsedTicks));
+
+        if (generatedAt > 0)
+            _endToEnd.Record((appliedAt - generatedAt) * 1000);
+    }
+
+    // Snapshot da API publicado: generatedAt/publishedAt em epoch ms
+    public void RecordVisible(long generatedAt, long publishedAt)
+    {
+        _visible.Record((publishedAt - generatedAt) * 1000);
+    }
+
+    public PipelineLatency GetLatency()
+    {
+        return new PipelineLatency
+        {
+            TickToSend = _tickToSend.GetStats(),
+            Network = _network.GetStats(),
+            Parse = _parse.GetStats(),
+            Apply = _apply.GetStats(),
+            EndToEnd = _endToEnd.GetStats(),
+            Visible = _visible.GetStats()
+        };
+    }
+
+    private static long TicksToMicroseconds(long ticks)
+    {
+        return ticks * 1_000_000 / Stopwatch.Frequency;
+    }
+}
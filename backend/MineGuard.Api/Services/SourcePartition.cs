@@ -0,0 +1,147 @@
+using System.Buffers;
+using System.Collections.Concurrent;
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// ============================================================
+// Particao do estado da frota por fonte (gateway/simulador)
+//
+// Cada conexao de ingestao escreve so na particao da sua fonte,
+// entao cavas diferentes nao disputam o mesmo dicionario nem os
+// mesmos contadores. A API le a visao combinada de todas.
+// ============================================================
+
+public sealed class SourcePartition
+{
+    private static int _nextOrdinal;
+
+    public string SourceId { get; }
+
+    // Escopo dos ETags da fonte: o ID vem do cliente e pode ter
+    // caracteres que nao cabem num ETag, entao vai um numero unico
+    // no processo
+    internal readonly string ETagScope = $"s{Interlocked.Increment(ref _nextOrdinal)}";
+
+    internal readonly ConcurrentDictionary<string, Vehicle> Vehicles = new();
+
+    // Rastro por veiculo (mesmo lock do Vehicle)
+    internal readonly ConcurrentDictionary<string, VehicleTrail> Trails = new();
+    internal CollisionAlert[] ActiveAlerts = Array.Empty<CollisionAlert>();
+
+    // Ultimo tile do mapa de calor de quase-colisoes (null = nunca recebeu)
+    internal SnapshotEntry? Heatmap;
+    private long _heatmapVersion;
+
+    // Ultimo frame de KPIs de producao (null = nunca recebeu)
+    internal SnapshotEntry? Kpi;
+    private long _kpiVersion;
+
+    // Snapshot da API: a ingestao so marca a fonte como suja e o
+    // publicador reserializa o JSON dela nesses buffers reaproveitados
+    internal int SnapshotDirty;
+
+    // Geracao (epoch ms) do pacote mais antigo aplicado desde a ultima
+    // publicacao (0 = nenhum), pra medir a visibilidade na API
+    internal long UnpublishedSince;
+    internal readonly ArrayBufferWriter<byte> VehiclesJson = new();
+    internal readonly ArrayBufferWriter<byte> AlertsJson = new();
+
+    // Stream do dashboard: veiculos que mudaram desde o ultimo delta
+    // (cada um entra uma vez, ver Vehicle.StreamQueued) e marca de
+    // frame/sessao novos pra alertas e status
+    internal readonly ConcurrentQueue<Vehicle> ChangedVehicles = new();
+    internal int StreamDirty;
+    internal int OnlineVehicles;
+
+    // Sessao atual (ultima conexao aceita pra esta fonte)
+    internal long SessionId;
+    internal string RemoteEndpoint = string.Empty;
+    internal long ConnectedAt;
+    internal int OpenSessions;
+    internal int TotalSessions;
+
+    // Estatisticas de ingestao
+    internal long FramesReceived;
+    internal long TelemetryReceived;
+    internal long AlertsReceived;
+    internal long ParseErrors;
+    internal long LastFrameAt;
+    internal long LastTickId;
+    internal long LastTelemetryTimestamp;
+
+    public SourcePartition(string sourceId)
+    {
+        SourceId = sourceId;
+    }
+
+    public bool Connected => Volatile.Read(ref OpenSessions) > 0;
+
+    // Caminho de ingestao: atualiza o veiculo e o rastro no lugar. So
+    // aloca na primeira vez que um ID aparece.
+    public void UpdateVehicle(in TelemetryFrame frame)
+    {
+        if (!Vehicles.TryGetValue(frame.VehicleId, out var vehicle))
+        {
+            vehicle = Vehicles.GetOrAdd(frame.VehicleId, id => new Vehicle { Id = id });
+        }
+        if (!Trails.TryGetValue(frame.VehicleId, out var trail))
+        {
+            trail = Trails.GetOrAdd(frame.VehicleId, _ => new VehicleTrail());
+        }
+
+        lock (vehicle)
+        {
+            if (!vehicle.Online) Interlocked.Increment(ref OnlineVehicles);
+            vehicle.Apply(in frame);
+            trail.Append(frame.Timestamp, frame.Latitude, frame.Longitude);
+        }
+
+        if (Volatile.Read(ref vehicle.StreamQueued) == 0 && Interlocked.Exchange(ref vehicle.StreamQueued, 1) == 0)
+        {
+            ChangedVehicles.Enqueue(vehicle);
+        }
+
+        Volatile.Write(ref LastTelemetryTimestamp, frame.Timestamp);
+    }
+
+    // Tile novo substitui o anterior inteiro; leitores pegam um ou outro
+    public void UpdateHeatmap(byte[] json)
+    {
+        Volatile.Write(ref Heatmap, new SnapshotEntry(Interlocked.Increment(ref _heatmapVersion), json, ETagScope));
+    }
+
+    public void UpdateKpi(byte[] json)
+    {
+        Volatile.Write(ref Kpi, new SnapshotEntry(Interlocked.Increment(ref _kpiVersion), json, ETagScope));
+    }
+
+    // Fim de um frame aplicado com sucesso
+    public void RecordFrame(in BatchFrameInfo info, long receivedAt)
+    {
+        Interlocked.Increment(ref FramesReceived);
+        Interlocked.Add(ref TelemetryReceived, info.TelemetryCount);
+        Interlocked.Add(ref AlertsReceived, info.AlertCount);
+        Volatile.Write(ref LastTickId, info.TickId);
+        Volatile.Write(ref LastFrameAt, receivedAt);
+
+        // Antes da marca de sujo: o publicador que ver a marca ve o tempo
+        if (info.OldestTimestamp > 0)
+        {
+            long current = Volatile.Read(ref UnpublishedSince);
+            while (current == 0 || info.OldestTimestamp < current)
+            {
+                long seen = Interlocked.CompareExchange(ref UnpublishedSince, info.OldestTimestamp, current);
+                if (seen == current) break;
+                current = seen;
+            }
+        }
+        Volatile.Write(ref SnapshotDirty, 1);
+        Volatile.Write(ref StreamDirty, 1);
+    }
+
+    public void RecordParseError()
+    {
+        Interlocked.Increment(ref ParseErrors);
+    }
+}
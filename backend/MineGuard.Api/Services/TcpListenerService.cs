@@ -1,20 +1,30 @@
+using System.Buffers;
+using System.Buffers.Text;
+using System.Buffers.Binary;
+using System.Diagnostics;
+using System.IO.Pipelines;
 using System.Net;
 using System.Net.Sockets;
-using System.Text;
 using System.Text.Json;
-using MineGuard.Api.Models;
 
 namespace MineGuard.Api.Services;
 
 public class TcpListenerService : BackgroundService
 {
     private readonly FleetStateService _fleetState;
+    private readonly LatencyTracker _latency;
     private readonly ILogger<TcpListenerService> _logger;
     private const int Port = 5000;
+    private const int HeaderSize = 4;
+    private const int MaxPayloadLength = 1_000_000;
+    private const int ReadBufferSize = 64 * 1024;
+    private const int AckBufferSize = 64;
 
-    public TcpListenerService(FleetStateService fleetState, ILogger<TcpListenerService> logger)
+    public TcpListenerService(FleetStateService fleetState, LatencyTracker latency,
+                              ILogger<TcpListenerService> logger)
     {
         _fleetState = fleetState;
+        _latency = latency;
         _logger = logger;
     }
 
@@ -29,8 +39,8 @@ public class TcpListenerService : BackgroundService
             try
             {
                 var client = await listener.AcceptTcpClientAsync(stoppingToken);
-                _logger.LogInformation("[TCP] Simulator connected from {Endpoint}", client.Client.RemoteEndPoint);
-                _fleetState.SetSimulatorConnected(true);
+                client.NoDelay = true;  // acks/welcome sao frames pequenos
+                _logger.LogInformation("[TCP] Client connected from {Endpoint}", client.Client.RemoteEndPoint);
 
                 // Processa cliente em background
                 _ = Task.Run(() => HandleClient(client, stoppingToken), stoppingToken);
@@ -48,88 +58,196 @@ public class TcpListenerService : BackgroundService
         listener.Stop();
     }
 
+    // ============================================================
+    // Ingestao por conexao (System.IO.Pipelines)
+    //
+    // O PipeReader usa buffers do MemoryPool compartilhado (ArrayPool),
+    // os frames sao recortados direto da ReadOnlySequence e o JSON e
+    // lido com Utf8JsonReader sem passar por string nem DTO.
+    // ============================================================
+
     private async Task HandleClient(TcpClient client, CancellationToken ct)
     {
         using var stream = client.GetStream();
-        var headerBuffer = new byte[4];
+        var reader = PipeReader.Create(stream, new StreamPipeReaderOptions(
+            minimumReadSize: ReadBufferSize, leaveOpen: true));
+        string endpoint = client.Client.RemoteEndPoint?.ToString() ?? "unknown";
+
+        // Sessao aberta no primeiro frame: hello define a fonte,
+        // cliente sem handshake cai na fonte default
+        SourcePartition? source = null;
+        BatchFrameParser? parser = null;
+        byte[]? ackBuffer = null;
 
         try
         {
-            while (!ct.IsCancellationRequested && client.Connected)
+            while (!ct.IsCancellationRequested)
             {
-                // 1. Ler header de 4 bytes (tamanho do payload, big-endian)
-                if (!await ReadExact(stream, headerBuffer, 4, ct))
-                {
-                    break;
-                }
-
-                // Converter big-endian para int
-                if (BitConverter.IsLittleEndian)
-                    Array.Reverse(headerBuffer);
-                int payloadLength = BitConverter.ToInt32(headerBuffer, 0);
+                ReadResult result = await reader.ReadAsync(ct);
+                ReadOnlySequence<byte> buffer = result.Buffer;
 
-                if (payloadLength <= 0 || payloadLength > 1_000_000)
+                FrameStatus status;
+                while ((status = TryReadFrame(ref buffer, out var payload)) == FrameStatus.Complete)
                 {
-                    _logger.LogWarning("[TCP] Invalid payload length: {Length}", payloadLength);
-                    break;
+                    if (source == null)
+                    {
+                        bool hello = BatchFrameParser.TryParseHello(payload, out var sourceId, out bool ack);
+                        source = _fleetState.OpenSession(hello ? sourceId : FleetStateService.DefaultSourceId, endpoint);
+                        parser = new BatchFrameParser(_fleetState, source);
+
+                        _logger.LogInformation("[TCP] Session {Session} opened for source '{Source}' ({Endpoint})",
+                            source.SessionId, source.SourceId, endpoint);
+
+                        if (hello)
+                        {
+                            if (ack) ackBuffer = new byte[AckBufferSize];
+                            await SendWelcome(stream, source, ct);
+                            continue;
+                        }
+                    }
+
+                    bool ok = ProcessFrame(parser!, source, payload, out long tickId);
+
+                    if (ackBuffer != null)
+                    {
+                        await stream.WriteAsync(ackBuffer.AsMemory(0, FormatAck(ackBuffer, tickId, ok)), ct);
+                    }
                 }
 
-                // 2. Ler payload JSON
-                var payloadBuffer = new byte[payloadLength];
-                if (!await ReadExact(stream, payloadBuffer, payloadLength, ct))
+                // Consome os frames processados; o resto fica pro proximo Read
+                reader.AdvanceTo(buffer.Start, buffer.End);
+
+                if (status == FrameStatus.Invalid || result.IsCompleted)
                 {
                     break;
                 }
-
-                string json = Encoding.UTF8.GetString(payloadBuffer);
-
-                // 3. Processar JSON
-                ProcessMessage(json);
             }
         }
+        catch (OperationCanceledException)
+        {
+        }
         catch (Exception ex)
         {
             _logger.LogError(ex, "[TCP] Error handling client");
         }
         finally
         {
-            _logger.LogInformation("[TCP] Simulator disconnected");
-            _fleetState.SetSimulatorConnected(false);
+            await reader.CompleteAsync();
+            if (source != null)
+            {
+                _fleetState.CloseSession(source);
+                _logger.LogInformation("[TCP] Source '{Source}' disconnected ({Endpoint})", source.SourceId, endpoint);
+            }
+            else
+            {
+                _logger.LogInformation("[TCP] Client disconnected before handshake ({Endpoint})", endpoint);
+            }
             client.Close();
         }
     }
 
-    private void ProcessMessage(string json)
+    // Resposta ao hello: {"type":"welcome","session_id":N,"source_id":"..."}
+    private static async Task SendWelcome(NetworkStream stream, SourcePartition source, CancellationToken ct)
     {
-        try
+        var body = JsonSerializer.SerializeToUtf8Bytes(new Dictionary<string, object>
         {
-            var batch = JsonSerializer.Deserialize<BatchPacket>(json);
-            if (batch == null) return;
+            ["type"] = "welcome",
+            ["session_id"] = source.SessionId,
+            ["source_id"] = source.SourceId
+        });
 
-            // Atualizar estado dos veiculos
-            foreach (var packet in batch.Telemetry)
-            {
-                _fleetState.UpdateVehicle(packet);
-            }
+        var frame = new byte[HeaderSize + body.Length];
+        BinaryPrimitives.WriteInt32BigEndian(frame, body.Length);
+        body.CopyTo(frame, HeaderSize);
 
-            // Atualizar alertas
-            _fleetState.UpdateAlerts(batch.Alerts);
-        }
-        catch (JsonException ex)
+        await stream.WriteAsync(frame, ct);
+    }
+
+    // Ack por batch (so quando pedido no hello): {"type":"ack","tick_id":N,"ok":true}.
+    // Formatado num buffer da conexao, sem alocar por frame.
+    private static int FormatAck(byte[] buffer, long tickId, bool ok)
+    {
+        var body = buffer.AsSpan(HeaderSize);
+        int length = 0;
+
+        "{\"type\":\"ack\",\"tick_id\":"u8.CopyTo(body);
+        length += "{\"type\":\"ack\",\"tick_id\":"u8.Length;
+
+        Utf8Formatter.TryFormat(tickId, body[length..], out int written);
+        length += written;
+
+        var tail = ok ? ",\"ok\":true}"u8 : ",\"ok\":false}"u8;
+        tail.CopyTo(body[length..]);
+        length += tail.Length;
+
+        BinaryPrimitives.WriteInt32BigEndian(buffer, length);
+        return HeaderSize + length;
+    }
+
+    private enum FrameStatus
+    {
+        Complete,
+        Incomplete,
+        Invalid
+    }
+
+    // Protocolo: [4 bytes tamanho big-endian][payload JSON]
+    private FrameStatus TryReadFrame(ref ReadOnlySequence<byte> buffer, out ReadOnlySequence<byte> payload)
+    {
+        payload = default;
+        if (buffer.Length < HeaderSize) return FrameStatus.Incomplete;
+
+        Span<byte> header = stackalloc byte[HeaderSize];
+        buffer.Slice(0, HeaderSize).CopyTo(header);
+        int payloadLength = BinaryPrimitives.ReadInt32BigEndian(header);
+
+        if (payloadLength <= 0 || payloadLength > MaxPayloadLength)
         {
-            _logger.LogWarning("[TCP] Failed to parse JSON: {Error}", ex.Message);
+            _logger.LogWarning("[TCP] Invalid payload length: {Length}", payloadLength);
+            return FrameStatus.Invalid;
         }
+
+        if (buffer.Length < HeaderSize + payloadLength) return FrameStatus.Incomplete;
+
+        payload = buffer.Slice(HeaderSize, payloadLength);
+        buffer = buffer.Slice(HeaderSize + payloadLength);
+        return FrameStatus.Complete;
     }
 
-    private static async Task<bool> ReadExact(NetworkStream stream, byte[] buffer, int count, CancellationToken ct)
+    // Retorna false se o frame foi descartado por JSON invalido
+    private bool ProcessFrame(BatchFrameParser parser, SourcePartition source, ReadOnlySequence<byte> payload, out long tickId)
     {
-        int totalRead = 0;
-        while (totalRead < count)
+        tickId = 0;
+        long receivedAt = DateTimeOffset.UtcNow.ToUnixTimeMilliseconds();
+        long receivedTicks = Stopwatch.GetTimestamp();
+
+        try
+        {
+            // Frame lido inteiro antes de aplicar; frame invalido vira
+            // JsonException sem aplicar nada
+            BatchFrameInfo info = parser.Parse(payload);
+            tickId = info.TickId;
+            long parsedTicks = Stopwatch.GetTimestamp();
+
+            parser.Apply();
+
+            // Marca a fonte pro proximo snapshot; a serializacao fica
+            // com o publicador, fora do caminho de ingestao
+            source.RecordFrame(in info, receivedAt);
+
+            long appliedTicks = Stopwatch.GetTimestamp();
+            long appliedAt = DateTimeOffset.UtcNow.ToUnixTimeMilliseconds();
+
+            _latency.RecordFrame(
+                info.OldestTimestamp, info.SentAt, receivedAt, appliedAt,
+                receivedTicks, parsedTicks, appliedTicks);
+            return true;
+        }
+        catch (JsonException ex)
         {
-            int read = await stream.ReadAsync(buffer.AsMemory(totalRead, count - totalRead), ct);
-            if (read == 0) return false; // conexao fechada
-            totalRead += read;
+            source.RecordParseError();
+            _logger.LogWarning("[TCP] Failed to parse JSON: {Error}", ex.Message);
+            return false;
         }
-        return true;
     }
 }
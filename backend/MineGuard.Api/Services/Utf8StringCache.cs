@@ -0,0 +1,56 @@
+namespace MineGuard.Api.Services;
+
+// Cache de strings indexado pelos bytes UTF-8 originais.
+// IDs de veiculo se repetem a cada tick: depois da primeira vez,
+// o parser reaproveita a mesma string em vez de alocar outra.
+// Nao e thread-safe: uma instancia por conexao.
+public sealed class Utf8StringCache
+{
+    private const int MaxEntries = 65_536;
+
+    private readonly Dictionary<int, List<Entry>> _entries = new();
+    private int _count;
+
+    private readonly struct Entry
+    {
+        public Entry(byte[] utf8, string value)
+        {
+            Utf8 = utf8;
+            Value = value;
+        }
+
+        public byte[] Utf8 { get; }
+        public string Value { get; }
+    }
+
+    public string Get(ReadOnlySpan<byte> utf8)
+    {
+        var hash = new HashCode();
+        hash.AddBytes(utf8);
+        int key = hash.ToHashCode();
+
+        if (_entries.TryGetValue(key, out var bucket))
+        {
+            foreach (var entry in bucket)
+            {
+                if (utf8.SequenceEqual(entry.Utf8))
+                    return entry.Value;
+            }
+        }
+
+        string value = System.Text.Encoding.UTF8.GetString(utf8);
+
+        // Limite contra IDs sempre novos (cliente com defeito)
+        if (_count >= MaxEntries) return value;
+
+        if (bucket == null)
+        {
+            bucket = new List<Entry>(1);
+            _entries[key] = bucket;
+        }
+        bucket.Add(new Entry(utf8.ToArray(), value));
+        _count++;
+
+        return value;
+    }
+}
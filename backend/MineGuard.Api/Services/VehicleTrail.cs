@@ -0,0 +1,190 @@
+using MineGuard.Api.Models;
+
+namespace MineGuard.Api.Services;
+
+// ============================================================
+// Rastro por veiculo em aneis de capacidade fixa
+//
+// Cada anel guarda uma amostra por slot de tempo (a primeira posicao
+// que chega no slot). O anel e dividido em blocos de BlockSize slots:
+// o bloco guarda a posicao absoluta da primeira amostra (keyframe) e
+// cada amostra e um par int16 (leste, norte) em decimetros em relacao
+// a amostra anterior do bloco. A quantizacao e em malha fechada (a
+// referencia e a posicao reconstruida), entao o erro nao acumula.
+// Slot sem amostra guarda Gap. Blocos sao sobrescritos inteiros, por
+// isso o anel tem um bloco a mais que a janela garantida.
+//
+// Memoria por veiculo (VehicleTrail): 1 Hz por 30 min + 1 amostra a
+// cada 5 s por 12 h = (1920 + 8704) slots x 4 bytes + keyframes,
+// ~44 KB. Um turno inteiro a 1 Hz em int16 nao caberia em 50 KB
+// (43200 x 4 bytes = 169 KB), entao o turno fica no anel grosso.
+// ============================================================
+
+public sealed class TrailRing
+{
+    public const int BlockSize = 64;
+
+    // Par marcado como slot sem amostra (nunca sai da quantizacao)
+    public const short Gap = short.MinValue;
+
+    private const double MetersPerDegreeLat = 6371000.0 * Math.PI / 180.0;
+
+    public long ResolutionMs { get; }
+    public int Capacity { get; }
+
+    private readonly short[] _points;     // (leste, norte) por slot, intercalados
+    private readonly double[] _keys;      // (lat, lon) por bloco; NaN = bloco sem amostra
+    private long _firstSlot = -1;         // primeiro slot depois do ultimo reset
+    private long _headSlot = -1;          // slot absoluto da amostra mais recente
+    private double _lastLat;              // posicao reconstruida da ultima amostra
+    private double _lastLon;
+
+    // window: duracao garantida no anel (arredondada pra blocos inteiros)
+    public TrailRing(long resolutionMs, TimeSpan window)
+    {
+        ResolutionMs = resolutionMs;
+        int slots = (int)Math.Ceiling(window.TotalMilliseconds / resolutionMs);
+        Capacity = ((slots + BlockSize - 1) / BlockSize + 1) * BlockSize;
+
+        _points = new short[Capacity * 2];
+        _keys = new double[Capacity / BlockSize * 2];
+        Reset();
+    }
+
+    // Duracao que o anel garante (sem o bloco sendo sobrescrito)
+    public long WindowMs => (Capacity - BlockSize) * ResolutionMs;
+
+    public void Append(long timestamp, double latitude, double longitude)
+    {
+        long slot = timestamp / ResolutionMs;
+        if (slot <= _headSlot) return;
+
+        if (_headSlot < 0 || slot - _headSlot >= Capacity)
+        {
+            // Primeira amostra ou sumiu por mais que o anel: comeca do zero
+            Reset();
+            _firstSlot = slot;
+        }
+        else
+        {
+            for (long s = _headSlot + 1; s < slot; s++) Skip(s);
+        }
+
+        int index = (int)(slot % Capacity);
+        int block = index / BlockSize;
+        if (index % BlockSize == 0 || double.IsNaN(_keys[block * 2]))
+        {
+            if (index % BlockSize == 0) Array.Fill(_points, Gap, index * 2, BlockSize * 2);
+            _keys[block * 2] = latitude;
+            _keys[block * 2 + 1] = longitude;
+            _lastLat = latitude;
+            _lastLon = longitude;
+        }
+
+        // Escala de longitude na latitude do keyframe (o leitor refaz igual)
+        double metersPerDegreeLon = MetersPerDegreeLat * Math.Cos(_keys[block * 2] * Math.PI / 180.0);
+        short east = Quantize((longitude - _lastLon) * metersPerDegreeLon);
+        short north = Quantize((latitude - _lastLat) * MetersPerDegreeLat);
+        _lastLon += east / 10.0 / metersPerDegreeLon;
+        _lastLat += north / 10.0 / MetersPerDegreeLat;
+
+        _points[index * 2] = east;
+        _points[index * 2 + 1] = north;
+        _headSlot = slot;
+    }
+
+    // Copia os blocos que cobrem os ultimos windowMs (a partir do
+    // primeiro bloco que contem o inicio pedido)
+    public VehicleTrailSnapshot Read(string vehicleId, long windowMs)
+    {
+        var snapshot = new VehicleTrailSnapshot
+        {
+            Id = vehicleId,
+            ResolutionMs = ResolutionMs,
+            BlockSize = BlockSize
+        };
+        if (_headSlot < 0) return snapshot;
+
+        long tail = Math.Max(BlockStart(_firstSlot), BlockStart(_headSlot) - Capacity + BlockSize);
+        long from = BlockStart(Math.Max(tail, _headSlot - windowMs / ResolutionMs + 1));
+        int blocks = (int)((BlockStart(_headSlot) - from) / BlockSize + 1);
+
+        snapshot.Start = from * ResolutionMs;
+        snapshot.Keyframes = new double[blocks * 2];
+        snapshot.Points = new short[(int)(_headSlot - from + 1) * 2];
+
+        for (int b = 0; b < blocks; b++)
+        {
+            long first = from + (long)b * BlockSize;
+            int index = (int)(first % Capacity);
+            int count = (int)Math.Min(BlockSize, _headSlot - first + 1);
+
+            // Bloco so com Gap: keyframe nao importa, sai zerado
+            double lat = _keys[index / BlockSize * 2];
+            double lon = _keys[index / BlockSize * 2 + 1];
+            snapshot.Keyframes[b * 2] = double.IsNaN(lat) ? 0.0 : lat;
+            snapshot.Keyframes[b * 2 + 1] = double.IsNaN(lon) ? 0.0 : lon;
+
+            Array.Copy(_points, index * 2, snapshot.Points, b * BlockSize * 2, count * 2);
+        }
+        return snapshot;
+    }
+
+    private void Skip(long slot)
+    {
+        int index = (int)(slot % Capacity);
+        if (index % BlockSize == 0)
+        {
+            Array.Fill(_points, Gap, index * 2, BlockSize * 2);
+            _keys[index / BlockSize * 2] = double.NaN;
+            _keys[index / BlockSize * 2 + 1] = double.NaN;
+        }
+        else
+        {
+            _points[index * 2] = Gap;
+            _points[index * 2 + 1] = Gap;
+        }
+    }
+
+    private void Reset()
+    {
+        Array.Fill(_points, Gap);
+        Array.Fill(_keys, double.NaN);
+        _headSlot = -1;
+    }
+
+    private static long BlockStart(long slot) => slot - slot % BlockSize;
+
+    // Metros -> decimetros; salto maior que +-3,2 km satura e a malha
+    // fechada alcanca a posicao nas amostras seguintes
+    private static short Quantize(double meters)
+    {
+        double dm = Math.Round(meters * 10.0);
+        return (short)Math.Clamp(dm, -short.MaxValue, short.MaxValue);
+    }
+}
+
+// Rastro de um veiculo: anel fino pros ultimos minutos e anel grosso
+// pro turno. Acesso sob o lock do Vehicle dono.
+public sealed class VehicleTrail
+{
+    public static readonly TimeSpan FineWindow = TimeSpan.FromMinutes(30);
+    public static readonly TimeSpan CoarseWindow = TimeSpan.FromHours(12);
+
+    public readonly TrailRing Fine = new(1000, FineWindow);
+    public readonly TrailRing Coarse = new(5000, CoarseWindow);
+
+    public void Append(long timestamp, double latitude, double longitude)
+    {
+        Fine.Append(timestamp, latitude, longitude);
+        Coarse.Append(timestamp, latitude, longitude);
+    }
+
+    // Anel mais fino que cobre a janela pedida
+    public VehicleTrailSnapshot Read(string vehicleId, TimeSpan window)
+    {
+        long windowMs = (long)window.TotalMilliseconds;
+        var ring = windowMs <= Fine.WindowMs ? Fine : Coarse;
+        return ring.Read(vehicleId, windowMs);
+    }
+}
@@ -3,7 +3,7 @@
 // ============================================================
 
 const API_BASE = 'http://localhost:5100/api';
-const POLL_INTERVAL = 1000; // 1 segundo
+const POLL_INTERVAL = 1000; // 1 segundo (so no fallback sem streaming)
 
 // ============================================================
 // Mapa Leaflet
@@ -98,7 +98,7 @@ function updateMap(vehicles) {
                 const latlngs = trail.getLatLngs();
                 latlngs.push(pos);
                 // Manter apenas ultimos 60 pontos (1 min)
-                if (latlngs.length > 60) latlngs.shift();
+                if (latlngs.length > TRAIL_POINTS) latlngs.shift();
                 trail.setLatLngs(latlngs);
             }
         } else {
@@ -128,6 +128,7 @@ function updateMap(vehicles) {
                 weight: 2,
                 opacity: 0.4
             }).addTo(map);
+            loadTrail(v.id);
         }
 
         // Atualizar popup
@@ -158,6 +159,49 @@ function updateMap(vehicles) {
 const CYCLE_STATES = ['IDLE', 'LOADING', 'HAULING', 'DUMPING', 'RETURNING'];
 const CYCLE_CLASSES = ['idle', 'loading', 'hauling', 'dumping', 'returning'];
 
+// ============================================================
+// Rastro guardado no backend (sobrevive a reconexao do dashboard)
+// ============================================================
+
+const TRAIL_POINTS = 60;             // mesmo limite do rastro ao vivo
+const TRAIL_GAP = -32768;            // slot sem amostra
+const METERS_PER_DEGREE = 111194.93;
+
+// Blocos: keyframe (lat, lon) + pares (leste, norte) em decimetros
+// a partir da amostra anterior do bloco
+function decodeTrail(trail) {
+    const points = [];
+    const slots = trail.points.length / 2;
+    for (let b = 0; b * trail.blockSize < slots; b++) {
+        let lat = trail.keyframes[b * 2];
+        let lng = trail.keyframes[b * 2 + 1];
+        const mLng = METERS_PER_DEGREE * Math.cos(lat * Math.PI / 180);
+        const end = Math.min(slots, (b + 1) * trail.blockSize);
+        for (let i = b * trail.blockSize; i < end; i++) {
+            const east = trail.points[i * 2];
+            if (east === TRAIL_GAP) continue;
+            lng += east / 10 / mLng;
+            lat += trail.points[i * 2 + 1] / 10 / METERS_PER_DEGREE;
+            points.push([lat, lng]);
+        }
+    }
+    return points;
+}
+
+// Historico vem antes dos pontos que ja chegaram ao vivo
+async function loadTrail(id) {
+    try {
+        const res = await fetch(`${API_BASE}/vehicles/${encodeURIComponent(id)}/trail?seconds=${TRAIL_POINTS}`);
+        if (!res.ok || !vehicleTrails[id]) return;
+
+        const history = decodeTrail(await res.json());
+        const latlngs = history.concat(vehicleTrails[id].getLatLngs());
+        vehicleTrails[id].setLatLngs(latlngs.slice(-TRAIL_POINTS));
+    } catch (err) {
+        // Sem rastro no backend: fica so o rastro ao vivo
+    }
+}
+
 function updateFleetList(vehicles) {
     const container = document.getElementById('fleet-list');
 
@@ -243,6 +287,7 @@ function updateAlerts(alerts) {
                 <span class="alert-type">${alertType}</span>
                 <span class="alert-tti">${a.timeToImpact.toFixed(1)}s</span>
                 <span class="alert-distance">${a.distance.toFixed(1)}m</span>
+                ${a.probability < 1 ? `<span class="alert-probability">${Math.round(a.probability * 100)}%</span>` : ''}
             </div>
         `;
     }).join('');
@@ -280,11 +325,83 @@ function updateStatus(status) {
 }
 
 // ============================================================
-// Polling - busca dados da API a cada 1 segundo
+// Streaming - snapshot na conexao + um delta por intervalo do publicador (SSE)
 // ============================================================
 
 let backendOnline = false;
 
+// Estado local da frota, mantido a partir dos deltas
+const fleet = new Map();
+let activeAlerts = [];
+
+function setBackendOnline(online, reason) {
+    if (online && !backendOnline) {
+        backendOnline = true;
+        console.log('[MineGuard] Connected to backend');
+    } else if (!online && backendOnline) {
+        backendOnline = false;
+        console.warn('[MineGuard] Backend offline:', reason);
+    }
+}
+
+function applySnapshot(msg) {
+    fleet.clear();
+    msg.vehicles.forEach(v => fleet.set(v.id, v));
+    activeAlerts = msg.alerts;
+
+    const vehicles = Array.from(fleet.values());
+    updateMap(vehicles);
+    updateFleetList(vehicles);
+    updateAlerts(activeAlerts);
+    updateStatus(msg.status);
+}
+
+function applyDelta(msg) {
+    // So redesenha o que mudou; lista lateral usa o estado completo
+    msg.vehicles.forEach(v => fleet.set(v.id, v));
+    if (msg.vehicles.length > 0) {
+        updateMap(msg.vehicles);
+        updateFleetList(Array.from(fleet.values()));
+    }
+
+    if (msg.alerts) {
+        activeAlerts = msg.alerts;
+        updateAlerts(activeAlerts);
+    }
+
+    updateStatus(msg.status);
+}
+
+function startStream() {
+    const source = new EventSource(`${API_BASE}/stream`);
+    let received = false;
+
+    source.addEventListener('snapshot', e => {
+        received = true;
+        setBackendOnline(true);
+        applySnapshot(JSON.parse(e.data));
+    });
+
+    source.addEventListener('delta', e => {
+        applyDelta(JSON.parse(e.data));
+    });
+
+    source.onerror = () => {
+        // Nunca conectou: servidor sem /stream, volta pro polling.
+        // Caiu depois: o EventSource reconecta sozinho e recebe snapshot.
+        if (!received) {
+            source.close();
+            startPolling();
+        } else {
+            setBackendOnline(false, 'stream interrupted');
+        }
+    };
+}
+
+// ============================================================
+// Polling - fallback quando o streaming nao esta disponivel
+// ============================================================
+
 async function poll() {
     try {
         const [vehiclesRes, alertsRes, statusRes] = await Promise.all([
@@ -302,15 +419,107 @@ async function poll() {
         updateAlerts(alerts);
         updateStatus(status);
 
-        if (!backendOnline) {
-            backendOnline = true;
-            console.log('[MineGuard] Connected to backend');
-        }
+        setBackendOnline(true);
     } catch (err) {
-        if (backendOnline) {
-            backendOnline = false;
-            console.warn('[MineGuard] Backend offline:', err.message);
-        }
+        setBackendOnline(false, err.message);
+    }
+}
+
+function startPolling() {
+    setInterval(poll, POLL_INTERVAL);
+    poll();
+}
+
+// ============================================================
+// Mapa de calor de quase-colisoes (tile publicado pelo simulador)
+// ============================================================
+
+const HEATMAP_INTERVAL = 30000; // mesmo ritmo de publicacao do simulador
+const HEATMAP_PRIORITY_LAYERS = ['LOW', 'MEDIUM', 'HIGH', 'CRITICAL'];
+const heatmapLayer = L.layerGroup().addTo(map);
+
+// Camada em run-length esparso: (zeros pulados, n) + n valores
+function decodeHeatmapLayer(runs, cells) {
+    let pos = 0;
+    for (let i = 0; i < runs.length; ) {
+        pos += runs[i];
+        const n = runs[i + 1];
+        for (let k = 0; k < n; k++) cells[pos + k] += runs[i + 2 + k];
+        pos += n;
+        i += 2 + n;
+    }
+}
+
+function drawHeatmap(tile) {
+    const cells = new Float64Array(tile.cols * tile.rows);
+    HEATMAP_PRIORITY_LAYERS.forEach(name => decodeHeatmapLayer(tile.layers[name] || [], cells));
+
+    let max = 0;
+    cells.forEach(c => { if (c > max) max = c; });
+
+    heatmapLayer.clearLayers();
+    if (max === 0) return;
+
+    // Mesma aproximacao do simulador pra converter metros em graus
+    const dLat = tile.cell_size / 111194.93;
+    const dLon = dLat / Math.cos(tile.origin.latitude * Math.PI / 180);
+
+    cells.forEach((c, i) => {
+        if (c === 0) return;
+        const row = Math.floor(i / tile.cols);
+        const col = i % tile.cols;
+        const south = tile.origin.latitude + row * dLat;
+        const west = tile.origin.longitude + col * dLon;
+        L.rectangle([[south, west], [south + dLat, west + dLon]], {
+            stroke: false,
+            fillColor: '#ef4444',
+            fillOpacity: 0.1 + 0.6 * c / max,
+            interactive: false
+        }).addTo(heatmapLayer);
+    });
+}
+
+async function pollHeatmap() {
+    try {
+        const res = await fetch(`${API_BASE}/heatmap`);
+        if (res.ok) drawHeatmap(await res.json());
+    } catch (err) {
+        // Sem tile ainda ou backend fora: tenta no proximo ciclo
+    }
+}
+
+// ============================================================
+// KPIs de producao (frame publicado pelo simulador)
+// ============================================================
+
+const KPI_INTERVAL = 10000; // mesmo ritmo de publicacao do simulador
+const KPI_MEDIUM = 1;       // indice da janela de 15 min
+const KPI_SHIFT = 2;        // indice da janela do turno
+
+// null = sem dados na janela
+function formatKpi(value, scale, digits) {
+    return value === null || value === undefined ? '-' : (value * scale).toFixed(digits);
+}
+
+function updateKpi(frame) {
+    const field = name => frame.fields.indexOf(name);
+    const medium = frame.fleet[KPI_MEDIUM];
+    const shift = frame.fleet[KPI_SHIFT];
+
+    document.getElementById('kpi-tph').textContent = formatKpi(medium[field('tonnes_per_hour')], 1, 0);
+    document.getElementById('kpi-cycle').textContent = formatKpi(medium[field('cycle_time')], 1 / 60, 1);
+    document.getElementById('kpi-queue').textContent = formatKpi(medium[field('queue_time')], 1 / 60, 1);
+    document.getElementById('kpi-fuel').textContent = formatKpi(medium[field('fuel_per_tonne')], 1, 3);
+    document.getElementById('kpi-cycles').textContent = formatKpi(medium[field('cycles')], 1, 0);
+    document.getElementById('kpi-shift').textContent = formatKpi(shift[field('tonnes')], 1, 0);
+}
+
+async function pollKpi() {
+    try {
+        const res = await fetch(`${API_BASE}/kpi`);
+        if (res.ok) updateKpi(await res.json());
+    } catch (err) {
+        // Sem frame ainda ou backend fora: tenta no proximo ciclo
     }
 }
 
@@ -351,8 +560,17 @@ const routeLine = L.polyline(
     { color: '#363b50', weight: 3, dashArray: '8,6', opacity: 0.5 }
 ).addTo(map);
 
-// Iniciar polling
-setInterval(poll, POLL_INTERVAL);
-poll();
+setInterval(pollHeatmap, HEATMAP_INTERVAL);
+pollHeatmap();
+
+setInterval(pollKpi, KPI_INTERVAL);
+pollKpi();
+
+// Iniciar streaming (cai pro polling se o navegador/servidor nao suportar)
+if (typeof EventSource !== 'undefined') {
+    startStream();
+} else {
+    startPolling();
+}
 
 console.log('[MineGuard] Dashboard initialized');
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef ALERT_EPISODES_HPP
+#define ALERT_EPISODES_HPP
+
+#include "telemetry.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mineguard {
+
+// Episodios de alerta por par (replay, batch e mapa de calor).
+//
+// Um episodio e a sequencia de ticks em que o par alerta sem
+// interrupcao. Evento = comeco do episodio ou subida acima da maior
+// prioridade ja vista nele: LOW -> MEDIUM -> HIGH -> CRITICAL sao 4
+// eventos, e o episodio vira quase-colisao ao chegar a HIGH. A chave
+// do par vem dos slots gravados no alerta pelo detector (nada de
+// busca por ID); os pares do tick ficam ordenados pra busca binaria.
+//
+// Uso por tick: observe() em cada alerta, depois end_tick().
+class AlertEpisodes {
+public:
+    // Maior prioridade do episodio antes deste alerta (NONE = episodio
+    // novo). O alerta e evento quando alert.priority passa disso.
+    AlertPriority observe(const CollisionAlert& alert) {
+        uint64_t key = pair_key(alert.slot_1, alert.slot_2);
+        auto it = std::lower_bound(previous_.begin(), previous_.end(), key,
+                                   [](const Mark& m, uint64_t k) { return m.key < k; });
+        AlertPriority peak = it != previous_.end() && it->key == key ? it->peak : AlertPriority::NONE;
+
+        current_.push_back(Mark{key, std::max(peak, alert.priority)});
+        return peak;
+    }
+
+    void end_tick() {
+        std::sort(current_.begin(), current_.end(),
+                  [](const Mark& x, const Mark& y) { return x.key < y.key; });
+        previous_.swap(current_);
+        current_.clear();
+    }
+
+    void clear() {
+        previous_.clear();
+        current_.clear();
+    }
+
+private:
+    struct Mark {
+        uint64_t key;
+        AlertPriority peak;        // maior prioridade no episodio
+    };
+
+    static uint64_t pair_key(uint32_t a, uint32_t b) {
+        if (a > b) std::swap(a, b);
+        return (static_cast<uint64_t>(a) << 32) | b;
+    }
+
+    std::vector<Mark> previous_;   // pares com alerta no tick anterior (ordenados)
+    std::vector<Mark> current_;
+};
+
+} // namespace mineguard
+
+#endif // ALERT_EPISODES_HPP
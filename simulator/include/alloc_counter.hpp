@@ -0,0 +1,44 @@
+#pragma once
+
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+#include <cstdint>
+
+namespace mineguard {
+
+// Instrumentacao de heap do processo inteiro. So conta quando o build
+// liga MINEGUARD_ALLOC_COUNTER (substitui operator new/delete globais);
+// sem a opcao, enabled() e false e os contadores ficam em zero.
+namespace alloc_counter {
+
+// Contadores acumulados; a diferenca entre dois snapshots da o custo
+// de um trecho (ex.: um estagio do tick)
+struct Snapshot {
+    uint64_t allocations;   // chamadas a operator new
+    uint64_t frees;         // chamadas a operator delete (ponteiro nao nulo)
+    uint64_t bytes;         // bytes alocados (tamanho util do bloco)
+    int64_t live_bytes;     // bytes vivos no heap agora
+};
+
+bool enabled();
+
+Snapshot snapshot();
+
+// Total de chamadas a operator new desde o inicio do processo
+uint64_t allocations();
+
+inline Snapshot operator-(const Snapshot& a, const Snapshot& b) {
+    return Snapshot{
+        a.allocations - b.allocations,
+        a.frees - b.frees,
+        a.bytes - b.bytes,
+        a.live_bytes - b.live_bytes
+    };
+}
+
+} // namespace alloc_counter
+
+} // namespace mineguard
+
+#endif // ALLOC_COUNTER_HPP
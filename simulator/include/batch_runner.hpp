@@ -0,0 +1,107 @@
+#pragma once
+
+#ifndef BATCH_RUNNER_HPP
+#define BATCH_RUNNER_HPP
+
+#include "fleet.hpp"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// ============================================================
+// Monte Carlo de cenarios pra analise de seguranca
+//
+// Cada execucao e uma FleetManager + CollisionDetector proprios, sem
+// nada mutavel compartilhado: semente propria (seed base + indice),
+// frota com FleetVariation e ticks sem relogio de parede. As execucoes
+// sao distribuidas num pool com roubo de trabalho (uma fila por
+// thread; quem esvazia a sua rouba do comeco da fila de outra).
+//
+// Cada execucao grava so o proprio slot de resultado; a thread que
+// chama escreve as linhas na ordem do indice assim que ficam prontas,
+// entao o arquivo sai igual com qualquer numero de threads.
+// ============================================================
+
+struct BatchConfig {
+    size_t runs;
+    size_t threads;            // 0 = hardware_concurrency
+    uint64_t seed;             // semente da execucao i: seed + i
+    double duration;           // segundos simulados por execucao
+    double delta_time;         // segundos por tick
+    size_t extra_trucks;       // caminhoes alem da frota padrao
+    size_t extra_light;        // veiculos leves alem da frota padrao
+    double speed_jitter;       // ver FleetVariation
+    double dwell_jitter;
+    double start_offset_max;
+    double section_reach;      // metros - alerta mais longe que isso de um trecho fica fora de estrada
+
+    static BatchConfig create_default();
+};
+
+// Trechos de estrada no plano local, pra atribuir alertas (tabela
+// imutavel montada uma vez e lida por todas as execucoes)
+class SectionIndex {
+public:
+    SectionIndex(const std::vector<RoadSection>& sections, double reach);
+
+    size_t size() const { return names_.size(); }
+    const std::string& name(size_t i) const { return names_[i]; }
+
+    // Trecho mais proximo do ponto; size() = fora de estrada
+    size_t nearest(const Position& p) const;
+
+private:
+    std::vector<std::string> names_;
+    std::vector<double> ax_, ay_, bx_, by_;
+    double lat0_;
+    double lon0_;
+    double m_per_deg_lat_;
+    double m_per_deg_lon_;
+    double reach_;
+};
+
+// Resultado compacto de uma execucao
+struct RunResult {
+    uint64_t seed = 0;
+    size_t vehicles = 0;
+    uint64_t ticks = 0;
+    uint64_t alert_events[5] = {};    // eventos (ver AlertEpisodes), por AlertPriority
+    double seconds = 0.0;             // tempo de parede da execucao
+
+    // Por trecho (+1 no fim: fora de estrada)
+    std::vector<uint32_t> near_misses;   // episodios que chegaram a HIGH, no trecho onde chegaram
+    std::vector<float> min_cpa;          // menor CPA entre centros (metros), INFINITY = sem alerta
+};
+
+class BatchRunner {
+public:
+    explicit BatchRunner(const BatchConfig& config);
+
+    // Roda todas as execucoes; uma linha CSV por execucao em out, na
+    // ordem do indice, escrita assim que a execucao fica pronta
+    void run(std::ostream& out);
+
+    // Agregado de todas as execucoes (eventos por hora, CPA por trecho)
+    void print_summary(std::ostream& out) const;
+
+    const std::vector<RunResult>& results() const { return results_; }
+    double wall_seconds() const { return wall_seconds_; }
+
+private:
+    RunResult run_one(size_t index) const;
+    void write_header(std::ostream& out) const;
+    void write_row(std::ostream& out, size_t index) const;
+
+    BatchConfig config_;
+    SectionIndex sections_;
+    std::vector<RunResult> results_;
+    double wall_seconds_;
+};
+
+} // namespace mineguard
+
+#endif // BATCH_RUNNER_HPP
@@ -5,8 +5,14 @@
 
 #include "vehicle.hpp"
 #include "telemetry.hpp"
+#include "conflict_zones.hpp"
+#include "pair_policy.hpp"
+#include "collision_risk.hpp"
+#include <array>
+#include <utility>
 #include <vector>
 #include <memory>
+#include <cstdint>
 
 namespace mineguard {
 
@@ -14,17 +20,231 @@ class CollisionDetector {
 public:
     CollisionDetector();
 
-    // Checa todas as combinacoes de veiculos e retorna alertas ativos
+    // Checa os pares de veiculos e retorna alertas ativos. So pares a
+    // ate MAX_PAIR_DISTANCE entram (grade uniforme, find_near_pairs).
+    // now: tempo de simulacao em segundos (agenda de reavaliacao dos pares)
     std::vector<CollisionAlert> check_all(
-        const std::vector<std::unique_ptr<Vehicle>>& vehicles
+        const std::vector<Vehicle*>& vehicles,
+        double now
     );
 
+    // Mesmo que acima, preenchendo o buffer do chamador (limpo antes).
+    // Capacidade e buffers internos sao reusados: em regime o tick nao aloca.
+    void check_all(
+        const std::vector<Vehicle*>& vehicles,
+        double now,
+        std::vector<CollisionAlert>& alerts
+    );
+
+    // Versao por shard: vehicles[0, owned) sao do shard e o resto e halo
+    // (copias de outros shards). Pares halo x halo sao pulados; quem monta
+    // o halo garante que cada par entre shards aparece em um shard so.
+    // timestamp: epoch ms do tick (o mesmo da telemetria)
+    void check_all(
+        const std::vector<Vehicle*>& vehicles,
+        size_t owned,
+        double now,
+        int64_t timestamp,
+        std::vector<CollisionAlert>& alerts
+    );
+
+    // Tabela de zonas da malha de rotas (nullptr = todos os pares em espaco livre)
+    void set_conflict_zones(const ConflictZoneTable* zones) { zones_ = zones; }
+
+    // Pares descartados pela tabela de zonas no ultimo check_all
+    size_t pairs_skipped_by_zones() const { return pairs_skipped_by_zones_; }
+
+    // Pares que passaram no teste de circulo e foram pro SAT no ultimo check_all
+    size_t pairs_narrowphase() const { return candidates_.size(); }
+
+    // Pares adiados pela agenda de reavaliacao no ultimo check_all
+    size_t pairs_deferred() const { return pairs_deferred_; }
+
+    // Pares que a politica manda nao avaliar (ex.: caminhao sendo
+    // carregado x a escavadeira que carrega ele) no ultimo check_all
+    size_t pairs_skipped_by_policy() const { return pairs_skipped_by_policy_; }
+
+    // Degradacao sob sobrecarga: pares longe e sem alerta acima de LOW
+    // na ultima avaliacao usam 1 a cada stride amostras da trajetoria
+    // (1 = resolucao cheia). Pares perto ou MEDIUM+ nunca degradam.
+    void set_coarse_stride(size_t stride) { coarse_stride_ = stride > 0 ? stride : 1; }
+    size_t coarse_stride() const { return coarse_stride_; }
+
+    // Pares avaliados com resolucao reduzida no ultimo check_all
+    size_t pairs_coarse() const { return pairs_coarse_; }
+
+    // Modo de risco: posicao/velocidade com ruido de GNSS (collision_risk.hpp).
+    // O teste de circulo cresce RISK_SIGMA_MARGIN sigmas, cada alerta sai
+    // com a probabilidade de colisao no horizonte, e pares sem
+    // sobreposicao no valor medio alertam se a probabilidade passa de
+    // RISK_ALERT_PROBABILITY. Desligado: probabilidade 1 em todo alerta.
+    void set_risk_mode(bool enabled) { risk_mode_ = enabled; }
+    bool risk_mode() const { return risk_mode_; }
+
+    // Pares que foram pro Monte Carlo no ultimo check_all
+    size_t pairs_monte_carlo() const { return monte_carlo_.size(); }
+
+    // Par mais longe que isso (distancia atual) nem e enumerado;
+    // tambem e o lado da celula da grade e o alcance do halo entre shards
+    static constexpr double MAX_PAIR_DISTANCE = 500.0;    // metros
+
+    // Memoria residente do detector: arrays por veiculo, cache de pares
+    // e buffers de rascunho do narrowphase (shared_bytes)
+    MemoryFootprint footprint() const;
+
 private:
-    // Checa um par de veiculos
-    CollisionAlert check_pair(const Vehicle& v1, const Vehicle& v2);
+    // Cache por par: resultado da ultima avaliacao e quando reavaliar.
+    // Chaveado pelos slots do pool da frota; as geracoes dizem se a
+    // entrada ainda e do mesmo par (slot reusado = entrada velha).
+    // v1 e sempre o veiculo do slot menor.
+    struct PairState {
+        uint32_t generation1;
+        uint32_t generation2;
+        bool valid;
+        double next_eval;        // tempo de simulacao (s)
+        double last_distance;    // metros
+        double closing_speed;    // m/s (positivo = aproximando)
+        double tti;              // segundos (-1 = sem alerta)
+        double speed1;           // km/h na ultima avaliacao
+        double heading1;         // graus
+        double speed2;
+        double heading2;
+    };
+
+    // Par que sobreviveu ao teste de circulo, aguardando o SAT
+    struct Candidate {
+        size_t i;
+        size_t j;
+        size_t pair;            // indice da entrada em pair_states_
+        size_t first_sample;    // indice em narrow_ (amostras contiguas)
+        size_t sample_count;
+        double current_distance;
+        double min_distance;    // CPA entre centros
+        size_t min_step;        // amostra da trajetoria em que o CPA acontece
+        double probability;     // maior probabilidade por amostra (modo de risco)
+        size_t risk_sample;     // primeira amostra acima do limite de alerta (indice em narrow_)
+        size_t monte_carlo;     // indice no lote do Monte Carlo (SIZE_MAX = fechada)
+    };
+
+    // Mapa esparso (slot menor, slot maior) -> PairState, enderecamento
+    // aberto com sondagem linear. Dimensionado no inicio do tick pros
+    // pares do tick: indices e referencias nao mudam ate o proximo reset.
+    // A chave usa os slots globais do pool, mas o tamanho so depende dos
+    // pares deste detector: com shards, cada um guarda os proprios pares.
+    class PairStateMap {
+    public:
+        // Esvazia e garante espaco pra expected entradas sem crescer
+        void reset(size_t expected);
+
+        // nullptr = par ausente
+        const PairState* find(uint64_t key) const;
+
+        // Entrada nova (a chave nao pode estar no mapa)
+        PairState& insert(uint64_t key, size_t& index);
+
+        PairState& at(size_t index) { return entries_[index].state; }
+        size_t size() const { return count_; }
+        size_t heap_bytes() const;
+
+        static uint64_t key(uint32_t lo, uint32_t hi) {
+            return (static_cast<uint64_t>(lo) << 32) | hi;
+        }
+
+    private:
+        static constexpr uint64_t EMPTY = UINT64_MAX;   // lo < hi: nunca e chave
+
+        struct Entry {
+            uint64_t key;
+            PairState state;
+        };
+
+        size_t slot_of(uint64_t key) const {
+            return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift_);
+        }
+
+        std::vector<Entry> entries_;
+        size_t mask_ = 0;
+        unsigned shift_ = 64;
+        size_t count_ = 0;
+    };
+
+    // Pares (a, b), a < b na lista, com distancia atual ate
+    // MAX_PAIR_DISTANCE e pelo menos um veiculo do shard, ordenados
+    void find_near_pairs(const std::vector<Vehicle*>& vehicles, size_t owned);
 
-    // Calcula distancia entre duas posicoes (metros)
-    double calculate_distance(const Position& a, const Position& b) const;
+    // Mapeia o arco previsto do veiculo nas zonas que ele vai ocupar.
+    // Retorna false se o veiculo nao esta preso a uma rota da tabela.
+    bool compute_occupancy(const Vehicle& v, std::vector<ZoneOccupancy>& out) const;
+
+    // Trajetoria prevista de cada veiculo no plano local, uma vez por tick
+    void build_trajectories(const std::vector<Vehicle*>& vehicles);
+
+    // Estagio 1: teste de circulo barato sobre as trajetorias.
+    // Guarda as amostras em que os circulos se sobrepoem.
+    // Uma instancia por politica (pair_policy.hpp): horizonte, passo,
+    // corte e velocidade minima sao constantes no laco das amostras.
+    // coarse: passo extra do governador (1 = resolucao da politica);
+    // a varredura de cada amostra cobre o intervalo ate a proxima testada
+    template <typename Policy>
+    void check_pair(const std::vector<Vehicle*>& vehicles, size_t i, size_t j, size_t coarse);
+
+    using PairCheck = void (CollisionDetector::*)(const std::vector<Vehicle*>&, size_t, size_t, size_t);
+
+    // Instancia de check_pair da classe do par (nullptr = nao avaliar).
+    // v1 e o veiculo de slot menor.
+    static PairCheck pair_check_for(const Vehicle& v1, const Vehicle& v2);
+
+    // Tabela (tipo, tipo, estado) -> instancia, montada das especializacoes
+    static constexpr size_t TYPE_COUNT = 3;     // VehicleType
+    static constexpr size_t STATE_COUNT = 5;    // CycleState
+    static constexpr size_t POLICY_COUNT = TYPE_COUNT * TYPE_COUNT * STATE_COUNT;
+    static const std::array<PairCheck, POLICY_COUNT> PAIR_DISPATCH;
+
+    template <size_t I>
+    static PairCheck pair_check_at();
+
+    template <size_t... I>
+    static std::array<PairCheck, sizeof...(I)> make_pair_dispatch(std::index_sequence<I...>);
+
+    // Par pode ser avaliado com resolucao reduzida? (longe e a ultima
+    // avaliacao nao deu alerta acima de LOW)
+    bool can_coarsen(const PairState& ps, size_t i, size_t j) const;
+
+    // Estagio 2: SAT de retangulos orientados, em lote sobre todas as amostras
+    void run_narrowphase();
+
+    // Estagio 3 (modo de risco): probabilidade de colisao por candidato,
+    // fechada por amostra e Monte Carlo nas amostras ambiguas
+    void compute_risk();
+
+    // Covariancia da posicao relativa do par no instante t
+    Covariance2 relative_covariance(size_t i, size_t j, double t) const;
+
+    // Folga do teste de circulo no instante t (0 fora do modo de risco)
+    double risk_margin(size_t i, size_t j, double t) const;
+
+    // Gera os alertas a partir do primeiro instante com sobreposicao
+    void emit_alerts(const std::vector<Vehicle*>& vehicles, int64_t timestamp,
+                     std::vector<CollisionAlert>& alerts);
+
+    // Entrada do par (lo < hi em slot) no mapa do tick, trazida do mapa
+    // do tick anterior. Zerada se algum slot foi reusado ou se o par nao
+    // passou pelo ultimo check_all (saiu do alcance ou estava em outro
+    // shard; a agenda antiga nao vale mais)
+    PairState& pair_state(const Vehicle& lo, const Vehicle& hi, size_t& index);
+
+    // Par pode ser pulado neste tick? (agenda ainda no futuro e
+    // nenhum dos dois mudou velocidade/heading alem do limite)
+    bool can_defer(const PairState& ps, const Vehicle& v1, const Vehicle& v2, double now) const;
+
+    // Atualiza o cache do par com a avaliacao deste tick e calcula
+    // o instante mais cedo em que um conflito pode entrar no horizonte
+    void schedule_pair(size_t i, size_t j, PairState& ps,
+                       const Vehicle& v1, const Vehicle& v2,
+                       bool candidate, double now, double tick_margin);
+
+    // Ponto medio do par na amostra k da trajetoria, de volta em lat/lon
+    Position pair_midpoint(const std::vector<Vehicle*>& vehicles, size_t i, size_t j, size_t k) const;
 
     // Classifica o tipo de alerta baseado nas trajetorias
     AlertType classify_alert(const Vehicle& v1, const Vehicle& v2) const;
@@ -32,13 +252,87 @@ private:
     // Determina prioridade baseado no TTI
     AlertPriority priority_from_tti(double tti) const;
 
-    // Raio de seguranca combinado de dois veiculos
-    double combined_safety_radius(const Vehicle& v1, const Vehicle& v2) const;
+    // Raio de seguranca combinado de dois veiculos (circulos que
+    // envolvem os retangulos de seguranca do tick)
+    double combined_safety_radius(size_t i, size_t j) const;
+
+    // Meias-dimensoes do retangulo de seguranca, inscrito no circulo
+    // de safety_radius: lateral = meia largura + side_clearance
+    static double footprint_half_length(const Vehicle& v);
+    static double footprint_half_width(const Vehicle& v);
 
     // Configuracao
     static constexpr double MAX_PREDICTION_TIME = 15.0;  // segundos
     static constexpr double PREDICTION_STEP = 0.5;       // segundos
-    static constexpr double MIN_SPEED_THRESHOLD = 1.0;   // km/h - ignora veiculos parados
+    static constexpr double ZONE_LATERAL_TOLERANCE = 20.0; // metros fora da polilinha
+    static constexpr double SPEED_CHANGE_THRESHOLD = 5.0;  // km/h - invalida agenda do par
+    static constexpr double HEADING_CHANGE_THRESHOLD = 10.0; // graus - invalida agenda do par
+    static constexpr double FULL_RATE_DISTANCE = 100.0;    // metros - perto demais pra adiar
+    static constexpr double COARSE_MIN_DISTANCE = 200.0;   // metros - mais perto, sempre resolucao cheia
+    static constexpr double RISK_SIGMA_MARGIN = 3.0;       // sigmas somados ao raio no modo de risco
+    static constexpr double RISK_ALERT_PROBABILITY = 0.2;  // alerta sem sobreposicao no valor medio
+    static constexpr double RISK_AMBIGUOUS_MIN = 0.02;     // faixa em que a fechada pode errar
+    static constexpr double RISK_AMBIGUOUS_MAX = 0.98;
+    static constexpr double RISK_CORRELATION_LIMIT = 0.3;  // |rho| nos eixos de A
+    static constexpr double RISK_OBLIQUE_LIMIT = 0.25;     // |cos * sen| entre os eixos
+    static constexpr size_t TRAJECTORY_SAMPLES =
+        static_cast<size_t>(MAX_PREDICTION_TIME / PREDICTION_STEP) + 1;
+
+    const ConflictZoneTable* zones_;
+    std::vector<std::vector<ZoneOccupancy>> occupancy_;
+    std::vector<char> zone_bound_;
+    size_t pairs_skipped_by_zones_;
+
+    // Trajetorias (veiculo i, amostra k -> i * TRAJECTORY_SAMPLES + k)
+    std::vector<double> traj_x_;          // leste, metros
+    std::vector<double> traj_y_;          // norte, metros
+    std::vector<double> traj_ux_;         // eixo longitudinal unitario
+    std::vector<double> traj_uy_;
+    std::vector<double> half_length_;     // por veiculo
+    std::vector<double> half_width_;
+    std::vector<double> vel_x_;           // m/s atuais (leste/norte)
+    std::vector<double> vel_y_;
+    std::vector<Covariance2> vel_cov_;    // ruido de velocidade (modo de risco)
+    std::vector<double> pos_var_;         // variancia da posicao por eixo (filtro ou nominal)
+    double origin_latitude_;              // origem e escala do plano local do tick
+    double origin_longitude_;
+    double m_per_deg_lon_;
+
+    // Grade do tick (ordenacao por contagem dos veiculos por celula)
+    std::vector<size_t> cell_of_;         // por veiculo (SIZE_MAX = fora da grade)
+    std::vector<size_t> cell_start_;      // celula c: cell_items_[cell_start_[c], cell_start_[c + 1])
+    std::vector<uint32_t> cell_items_;
+    std::vector<uint64_t> near_pairs_;    // (a << 32) | b
+
+    // Agenda de reavaliacao por par de slots: pares do tick atual e do
+    // anterior. Par que nao volta no tick seguinte some com a troca dos
+    // mapas, sem remocao entrada a entrada.
+    PairStateMap pair_states_;
+    PairStateMap previous_pairs_;
+    double last_check_time_;
+    size_t pairs_deferred_;
+    size_t coarse_stride_;
+    size_t pairs_coarse_;
+    size_t pairs_skipped_by_policy_;
+    bool risk_mode_;
+
+    // Amostras do SAT em SoA (uma entrada por par x instante)
+    struct NarrowphaseBatch {
+        std::vector<double> dx, dy;       // centro de B relativo a A
+        std::vector<double> aux, auy, ahl, ahw;
+        std::vector<double> bux, buy, bhl, bhw;
+        std::vector<double> sweep;        // meio deslocamento relativo ate a proxima amostra
+        std::vector<uint32_t> step;       // indice do instante (t = step * PREDICTION_STEP)
+        std::vector<uint8_t> hit;
+
+        void clear();
+        size_t size() const { return dx.size(); }
+        size_t heap_bytes() const;
+    };
+
+    std::vector<Candidate> candidates_;
+    NarrowphaseBatch narrow_;
+    MonteCarloRisk monte_carlo_;
 };
 
 } // namespace mineguard
@@ -0,0 +1,98 @@
+#pragma once
+
+#ifndef COLLISION_RISK_HPP
+#define COLLISION_RISK_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// ============================================================
+// Risco probabilistico sob incerteza de GNSS
+//
+// Cada veiculo tem uma covariancia de posicao (ruido do GNSS) e de
+// velocidade (ruido de velocidade ao longo do heading e de heading,
+// que domina em baixa velocidade). No instante t a posicao relativa
+// de B em A tem covariancia
+//
+//   S(t) = S_pos(A) + S_pos(B) + t^2 * (S_vel(A) + S_vel(B))
+//
+// e a probabilidade de colisao na amostra e P(centro de B cair na
+// regiao de contato do SAT). Aproximacao fechada: a regiao vira a caixa
+// de extensoes do SAT nos eixos de A e a gaussiana e tratada como
+// separavel nesses eixos. Quando a caixa e ruim (retangulos obliquos)
+// ou a gaussiana e muito correlacionada nos eixos de A, a amostra vai
+// pro Monte Carlo, que testa o SAT completo em MONTE_CARLO_SAMPLES
+// pontos fixos.
+// ============================================================
+
+// Modelo de ruido do GNSS (1 sigma)
+struct GnssNoise {
+    static constexpr double POSITION_SIGMA = 1.5;        // metros, por eixo (sem estimativa do filtro)
+    static constexpr double SPEED_SIGMA = 0.3;           // m/s ao longo do heading
+    static constexpr double HEADING_SIGMA = 2.0;         // graus em velocidade de cruzeiro
+    static constexpr double LOW_SPEED_LATERAL_SIGMA = 0.5; // m/s: parado, o heading e ruido puro
+};
+
+// Covariancia 2D simetrica (leste/norte, ou eixos de um retangulo)
+struct Covariance2 {
+    double xx;
+    double xy;
+    double yy;
+};
+
+namespace risk {
+
+// Covariancia de velocidade de um veiculo andando em (ux, uy) a speed m/s:
+// longitudinal pelo ruido de velocidade, lateral por v * sigma_heading
+// mais um piso que representa o heading instavel em baixa velocidade
+Covariance2 velocity_covariance(double speed_ms, double ux, double uy);
+
+// P(|u - mu| <= lu e |v - mv| <= lv) com u, v gaussianas independentes
+double box_probability(double mu, double mv, double su, double sv, double lu, double lv);
+
+} // namespace risk
+
+// Lote de amostras ambiguas para o Monte Carlo (SoA, uma entrada por
+// amostra): media e Cholesky da covariancia relativa e a geometria do
+// SAT. Capacidade reusada entre ticks.
+class MonteCarloRisk {
+public:
+    static constexpr size_t MONTE_CARLO_SAMPLES = 256;
+
+    MonteCarloRisk();
+
+    void clear();
+    size_t size() const { return mx_.size(); }
+
+    // Enfileira uma amostra; retorna o indice pra ler a probabilidade
+    size_t add(double mx, double my, const Covariance2& cov,
+               double aux, double auy, double ahl, double ahw,
+               double bux, double buy, double bhl, double bhw, double sweep);
+
+    // Roda todas as amostras enfileiradas
+    void run();
+
+    double probability(size_t index) const { return probability_[index]; }
+
+    size_t heap_bytes() const;
+
+private:
+    // Normais padrao fixas (semente constante): o resultado e
+    // deterministico e nao oscila de um tick pro outro so pelo sorteio
+    std::vector<double> z1_;
+    std::vector<double> z2_;
+
+    std::vector<double> mx_, my_;
+    std::vector<double> l11_, l21_, l22_;
+    std::vector<double> aux_, auy_, ahl_, ahw_;
+    std::vector<double> bux_, buy_, bhl_, bhw_;
+    std::vector<double> sweep_;
+    std::vector<double> probability_;
+};
+
+} // namespace mineguard
+
+#endif // COLLISION_RISK_HPP
@@ -0,0 +1,95 @@
+#pragma once
+
+#ifndef CONFLICT_ZONES_HPP
+#define CONFLICT_ZONES_HPP
+
+#include "route_path.hpp"
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace mineguard {
+
+// Celula da grade onde duas rotas diferentes passam a menos de CLEARANCE
+// (cruzamentos, convergencias, area de carga, aproximacao do dump)
+struct ConflictZone {
+    double x;                      // centro no plano local (metros)
+    double y;
+    std::vector<int> neighbors;    // zonas que podem conflitar (inclui a propria)
+};
+
+// Trecho de uma rota que passa por uma zona
+struct ZoneInterval {
+    int zone;
+    double s_begin;                // metros ao longo da rota
+    double s_end;
+};
+
+// Janela em que um veiculo pode ocupar uma zona (tabela de reserva)
+struct ZoneOccupancy {
+    int zone;
+    double t_enter;                // segundos a partir de agora
+    double t_exit;
+};
+
+// Tabela estatica de zonas de conflito da malha de rotas.
+// Montada uma vez no startup cruzando todos os segmentos das rotas;
+// a cada tick so e preciso mapear o intervalo de arco de cada veiculo
+// nas zonas que ele vai ocupar.
+class ConflictZoneTable {
+public:
+    void build(const std::vector<const RoutePath*>& paths);
+
+    bool empty() const { return zones_.empty(); }
+    size_t size() const { return zones_.size(); }
+    const ConflictZone& zone(int id) const { return zones_[id]; }
+
+    // Bytes de heap da tabela (zonas, grade e intervalos por rota)
+    size_t heap_bytes() const;
+
+    // Zonas ocupadas por um veiculo no arco s_now ao longo de path.
+    // Entrada mais cedo pela velocidade maxima, saida pela velocidade atual.
+    void occupancy(const RoutePath* path, double s_now,
+                   double speed_ms, double max_speed_ms, double horizon,
+                   std::vector<ZoneOccupancy>& out) const;
+
+    // Reserva: dois veiculos conflitam se ocupam zonas vizinhas
+    // em janelas de tempo sobrepostas
+    bool windows_overlap(const std::vector<ZoneOccupancy>& a,
+                         const std::vector<ZoneOccupancy>& b) const;
+
+    // Distancia minima entre rotas pra virar zona. Cobre raio de
+    // seguranca combinado + desvio lateral da polilinha + amostragem.
+    static constexpr double CLEARANCE = 120.0;   // metros
+    static constexpr double CELL_SIZE = CLEARANCE;
+    static constexpr double SAMPLE_STEP = 5.0;   // metros
+    static constexpr double EXIT_SLACK = 1.5;    // margem na janela de saida
+
+private:
+    struct Sample {
+        double x;
+        double y;
+        double s;
+        size_t path;
+    };
+
+    void to_local(const Position& p, double& x, double& y) const;
+    static int64_t cell_key(int cx, int cy);
+    static int cell_x(int64_t key);
+    static int cell_y(int64_t key);
+    int64_t cell_of(double x, double y) const;
+
+    std::vector<ConflictZone> zones_;
+    std::unordered_map<int64_t, int> cell_zone_;
+    std::unordered_map<const RoutePath*, std::vector<ZoneInterval>> intervals_;
+
+    // Plano local comum a todas as rotas
+    double lat0_ = 0.0;
+    double lon0_ = 0.0;
+    double m_per_deg_lat_ = 0.0;
+    double m_per_deg_lon_ = 0.0;
+};
+
+} // namespace mineguard
+
+#endif // CONFLICT_ZONES_HPP
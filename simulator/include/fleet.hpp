@@ -5,10 +5,16 @@
 
 #include "vehicle.hpp"
 #include "telemetry.hpp"
+#include "route_path.hpp"
+#include "conflict_zones.hpp"
+#include "gnss_error.hpp"
+#include "kalman_filter.hpp"
+#include "production_kpi.hpp"
 #include <vector>
 #include <string>
 #include <unordered_map>
 #include <memory>
+#include <random>
 
 namespace mineguard {
 
@@ -26,11 +32,35 @@ struct Route {
 
 // Estado de navegacao de um veiculo
 struct NavigationState {
-    Route current_route;
+    const Route* current_route;   // rota compartilhada do FleetManager (trocar rota nao aloca)
     size_t current_waypoint_index;
     double arrival_threshold;     // metros - distancia pra considerar "chegou"
     double wait_timer;            // segundos restantes de espera (loading/dumping)
     bool waiting;
+    const RoutePath* path;        // polilinha pre-calculada da rota (nullptr = sem rota)
+    double speed_factor = 1.0;    // multiplica as velocidades de cruzeiro (FleetVariation)
+    double dwell_factor = 1.0;    // multiplica os tempos de carga/descarga
+    VehicleHandle loader{VehicleHandle::INVALID_SLOT, 0};  // escavadeira que carrega (LOADING)
+};
+
+// Variacao aleatoria da frota pra analise de seguranca em lote
+// (batch_runner.hpp). Cada veiculo sorteia um fator de velocidade e um
+// de tempo de carga/descarga no spawn; scatter_cycles() avanca cada um
+// um tempo proprio no ciclo. Sem set_variation: frota nominal.
+struct FleetVariation {
+    uint64_t seed;
+    double speed_jitter;       // fracao: velocidades x U(1-j, 1+j)
+    double dwell_jitter;       // fracao: carga/descarga x U(1-j, 1+j)
+    double start_offset_max;   // segundos: cada veiculo avanca U(0, max) no ciclo
+
+    static FleetVariation create_default();
+};
+
+// Trecho de estrada entre dois waypoints consecutivos de uma rota
+struct RoadSection {
+    std::string name;          // "ROAD_1-ROAD_2"
+    Position from;
+    Position to;
 };
 
 class FleetManager {
@@ -40,31 +70,170 @@ public:
     void initialize();
     void update(double delta_time);
 
-    const std::vector<std::unique_ptr<Vehicle>>& vehicles() const { return vehicles_; }
+    // Navegacao + fisica de um veiculo vivo. Slots diferentes podem ser
+    // atualizados em threads diferentes (so tocam o proprio slot).
+    // Quem chama update_slot direto avanca o relogio antes (advance_clock).
+    void update_slot(uint32_t slot, double delta_time);
+
+    // Relogio da frota: tempo de simulacao (s) no fim do tick corrente.
+    // update() avanca sozinho; os eventos de ciclo usam esse tempo.
+    void advance_clock(double delta_time) { clock_ += delta_time; }
+    double clock() const { return clock_; }
+
+    const MineLayout& mine() const { return mine_; }
+
+    // Trechos das rotas (ida e volta pelo mesmo trecho contam uma vez)
+    std::vector<RoadSection> road_sections() const;
+
+    // Sorteio por veiculo nos spawns seguintes (chamar antes de initialize)
+    void set_variation(const FleetVariation& variation);
+
+    // Avanca cada veiculo vivo um tempo sorteado no ciclo, um por vez:
+    // a frota sai do tick 0 dessincronizada. Sem variacao: nada.
+    void scatter_cycles();
+
+    // Lista compacta dos veiculos vivos (ordem muda em despawn)
+    const std::vector<Vehicle*>& vehicles() const { return active_; }
+    const std::vector<uint32_t>& active_slots() const { return active_slots_; }
+    size_t vehicle_count() const { return active_.size(); }
+
+    // Entrada de veiculo (troca de turno, volta da manutencao). Comeca no
+    // inicio do ciclo do tipo: caminhao carregando no pit, escavadeira no
+    // pit, veiculo leve na patrulha. Reusa um slot livre se houver.
+    // Retorna handle invalido se o ID ja esta na frota.
+    VehicleHandle spawn_vehicle(const std::string& id, VehicleType type);
+
+    // Saida de veiculo (quebra, fim de turno). O slot volta pro pool e a
+    // geracao avanca: handles antigos passam a falhar em get().
+    bool despawn_vehicle(VehicleHandle handle);
+
+    // nullptr se o handle e de um veiculo que ja saiu
+    Vehicle* get(VehicleHandle handle);
+    const Vehicle* get(VehicleHandle handle) const;
+
+    // Busca linear por ID (entrada/saida sao raras)
+    VehicleHandle find_vehicle(const std::string& id) const;
+
     std::vector<TelemetryPacket> collect_telemetry() const;
 
+    // Preenche o buffer do chamador; sem alocar quando ele ja tem o
+    // tamanho da frota (caso normal do loop principal).
+    // timestamp: epoch ms do tick, o mesmo pra todos os pacotes
+    void collect_telemetry(std::vector<TelemetryPacket>& out, int64_t timestamp) const;
+
+    // Sob sobrecarga: veiculo parado so entra a cada stationary_interval
+    // ticks (escalonado pelo slot pra nao juntar todos no mesmo tick)
+    void collect_telemetry(std::vector<TelemetryPacket>& out, int64_t timestamp,
+                           uint64_t tick, uint32_t stationary_interval) const;
+
+    // Pipeline de GNSS: erro no fix de cada veiculo (o pacote leva o fix
+    // bruto; sem fix em dropout, o veiculo nao manda pacote) e filtro de
+    // Kalman da frota, cuja estimativa e o que o detector enxerga.
+    void enable_gnss(const GnssErrorConfig& error, const KalmanConfig& filter);
+    bool gnss_enabled() const { return gnss_error_ != nullptr; }
+
+    // Fix + filtro de todos os veiculos vivos. Depois do update, antes
+    // da coleta de telemetria e da colisao (sem pipeline: nada).
+    void sense(double delta_time);
+
+    // Veiculos sem fix no ultimo sense
+    size_t gnss_dropouts() const { return gnss_dropouts_; }
+
+    // KPIs de producao alimentados pelas transicoes de ciclo dos
+    // caminhoes (advance_cycle / handle_route_complete). Sem chamar:
+    // nenhum evento e registrado.
+    void enable_kpi(const KpiConfig& config);
+    ProductionKpi* kpi() { return kpi_.get(); }
+
+    // Zonas de conflito da malha de rotas (montada em initialize)
+    const ConflictZoneTable& conflict_zones() const { return conflict_zones_; }
+
+    // Memoria residente da frota: por veiculo (objeto, unique_ptr, no do
+    // mapa de navegacao) e compartilhada (waypoints, rotas, zonas)
+    MemoryFootprint footprint() const;
+
 private:
+    // Slot do pool. O Vehicle e alocado no primeiro uso e reusado no
+    // lugar pelos spawns seguintes; o endereco nao muda quando slots_ cresce.
+    struct VehicleSlot {
+        std::unique_ptr<Vehicle> vehicle;
+        NavigationState nav;
+        uint32_t generation;
+        uint32_t active_index;    // posicao em active_ (INACTIVE = slot livre)
+    };
+
+    static constexpr uint32_t INACTIVE = UINT32_MAX;
+
     void create_fleet();
-    void setup_routes();
+    VehicleHandle spawn(const std::string& id, VehicleType type, const Position& start,
+                        const NavigationState& nav, CycleState state, double target_speed);
+    NavigationState initial_nav(VehicleType type) const;
     void update_navigation(Vehicle& vehicle, NavigationState& nav, double dt);
     void advance_cycle(Vehicle& vehicle, NavigationState& nav);
     void handle_route_complete(Vehicle& vehicle, NavigationState& nav);
 
+    // Caminhao em LOADING: guarda a escavadeira do ponto de carga na nav
+    // e no Vehicle (o detector so dispensa o par com ela)
+    void assign_loader(Vehicle& vehicle, NavigationState& nav, VehicleHandle loader);
+
     double calculate_heading(const Position& from, const Position& to) const;
     double calculate_distance(const Position& a, const Position& b) const;
 
     Route get_haul_route() const;
     Route get_return_route() const;
+    Route get_patrol_route() const;
+
+    void build_route_paths();
+    RoutePath build_path(const Route& route, bool closed) const;
 
     MineLayout mine_;
-    std::vector<std::unique_ptr<Vehicle>> vehicles_;
-    std::unordered_map<std::string, NavigationState> nav_states_;
+
+    // Pool de slots + lista compacta dos vivos (swap-remove no despawn)
+    std::vector<VehicleSlot> slots_;
+    std::vector<uint32_t> free_slots_;
+    std::vector<Vehicle*> active_;
+    std::vector<uint32_t> active_slots_;   // slot de cada entrada de active_
+
+    // Rotas montadas uma vez no startup (ponteiros estaveis usados por NavigationState)
+    Route haul_route_;
+    Route return_route_;
+    Route patrol_route_;
+    Route excavator_route_;
+
+    // Escavadeira que opera o ponto de carga (PIT_LOAD_1). So muda em
+    // spawn/despawn, fora da fase paralela dos shards.
+    VehicleHandle loading_excavator_;
+
+    // Tabelas de arco das rotas (ponteiros estaveis usados por NavigationState)
+    RoutePath haul_path_;
+    RoutePath return_path_;
+    RoutePath patrol_path_;
+    ConflictZoneTable conflict_zones_;
+
+    // Pipeline de GNSS (nullptr = desligado). Plano local fixo pra frota:
+    // origem no canto sudoeste dos waypoints.
+    std::unique_ptr<GnssErrorModel> gnss_error_;
+    std::unique_ptr<FleetKalmanFilter> gnss_filter_;
+    Position gnss_origin_;
+    double m_per_deg_lat_;
+    double m_per_deg_lon_;
+    size_t gnss_dropouts_;
+
+    // KPIs de producao (nullptr = desligado)
+    std::unique_ptr<ProductionKpi> kpi_;
+    double clock_;
+
+    // Variacao de cenario (sem variacao: nenhum sorteio, frota nominal)
+    bool varied_;
+    FleetVariation variation_;
+    std::mt19937_64 variation_rng_;
 
     // Velocidades por estado do ciclo (km/h)
     static constexpr double HAUL_SPEED = 35.0;
     static constexpr double RETURN_SPEED = 40.0;
     static constexpr double APPROACH_SPEED = 10.0;
     static constexpr double LV_PATROL_SPEED = 45.0;
+    static constexpr double STATIONARY_SPEED = 1.0;  // km/h - abaixo disso conta como parado
     static constexpr double LOADING_TIME = 120.0;    // segundos
     static constexpr double DUMPING_TIME = 45.0;     // segundos
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#ifndef GNSS_ERROR_HPP
+#define GNSS_ERROR_HPP
+
+#include <vector>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// Erro do receptor GNSS de cada veiculo, aplicado na posicao simulada
+// antes do pacote de telemetria:
+//   fix = verdade + vies + ruido branco
+// O vies anda como passeio aleatorio (multipath, ionosfera) e e
+// refletido em bias_limit. Dropout: o receptor perde o fix por um
+// tempo exponencial de media dropout_mean.
+struct GnssErrorConfig {
+    double white_sigma;       // metros por eixo, independente a cada fix
+    double bias_walk_sigma;   // metros / sqrt(s)
+    double bias_limit;        // metros por eixo
+    double dropout_rate;      // dropouts por segundo por veiculo
+    double dropout_mean;      // segundos
+    uint64_t seed;
+
+    static GnssErrorConfig create_default();
+};
+
+// Estado do erro por slot do pool da frota (SoA). Um gerador so pra
+// frota toda: com a mesma semente e a mesma ordem de slots a sequencia
+// de fixes se repete.
+class GnssErrorModel {
+public:
+    explicit GnssErrorModel(const GnssErrorConfig& config);
+
+    const GnssErrorConfig& config() const { return config_; }
+
+    // Garante estado pra slots [0, slots)
+    void resize(size_t slots);
+
+    // Veiculo novo no slot: vies zerado, sem dropout
+    void reset_slot(uint32_t slot);
+
+    // Erro do fix deste tick (metros leste/norte). false = sem fix (dropout)
+    bool sample(uint32_t slot, double delta_time, double& ex, double& ey);
+
+    size_t heap_bytes() const;
+
+private:
+    double reflect(double bias) const;
+
+    GnssErrorConfig config_;
+    std::mt19937_64 rng_;
+    std::normal_distribution<double> normal_;
+    std::uniform_real_distribution<double> uniform_;
+
+    std::vector<double> bias_x_;
+    std::vector<double> bias_y_;
+    std::vector<double> dropout_left_;   // segundos sem fix restantes
+};
+
+} // namespace mineguard
+
+#endif // GNSS_ERROR_HPP
@@ -4,90 +4,264 @@
 #define JSON_SERIALIZER_HPP
 
 #include "telemetry.hpp"
+#include "near_miss_heatmap.hpp"
+#include "production_kpi.hpp"
 #include <string>
 #include <vector>
-#include <sstream>
-#include <iomanip>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 
 namespace mineguard {
 
+// Serializacao direto num std::string do chamador. As versoes
+// append_* / serialize_batch(..., out) nao alocam quando o buffer
+// ja tem capacidade (o loop principal reusa o mesmo string a cada tick).
 class JsonSerializer {
 public:
+    // Versao do protocolo anunciada no handshake
+    static constexpr int PROTOCOL_VERSION = 1;
+
+    static void append(std::string& out, const TelemetryPacket& packet) {
+        out += "{";
+        out += "\"type\":\"telemetry\",";
+        out += "\"vehicle_id\":\""; out += packet.vehicle_id; out += "\",";
+        out += "\"timestamp\":"; append_int(out, packet.timestamp); out += ",";
+        out += "\"vehicle_type\":"; append_int(out, packet.vehicle_type); out += ",";
+        out += "\"cycle_state\":"; append_int(out, packet.cycle_state); out += ",";
+
+        out += "\"position\":{";
+        out += "\"latitude\":"; append_fixed(out, packet.position.latitude, 6); out += ",";
+        out += "\"longitude\":"; append_fixed(out, packet.position.longitude, 6); out += ",";
+        out += "\"altitude\":"; append_fixed(out, packet.position.altitude, 1);
+        out += "},";
+
+        out += "\"telemetry\":{";
+        out += "\"speed\":"; append_fixed(out, packet.telemetry.speed, 2); out += ",";
+        out += "\"heading\":"; append_fixed(out, packet.telemetry.heading, 2); out += ",";
+        out += "\"payload\":"; append_fixed(out, packet.telemetry.payload, 2); out += ",";
+        out += "\"fuel_level\":"; append_fixed(out, packet.telemetry.fuel_level, 2); out += ",";
+        out += "\"engine_rpm\":"; append_fixed(out, packet.telemetry.engine_rpm, 2);
+        out += "}";
+
+        out += "}";
+    }
+
+    static void append(std::string& out, const CollisionAlert& alert) {
+        out += "{";
+        out += "\"type\":\"alert\",";
+        out += "\"vehicle_id_1\":\""; out += alert.vehicle_id_1; out += "\",";
+        out += "\"vehicle_id_2\":\""; out += alert.vehicle_id_2; out += "\",";
+        out += "\"priority\":"; append_int(out, static_cast<int>(alert.priority)); out += ",";
+        out += "\"alert_type\":"; append_int(out, static_cast<int>(alert.type)); out += ",";
+        out += "\"time_to_impact\":"; append_fixed(out, alert.time_to_impact, 2); out += ",";
+        out += "\"distance\":"; append_fixed(out, alert.distance, 2); out += ",";
+        out += "\"probability\":"; append_fixed(out, alert.probability, 3); out += ",";
+        out += "\"cpa\":{";
+        out += "\"latitude\":"; append_fixed(out, alert.cpa.latitude, 6); out += ",";
+        out += "\"longitude\":"; append_fixed(out, alert.cpa.longitude, 6);
+        out += "},";
+        out += "\"timestamp\":"; append_int(out, alert.timestamp);
+        out += "}";
+    }
+
+    // Tile do mapa de calor: camadas pelo nome da prioridade/tipo,
+    // cada uma no run-length esparso de HeatmapTile
+    static void append(std::string& out, const HeatmapTile& tile) {
+        static const char* const LAYER_NAMES[HEATMAP_LAYERS] = {
+            "LOW", "MEDIUM", "HIGH", "CRITICAL",
+            "APPROACH", "CROSSING", "TAILGATING", "BLIND_SPOT"
+        };
+
+        out += "{";
+        out += "\"timestamp\":"; append_int(out, tile.timestamp); out += ",";
+        out += "\"origin\":{";
+        out += "\"latitude\":"; append_fixed(out, tile.origin.latitude, 6); out += ",";
+        out += "\"longitude\":"; append_fixed(out, tile.origin.longitude, 6);
+        out += "},";
+        out += "\"cell_size\":"; append_fixed(out, tile.cell_size, 1); out += ",";
+        out += "\"cols\":"; append_int(out, tile.cols); out += ",";
+        out += "\"rows\":"; append_int(out, tile.rows); out += ",";
+        out += "\"half_life\":"; append_fixed(out, tile.half_life, 0); out += ",";
+        out += "\"scale\":"; append_int(out, tile.scale); out += ",";
+        out += "\"events\":"; append_fixed(out, tile.events, 2); out += ",";
+        out += "\"outside\":"; append_int(out, tile.outside); out += ",";
+
+        out += "\"layers\":{";
+        for (size_t l = 0; l < HEATMAP_LAYERS; l++) {
+            if (l > 0) out += ",";
+            out += "\""; out += LAYER_NAMES[l]; out += "\":[";
+            const std::vector<uint32_t>& runs = tile.layers[l];
+            for (size_t i = 0; i < runs.size(); i++) {
+                if (i > 0) out += ",";
+                append_int(out, runs[i]);
+            }
+            out += "]";
+        }
+        out += "}";
+
+        out += "}";
+    }
+
+    // Frame de KPIs: uma linha de valores por janela, na ordem de
+    // "fields"; null onde a janela nao tem dados
+    static void append(std::string& out, const KpiReport& report) {
+        out += "{";
+        out += "\"timestamp\":"; append_int(out, report.timestamp); out += ",";
+        out += "\"windows\":[";
+        for (size_t w = 0; w < KPI_WINDOWS; w++) {
+            if (w > 0) out += ",";
+            append_fixed(out, report.windows[w], 0);
+        }
+        out += "],";
+        out += "\"fields\":[\"cycles\",\"cycle_time\",\"tonnes\",\"tonnes_per_hour\",\"queue_time\",\"fuel_per_tonne\"],";
+
+        out += "\"fleet\":[";
+        for (size_t w = 0; w < KPI_WINDOWS; w++) {
+            if (w > 0) out += ",";
+            append_kpi(out, report.fleet[w]);
+        }
+        out += "],";
+
+        out += "\"vehicles\":{";
+        for (size_t i = 0; i < report.vehicle_ids.size(); i++) {
+            if (i > 0) out += ",";
+            out += "\""; out += report.vehicle_ids[i]; out += "\":[";
+            for (size_t w = 0; w < KPI_WINDOWS; w++) {
+                if (w > 0) out += ",";
+                append_kpi(out, report.vehicles[i * KPI_WINDOWS + w]);
+            }
+            out += "]";
+        }
+        out += "}";
+
+        out += "}";
+    }
+
     static std::string serialize(const TelemetryPacket& packet) {
-        std::ostringstream ss;
-        ss << std::fixed << std::setprecision(6);
-
-        ss << "{";
-        ss << "\"type\":\"telemetry\",";
-        ss << "\"vehicle_id\":\"" << packet.vehicle_id << "\",";
-        ss << "\"timestamp\":" << packet.timestamp << ",";
-        ss << "\"vehicle_type\":" << packet.vehicle_type << ",";
-        ss << "\"cycle_state\":" << packet.cycle_state << ",";
-
-        ss << "\"position\":{";
-        ss << "\"latitude\":" << packet.position.latitude << ",";
-        ss << "\"longitude\":" << packet.position.longitude << ",";
-        ss << "\"altitude\":" << std::setprecision(1) << packet.position.altitude;
-        ss << "},";
-
-        ss << std::setprecision(2);
-        ss << "\"telemetry\":{";
-        ss << "\"speed\":" << packet.telemetry.speed << ",";
-        ss << "\"heading\":" << packet.telemetry.heading << ",";
-        ss << "\"payload\":" << packet.telemetry.payload << ",";
-        ss << "\"fuel_level\":" << packet.telemetry.fuel_level << ",";
-        ss << "\"engine_rpm\":" << packet.telemetry.engine_rpm;
-        ss << "}";
-
-        ss << "}";
-        return ss.str();
+        std::string out;
+        append(out, packet);
+        return out;
     }
 
     static std::string serialize(const CollisionAlert& alert) {
-        std::ostringstream ss;
-        ss << std::fixed << std::setprecision(2);
-
-        ss << "{";
-        ss << "\"type\":\"alert\",";
-        ss << "\"vehicle_id_1\":\"" << alert.vehicle_id_1 << "\",";
-        ss << "\"vehicle_id_2\":\"" << alert.vehicle_id_2 << "\",";
-        ss << "\"priority\":" << static_cast<int>(alert.priority) << ",";
-        ss << "\"alert_type\":" << static_cast<int>(alert.type) << ",";
-        ss << "\"time_to_impact\":" << alert.time_to_impact << ",";
-        ss << "\"distance\":" << alert.distance << ",";
-        ss << "\"timestamp\":" << alert.timestamp;
-        ss << "}";
-
-        return ss.str();
+        std::string out;
+        append(out, alert);
+        return out;
     }
 
-    static std::string serialize_batch(
+    // tick_id: contador monotonico do loop principal
+    // sent_at: epoch ms no momento do envio (backend mede latencia a partir dele)
+    // heatmap: tile do mapa de calor, so nos ticks de publicacao (nullptr = sem campo)
+    // kpi: frame de KPIs de producao, idem
+    // out e limpo e reescrito; a capacidade e mantida entre ticks
+    static void serialize_batch(
         const std::vector<TelemetryPacket>& packets,
-        const std::vector<CollisionAlert>& alerts
+        const std::vector<CollisionAlert>& alerts,
+        uint64_t tick_id,
+        int64_t sent_at,
+        std::string& out,
+        const HeatmapTile* heatmap = nullptr,
+        const KpiReport* kpi = nullptr
     ) {
-        std::ostringstream ss;
+        out.clear();
 
-        ss << "{";
-        ss << "\"type\":\"batch\",";
+        out += "{";
+        out += "\"type\":\"batch\",";
+        out += "\"tick_id\":"; append_int(out, tick_id); out += ",";
+        out += "\"sent_at\":"; append_int(out, sent_at); out += ",";
 
         // Telemetria
-        ss << "\"telemetry\":[";
+        out += "\"telemetry\":[";
         for (size_t i = 0; i < packets.size(); i++) {
-            if (i > 0) ss << ",";
-            ss << serialize(packets[i]);
+            if (i > 0) out += ",";
+            append(out, packets[i]);
         }
-        ss << "],";
+        out += "],";
 
         // Alertas
-        ss << "\"alerts\":[";
+        out += "\"alerts\":[";
         for (size_t i = 0; i < alerts.size(); i++) {
-            if (i > 0) ss << ",";
-            ss << serialize(alerts[i]);
+            if (i > 0) out += ",";
+            append(out, alerts[i]);
         }
-        ss << "]";
+        out += "]";
+
+        if (heatmap) {
+            out += ",\"heatmap\":";
+            append(out, *heatmap);
+        }
+
+        if (kpi) {
+            out += ",\"kpi\":";
+            append(out, *kpi);
+        }
+
+        out += "}";
+    }
+
+    static std::string serialize_batch(
+        const std::vector<TelemetryPacket>& packets,
+        const std::vector<CollisionAlert>& alerts,
+        uint64_t tick_id,
+        int64_t sent_at
+    ) {
+        std::string out;
+        serialize_batch(packets, alerts, tick_id, sent_at, out);
+        return out;
+    }
+
+    // Handshake da sessao: primeiro frame de cada conexao.
+    // source_id identifica o gateway/simulador (ex.: um por cava).
+    // ack: pede ao backend um frame de ack por batch processado.
+    static std::string serialize_hello(const std::string& source_id, bool ack = false) {
+        std::string out;
+
+        out += "{";
+        out += "\"type\":\"hello\",";
+        out += "\"protocol\":"; append_int(out, PROTOCOL_VERSION); out += ",";
+        out += "\"source_id\":\""; out += source_id; out += "\"";
+        if (ack) out += ",\"ack\":true";
+        out += "}";
+
+        return out;
+    }
+
+private:
+    template <typename T>
+    static void append_int(std::string& out, T value) {
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, result.ptr - buf);
+    }
+
+    // [cycles, cycle_time, tonnes, tonnes_per_hour, queue_time, fuel_per_tonne]
+    static void append_kpi(std::string& out, const KpiValues& v) {
+        out += "[";
+        append_int(out, v.cycles); out += ",";
+        append_optional(out, v.cycle_time, 1); out += ",";
+        append_fixed(out, v.tonnes, 1); out += ",";
+        append_optional(out, v.tonnes_per_hour, 1); out += ",";
+        append_optional(out, v.queue_time, 1); out += ",";
+        append_optional(out, v.fuel_per_tonne, 3);
+        out += "]";
+    }
+
+    // NAN vira null
+    static void append_optional(std::string& out, double value, int precision) {
+        if (std::isnan(value)) {
+            out += "null";
+            return;
+        }
+        append_fixed(out, value, precision);
+    }
 
-        ss << "}";
-        return ss.str();
+    // Mesmo formato de std::fixed + setprecision
+    static void append_fixed(std::string& out, double value, int precision) {
+        char buf[64];
+        int n = std::snprintf(buf, sizeof(buf), "%.*f", precision, value);
+        if (n < 0) return;
+        out.append(buf, n < static_cast<int>(sizeof(buf)) ? n : sizeof(buf) - 1);
     }
 };
 
@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef KALMAN_FILTER_HPP
+#define KALMAN_FILTER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// Ruidos do filtro de velocidade constante
+struct KalmanConfig {
+    double accel_sigma;             // m/s^2 - aceleracao nao modelada (processo)
+    double measurement_sigma;       // metros por eixo - ruido do fix
+    double initial_velocity_sigma;  // m/s - incerteza da velocidade no primeiro fix
+
+    static KalmanConfig create_default();
+};
+
+// Filtro de Kalman de velocidade constante pra frota inteira.
+//
+// Estado por slot: posicao e velocidade no plano local (metros, m/s).
+// Com ruido isotropico, os eixos leste e norte tem a mesma covariancia
+// 2x2 [pp pv; pv vv], guardada uma vez por slot. Tudo em SoA: step() e
+// um laco sem desvios sobre todos os slots (o fix entra como peso 0/1
+// no ganho), vetorizado pelo compilador.
+//
+// Nao depende de Vehicle: a mesma classe filtra fixes reais vindos de
+// fora, so precisa de slot estavel por fonte e das medidas no plano local.
+class FleetKalmanFilter {
+public:
+    explicit FleetKalmanFilter(const KalmanConfig& config);
+
+    // Garante estado pra slots [0, slots)
+    void resize(size_t slots);
+    size_t size() const { return x_.size(); }
+
+    // Fonte nova no slot: o proximo fix reinicia o filtro
+    void reset(uint32_t slot);
+
+    // Fix do tick pro slot (plano local, metros). Slot sem medida no
+    // tick so e predito.
+    void measure(uint32_t slot, double x, double y);
+
+    // Predicao de dt + atualizacao com os fixes do tick, todos os slots
+    void step(double delta_time);
+
+    // Ja recebeu algum fix desde o reset
+    bool initialized(uint32_t slot) const { return init_[slot] != 0.0; }
+
+    double x(uint32_t slot) const { return x_[slot]; }
+    double y(uint32_t slot) const { return y_[slot]; }
+    double vx(uint32_t slot) const { return vx_[slot]; }
+    double vy(uint32_t slot) const { return vy_[slot]; }
+
+    // Desvio padrao da posicao estimada (metros por eixo)
+    double position_sigma(uint32_t slot) const;
+
+    size_t heap_bytes() const;
+
+private:
+    KalmanConfig config_;
+
+    std::vector<double> x_, y_, vx_, vy_;
+    std::vector<double> p_pp_, p_pv_, p_vv_;
+    std::vector<double> mx_, my_;
+    std::vector<double> fix_;     // 1 = medida no tick
+    std::vector<double> init_;    // 1 = filtro iniciado
+};
+
+} // namespace mineguard
+
+#endif // KALMAN_FILTER_HPP
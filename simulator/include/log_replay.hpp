@@ -0,0 +1,217 @@
+#pragma once
+
+#ifndef LOG_REPLAY_HPP
+#define LOG_REPLAY_HPP
+
+#include "vehicle.hpp"
+#include "collision.hpp"
+#include "kalman_filter.hpp"
+#include "alert_episodes.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// ============================================================
+// Replay de logs de GNSS da frota real pelo detector
+//
+// Formatos (uma amostra por linha):
+//   CSV:  timestamp,vehicle_id,latitude,longitude[,speed_kmh[,heading_deg[,type]]]
+//         timestamp em epoch (s ou ms, com fracao) ou ISO 8601 UTC
+//   NMEA: vehicle_id,$xxRMC,... (sentenca RMC com o ID do gravador na frente)
+//
+// O arquivo e mapeado em memoria e lido em lotes; cada lote e cortado
+// em pedacos nas quebras de linha e cada pedaco e parseado numa thread
+// sem alocar por linha. Enquanto o detector roda os ticks de um lote,
+// as threads ja parseiam o proximo.
+//
+// Ordem: dentro de um lote (--batch-mb) as amostras sao ordenadas por
+// tempo, entao o arquivo pode vir agrupado por veiculo ou por gravador.
+// Entre lotes o arquivo precisa estar em ordem de tempo: amostra de um
+// tick que ja rodou conta como late_samples e entra no tick atual.
+// Log maior que um lote e fora de ordem: ordenar antes pelo timestamp.
+//
+// Como no pipeline ao vivo (FleetManager::sense), os fixes passam pelo
+// FleetKalmanFilter e o detector enxerga a estimativa (posicao e
+// velocidade do filtro). Sem filtro, a amostra vai direto pro detector
+// e velocidade/rumo ausentes sao derivados da amostra anterior.
+// ============================================================
+
+enum class LogFormat {
+    AUTO = 0,
+    CSV,
+    NMEA
+};
+
+struct ReplayConfig {
+    double tick_seconds;     // passo do detector (amostras agrupadas por tick)
+    double stale_seconds;    // veiculo sem amostra ha mais que isso sai do tick
+    size_t threads;          // threads de parse (0 = hardware_concurrency)
+    size_t batch_bytes;      // bytes do arquivo por lote (dividido entre as threads)
+    LogFormat format;
+    bool filter;             // fixes pelo filtro de Kalman (false = amostra bruta)
+    KalmanConfig kalman;
+
+    static ReplayConfig create_default();
+};
+
+// Amostra parseada. vehicle e o indice local do pedaco ate o merge,
+// depois o indice global do replay.
+struct LogSample {
+    int64_t time_ms;
+    double latitude;
+    double longitude;
+    uint32_t vehicle;
+    float speed;             // km/h, NaN = derivar da amostra anterior
+    float heading;           // graus, NaN = derivar da amostra anterior
+};
+
+struct ReplayReport {
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    uint64_t samples = 0;
+    uint64_t bad_lines = 0;       // sem parse ou checksum NMEA errado
+    uint64_t skipped_lines = 0;   // cabecalho, sentenca sem fix ou nao RMC
+    uint64_t late_samples = 0;    // chegaram depois do tick delas (contam no tick atual)
+    uint64_t ticks = 0;
+    uint64_t gap_ticks = 0;       // ticks pulados sem nenhum veiculo ativo
+    size_t vehicles = 0;
+    int64_t first_ms = 0;
+    int64_t last_ms = 0;
+
+    // Por AlertPriority: eventos (ver AlertEpisodes) e ticks com alerta
+    uint64_t alert_events[5] = {};
+    uint64_t alert_ticks[5] = {};
+
+    double parse_seconds = 0.0;   // soma do tempo de parede dos lotes
+    double detect_seconds = 0.0;
+    double total_seconds = 0.0;
+
+    double span_hours() const { return (last_ms - first_ms) / 3600000.0; }
+    double late_fraction() const { return samples ? static_cast<double>(late_samples) / samples : 0.0; }
+};
+
+// Arquivo mapeado somente leitura (munmap no destrutor)
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // Paginas ja processadas podem sair do page cache
+    void release(size_t offset, size_t length) const;
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Parse de um pedaco [begin, end) do arquivo. IDs viram indices locais
+// (string_view apontando pro mapeamento, sem copia); no fim as amostras
+// sao ordenadas por tempo (estavel: empate fica na ordem do arquivo).
+// Buffers reusados entre lotes.
+struct LogChunk {
+    static constexpr uint32_t TYPE_UNKNOWN = UINT32_MAX;
+
+    std::vector<LogSample> samples;
+    std::vector<std::string_view> ids;
+    std::vector<uint32_t> types;     // VehicleType da coluna type (TYPE_UNKNOWN = sem coluna)
+    std::unordered_map<std::string_view, uint32_t> id_index;
+    uint64_t lines = 0;
+    uint64_t bad_lines = 0;
+    uint64_t skipped_lines = 0;
+
+    void clear();
+    void parse(const char* begin, const char* end, LogFormat format, bool first_in_file);
+
+private:
+    bool parse_csv(const char* begin, const char* end);
+    bool parse_nmea(const char* begin, const char* end, bool& skipped);
+    uint32_t intern(std::string_view id, uint32_t type);
+};
+
+class LogReplay {
+public:
+    explicit LogReplay(const ReplayConfig& config);
+
+    bool open(const std::string& path);
+
+    // Uma linha CSV por alerta novo (nullptr = so o relatorio)
+    void set_event_output(std::ostream* out) { events_ = out; }
+
+    // Roda o arquivo inteiro pelo detector, o mais rapido possivel
+    ReplayReport run(CollisionDetector& detector);
+
+    // Formato detectado na primeira linha com dado
+    LogFormat format() const { return format_; }
+
+    static LogFormat detect_format(const char* data, size_t size);
+
+private:
+    struct VehicleTrack {
+        std::unique_ptr<Vehicle> vehicle;
+        int64_t last_ms;
+        double last_heading;
+        bool seen;
+    };
+
+    void parse_batch(size_t begin, size_t end, std::vector<LogChunk>& chunks) const;
+    void merge_chunk(LogChunk& chunk);
+    void merge_batch(std::vector<LogChunk>& chunks, ReplayReport& report);
+    bool apply_sample(const LogSample& sample);
+    void update_estimates();
+    void run_tick(CollisionDetector& detector, ReplayReport& report);
+    int64_t tick_start_ms(uint64_t tick) const;
+
+    ReplayConfig config_;
+    LogFormat format_;
+    MappedFile file_;
+    std::ostream* events_;
+
+    // Veiculos do log (indice global = slot no detector). As chaves
+    // apontam pro id() de cada Vehicle, que nao muda de endereco.
+    std::vector<VehicleTrack> tracks_;
+    std::unordered_map<std::string_view, uint32_t> global_ids_;
+    std::vector<uint32_t> remap_;          // local -> global do pedaco em merge
+
+    // Amostras do lote em ordem de tempo; runs_ = limites dos pedacos
+    // ainda nao intercalados
+    std::vector<LogSample> batch_;
+    std::vector<size_t> runs_;
+
+    // Filtro no plano local (origem na primeira amostra do log, slot =
+    // indice global do veiculo)
+    FleetKalmanFilter filter_;
+    Position plane_origin_;
+    double m_per_deg_lon_;
+
+    // Tick corrente
+    bool started_;
+    int64_t origin_ms_;
+    int64_t tick_ms_;
+    uint64_t tick_;
+    int64_t newest_ms_;
+    std::vector<Vehicle*> active_;
+    std::vector<CollisionAlert> alerts_;
+
+    // Episodios dos pares com alerta no tick anterior, pra contar eventos
+    AlertEpisodes episodes_;
+};
+
+} // namespace mineguard
+
+#endif // LOG_REPLAY_HPP
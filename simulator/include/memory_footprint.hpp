@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef MEMORY_FOOTPRINT_HPP
+#define MEMORY_FOOTPRINT_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace mineguard {
+
+// Bytes residentes de uma estrutura, separados pelo que escala com a
+// frota (por veiculo), com o numero de pares (cache do detector) e o
+// que e fixo da mina (rotas, zonas). Estimativa pela capacidade dos
+// containers; nao inclui o overhead do malloc.
+struct MemoryFootprint {
+    size_t vehicles;        // veiculos contados em per_vehicle_bytes
+    size_t per_vehicle_bytes;
+    size_t pair_entries;
+    size_t pair_bytes;
+    size_t shared_bytes;
+};
+
+namespace footprint {
+
+// Heap do string (zero quando cabe no buffer interno / SSO)
+inline size_t heap_bytes(const std::string& s) {
+    static const size_t sso_capacity = std::string().capacity();
+    return s.capacity() > sso_capacity ? s.capacity() + 1 : 0;
+}
+
+template <typename T>
+inline size_t heap_bytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// Buckets + um no por elemento (ponteiro next + valor + hash guardado)
+template <typename K, typename V, typename H, typename E, typename A>
+inline size_t heap_bytes(const std::unordered_map<K, V, H, E, A>& m) {
+    return m.bucket_count() * sizeof(void*) +
+           m.size() * (sizeof(void*) + sizeof(std::pair<const K, V>) + sizeof(size_t));
+}
+
+} // namespace footprint
+
+} // namespace mineguard
+
+#endif // MEMORY_FOOTPRINT_HPP
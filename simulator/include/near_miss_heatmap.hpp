@@ -0,0 +1,116 @@
+#pragma once
+
+#ifndef NEAR_MISS_HEATMAP_HPP
+#define NEAR_MISS_HEATMAP_HPP
+
+#include "telemetry.hpp"
+#include "alert_episodes.hpp"
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// ============================================================
+// Mapa de calor de quase-colisoes numa grade metrica fixa
+//
+// Cada evento (par que comeca a alertar, ou que sobe de prioridade
+// no mesmo episodio; ver AlertEpisodes) soma 1 na celula do CPA previsto, numa camada
+// por prioridade e numa por tipo. A contagem decai exponencialmente
+// com meia-vida fixa, sem varrer a grade a cada tick: cada evento
+// novo entra com peso 2^(t / meia-vida) e a escala volta a 1 quando
+// o peso fica grande. O tile publicado ja sai no valor decaido.
+// ============================================================
+
+struct HeatmapConfig {
+    double cell_size;          // metros
+    double margin;             // metros em volta da area das rotas
+    double half_life;          // segundos - evento vale metade depois disso
+    double publish_interval;   // segundos entre tiles
+
+    static HeatmapConfig create_default();
+};
+
+// Camadas do tile: 4 prioridades (LOW..CRITICAL) e 4 tipos (AlertType)
+constexpr size_t HEATMAP_PRIORITY_LAYERS = 4;
+constexpr size_t HEATMAP_TYPE_LAYERS = 4;
+constexpr size_t HEATMAP_LAYERS = HEATMAP_PRIORITY_LAYERS + HEATMAP_TYPE_LAYERS;
+
+// Tile compacto: contagem decaida x scale, arredondada, por camada.
+// Grade em linhas a partir do canto sudoeste (linha 0 = sul, coluna
+// 0 = oeste), celula (row, col) no indice row * cols + col. Celula em
+// graus: cell_size / (R * pi/180) de latitude, dividido por
+// cos(origin.latitude) na longitude.
+//
+// Cada camada e um run-length esparso: pares (zeros pulados, n)
+// seguidos dos n valores nao nulos. Zeros no fim nao entram.
+struct HeatmapTile {
+    int64_t timestamp;         // epoch ms do tick publicado
+    Position origin;           // canto sudoeste da grade
+    double cell_size;          // metros
+    size_t cols;
+    size_t rows;
+    double half_life;          // segundos
+    int scale;                 // valor no tile = contagem * scale
+    double events;             // soma decaida dos eventos dentro da grade
+    uint64_t outside;          // eventos com CPA fora da grade (sem decaimento)
+    std::vector<uint32_t> layers[HEATMAP_LAYERS];
+};
+
+class NearMissHeatmap {
+public:
+    // Grade cobre a caixa [south_west, north_east] + margem
+    NearMissHeatmap(const HeatmapConfig& config, const Position& south_west, const Position& north_east);
+
+    // Alertas do tick (todos os shards). now: tempo de simulacao em segundos
+    void record(const std::vector<CollisionAlert>& alerts, double now);
+
+    // Hora de publicar? (a cada publish_interval de simulacao)
+    bool publish_due(double now) const { return now >= next_publish_; }
+
+    // Preenche o tile com o estado decaido em now (buffers reusados)
+    // e agenda a proxima publicacao. timestamp: epoch ms do tick
+    void publish(double now, int64_t timestamp, HeatmapTile& tile);
+
+    size_t cols() const { return cols_; }
+    size_t rows() const { return rows_; }
+    uint64_t events_recorded() const { return events_recorded_; }
+
+    // Valor no tile = contagem * TILE_SCALE (2 casas)
+    static constexpr int TILE_SCALE = 100;
+
+private:
+    // Celula do ponto, ou SIZE_MAX fora da grade
+    size_t cell_of(const Position& p) const;
+
+    // Traz o peso de volta a 1 (multiplica a grade toda)
+    void renormalize(double now);
+
+    HeatmapConfig config_;
+    Position origin_;
+    double m_per_deg_lat_;
+    double m_per_deg_lon_;
+    size_t cols_;
+    size_t rows_;
+
+    // Soma de 2^((t_evento - t0) / meia-vida) por celula; a contagem
+    // decaida em t e isso vezes 2^(-(t - t0) / meia-vida)
+    std::vector<float> cells_[HEATMAP_LAYERS];
+    double weight_origin_;     // t0 da escala atual (segundos)
+    double events_;            // soma das prioridades, na mesma escala
+
+    // Episodios dos pares alertando no tick anterior
+    AlertEpisodes episodes_;
+
+    double next_publish_;
+    uint64_t events_recorded_;
+    uint64_t outside_;
+
+    // Peso maximo antes de renormalizar (8 meias-vidas): a precisao do
+    // float fica folgada pra somar eventos novos em celulas antigas
+    static constexpr double RENORMALIZE_WEIGHT = 256.0;
+};
+
+} // namespace mineguard
+
+#endif // NEAR_MISS_HEATMAP_HPP
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef OVERLOAD_GOVERNOR_HPP
+#define OVERLOAD_GOVERNOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+namespace mineguard {
+
+// Niveis de degradacao, em ordem de corte. Cada nivel inclui os anteriores.
+// Pares perto ou com alerta MEDIUM ou acima nunca sao degradados.
+enum class DegradationLevel {
+    NORMAL = 0,
+    COARSE_FAR,          // pares longe/LOW com metade das amostras do horizonte
+    COARSER_FAR,         // pares longe/LOW com 1/4 das amostras
+    DEFER_STATIONARY     // + telemetria de veiculo parado so a cada N ticks
+};
+
+// Compara o custo do tick com o periodo e ajusta o nivel pro proximo tick.
+// Sobe na hora quando o custo passa do limite alto (tick atrasado e
+// pior que horizonte mais grosso em par LOW); desce um nivel so depois
+// de RELAX_TICKS ticks seguidos abaixo do limite baixo.
+class OverloadGovernor {
+public:
+    explicit OverloadGovernor(int64_t budget_us);
+
+    // Custo do tick que acabou (inicio do trabalho ate o fim do envio)
+    void observe(int64_t tick_cost_us);
+
+    DegradationLevel level() const { return level_; }
+
+    // Passo entre amostras da trajetoria pros pares que podem degradar
+    size_t coarse_stride() const;
+
+    // Intervalo (ticks) da telemetria de veiculo parado; 1 = todo tick
+    uint32_t stationary_interval() const;
+
+    // Trocas de nivel desde o inicio
+    uint64_t transitions() const { return transitions_; }
+
+    static const char* level_name(DegradationLevel level);
+
+    static constexpr double RAISE_FRACTION = 0.7;     // do periodo
+    static constexpr double RELAX_FRACTION = 0.35;
+    static constexpr uint32_t RELAX_TICKS = 10;
+    static constexpr uint32_t STATIONARY_INTERVAL = 5;
+
+private:
+    int64_t budget_us_;
+    DegradationLevel level_;
+    uint32_t calm_ticks_;
+    uint64_t transitions_;
+};
+
+} // namespace mineguard
+
+#endif // OVERLOAD_GOVERNOR_HPP
@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef PAIR_POLICY_HPP
+#define PAIR_POLICY_HPP
+
+#include "vehicle.hpp"
+#include <cstddef>
+
+namespace mineguard {
+
+// ============================================================
+// Politica de predicao por classe de par
+//
+// Indexada por (tipo A, tipo B, estado do ciclo de A) com A <= B na
+// ordem de VehicleType; o estado e o do veiculo de tipo menor (o
+// caminhao nos pares com caminhao). Resolvida em tempo de compilacao:
+// cada combinacao vira uma instancia de check_pair com as constantes
+// embutidas, e o detector escolhe a instancia numa tabela de ponteiros.
+//
+// HORIZON tem que ser multiplo de PREDICTION_STEP e no maximo
+// MAX_PREDICTION_TIME; CUTOFF no maximo MAX_PAIR_DISTANCE (alcance do
+// halo entre shards). O detector confere com static_assert.
+// ============================================================
+
+// Padrao: horizonte cheio, todas as amostras
+template <VehicleType A, VehicleType B, CycleState S>
+struct PairPolicy {
+    static constexpr bool EVALUATE = true;
+    static constexpr double HORIZON = 15.0;     // segundos
+    static constexpr size_t STEP = 1;           // amostras de PREDICTION_STEP entre testes
+    static constexpr double CUTOFF = 500.0;     // metros - distancia atual maxima
+    static constexpr double MIN_SPEED = 1.0;    // km/h - os dois abaixo disso: sem risco
+};
+
+// Caminhao x escavadeira: aproximacao lenta na frente de lavra, corte
+// menor (caminhao a 45 km/h e escavadeira a 5 km/h fecham ~210 m em
+// 15 s). O horizonte fica nos 15 s: LOW e TTI de 10
+// a 15 s, e um horizonte menor tiraria a faixa LOW dessa classe.
+template <CycleState S>
+struct PairPolicy<VehicleType::HAUL_TRUCK, VehicleType::EXCAVATOR, S> {
+    static constexpr bool EVALUATE = true;
+    static constexpr double HORIZON = 15.0;
+    static constexpr size_t STEP = 1;
+    static constexpr double CUTOFF = 300.0;
+    static constexpr double MIN_SPEED = 1.0;
+};
+
+// Caminhao sendo carregado (LOADING) fica parado sob a lanca de
+// proposito, mas so da escavadeira que carrega ele: esse par sai em
+// CollisionDetector::pair_check_for pelo Vehicle::loader. A classe
+// inteira nao pode ter EVALUATE false, senao qualquer outra escavadeira
+// manobrando perto do caminhao parado ficaria sem alerta.
+
+// Escavadeira x escavadeira: as duas quase paradas, resolucao de 1 s
+template <CycleState S>
+struct PairPolicy<VehicleType::EXCAVATOR, VehicleType::EXCAVATOR, S> {
+    static constexpr bool EVALUATE = true;
+    static constexpr double HORIZON = 15.0;
+    static constexpr size_t STEP = 2;
+    static constexpr double CUTOFF = 150.0;
+    static constexpr double MIN_SPEED = 0.5;
+};
+
+// Escavadeira x veiculo leve: o leve chega rapido, corte pelo alcance dele
+template <CycleState S>
+struct PairPolicy<VehicleType::EXCAVATOR, VehicleType::LIGHT_VEHICLE, S> {
+    static constexpr bool EVALUATE = true;
+    static constexpr double HORIZON = 15.0;
+    static constexpr size_t STEP = 1;
+    static constexpr double CUTOFF = 400.0;
+    static constexpr double MIN_SPEED = 1.0;
+};
+
+} // namespace mineguard
+
+#endif // PAIR_POLICY_HPP
@@ -0,0 +1,146 @@
+#pragma once
+
+#ifndef PRODUCTION_KPI_HPP
+#define PRODUCTION_KPI_HPP
+
+#include "vehicle.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace mineguard {
+
+// ============================================================
+// KPIs de producao por eventos do ciclo
+//
+// A frota avisa cada transicao de ciclo dos caminhoes (fim de carga,
+// chegada no dump, fim de descarga, chegada no pit). Cada evento soma
+// em janelas deslizantes por veiculo: anel de baldes com soma
+// corrente, entao registrar um evento e O(1) e expirar um balde
+// tambem. A frota e a soma das janelas dos veiculos na publicacao
+// (mais o que sobrou de veiculos que sairam), sem varrer telemetria.
+//
+// Os eventos chegam de update_slot, possivelmente em threads
+// diferentes: cada um so toca o estado do proprio slot.
+// ============================================================
+
+struct KpiConfig {
+    double short_window;       // segundos (1 min)
+    double medium_window;      // segundos (15 min)
+    double shift_window;       // segundos (turno)
+    size_t buckets;            // baldes por janela (resolucao da expiracao)
+    double publish_interval;   // segundos entre frames de KPI
+
+    static KpiConfig create_default();
+};
+
+constexpr size_t KPI_WINDOWS = 3;
+
+// Somas de uma janela (ou de um balde)
+struct KpiTotals {
+    double cycles = 0.0;          // ciclos completos (fim de descarga a fim de descarga)
+    double cycle_seconds = 0.0;
+    double tonnes = 0.0;          // descarregadas
+    double queues = 0.0;          // chegadas no pit que viraram carga
+    double queue_seconds = 0.0;   // chegada no pit ate o inicio da carga
+    double fuel_liters = 0.0;     // consumido pelos caminhoes
+
+    void add(const KpiTotals& other);
+    void subtract(const KpiTotals& other);
+};
+
+// Janela deslizante em baldes de largura fixa (length / buckets).
+// O tempo so anda pra frente; a janela cobre os ultimos buckets baldes
+// (entre length - largura e length segundos).
+class RollingWindow {
+public:
+    RollingWindow() = default;
+    RollingWindow(double length, size_t buckets);
+
+    void add(const KpiTotals& delta, double now);
+
+    // Expira os baldes que sairam da janela ate now
+    void advance(double now);
+
+    // Soma balde a balde (mesma grade, ja avancadas ate o mesmo instante)
+    void merge(const RollingWindow& other);
+
+    const KpiTotals& totals() const { return sum_; }
+    double length() const { return width_ * static_cast<double>(buckets_.size()); }
+
+private:
+    std::vector<KpiTotals> buckets_;
+    KpiTotals sum_;
+    double width_ = 1.0;
+    int64_t head_ = 0;             // numero absoluto do balde mais recente
+};
+
+// KPIs derivados de uma janela (NAN = sem dados na janela)
+struct KpiValues {
+    uint32_t cycles;
+    double cycle_time;         // segundos medios por ciclo
+    double tonnes;
+    double tonnes_per_hour;    // pelo tempo coberto (janela ou desde o inicio)
+    double queue_time;         // segundos medios de fila no pit
+    double fuel_per_tonne;     // litros por tonelada descarregada
+};
+
+// Frame periodico (buffers reusados entre publicacoes)
+struct KpiReport {
+    int64_t timestamp;                     // epoch ms do tick publicado
+    double windows[KPI_WINDOWS];           // segundos
+    KpiValues fleet[KPI_WINDOWS];
+    std::vector<std::string> vehicle_ids;  // caminhoes vivos
+    std::vector<KpiValues> vehicles;       // KPI_WINDOWS por caminhao, na ordem dos ids
+};
+
+class ProductionKpi {
+public:
+    // start: tempo de simulacao em que a coleta comeca
+    ProductionKpi(const KpiConfig& config, double start);
+
+    // Entrada/saida de veiculo no slot (single-thread, fora do update).
+    // So caminhoes entram nos KPIs; o que o veiculo que sai acumulou
+    // continua nas janelas da frota ate expirar.
+    void on_spawn(uint32_t slot, const Vehicle& vehicle, double now);
+    void on_despawn(uint32_t slot, double now);
+
+    // Chegada no fim da rota (antes da transicao que ela dispara)
+    void record_arrival(uint32_t slot, double now);
+
+    // Transicao from -> to do caminhao no slot
+    void record_transition(uint32_t slot, const Vehicle& vehicle,
+                           CycleState from, CycleState to, double now);
+
+    bool publish_due(double now) const { return now >= next_publish_; }
+
+    // Preenche o frame e agenda o proximo. timestamp: epoch ms do tick
+    void publish(double now, int64_t timestamp, KpiReport& report);
+
+private:
+    struct VehicleKpi {
+        std::string id;
+        bool tracked = false;      // caminhao vivo no slot
+        double last_fuel = 0.0;    // litros na ultima transicao
+        double last_dump = -1.0;   // fim da ultima descarga (-1 = nenhuma)
+        double arrival = -1.0;     // chegada no fim da rota atual (-1 = nenhuma)
+        RollingWindow windows[KPI_WINDOWS];
+    };
+
+    void reset_windows(RollingWindow (&windows)[KPI_WINDOWS], double now) const;
+    KpiValues values(const KpiTotals& t, double window, double now) const;
+
+    static double fuel_liters(const Vehicle& vehicle);
+
+    KpiConfig config_;
+    double start_;
+    double lengths_[KPI_WINDOWS];
+    std::vector<VehicleKpi> slots_;
+    RollingWindow retired_[KPI_WINDOWS];   // veiculos que ja sairam
+    double next_publish_;
+};
+
+} // namespace mineguard
+
+#endif // PRODUCTION_KPI_HPP
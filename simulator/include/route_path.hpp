@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef ROUTE_PATH_HPP
+#define ROUTE_PATH_HPP
+
+#include "telemetry.hpp"
+#include "memory_footprint.hpp"
+#include <vector>
+
+namespace mineguard {
+
+// Polilinha de uma rota com tabela de comprimento acumulado.
+// Montada uma vez no startup; a predicao ao longo da rota vira
+// busca binaria + interpolacao linear, sem trigonometria por amostra.
+struct RoutePath {
+    std::vector<Position> points;        // waypoints (rota fechada repete o primeiro no fim)
+    std::vector<double> segment_length;  // metros, segment_length[i] = |points[i+1] - points[i]|
+    std::vector<double> cumulative;      // metros desde points[0] ate points[i]
+    double m_per_deg_lat;                // escala do plano local (fixa para a mina)
+    double m_per_deg_lon;
+    bool closed;                         // patrulha circular: volta ao inicio
+
+    static RoutePath build(const std::vector<Position>& waypoints, bool closed);
+
+    double length() const { return cumulative.empty() ? 0.0 : cumulative.back(); }
+
+    // Posicao a s metros do inicio da rota (clamp no fim ou wrap se fechada)
+    Position position_at(double s) const;
+
+    // Projeta p no segmento que termina em points[next_index].
+    // Retorna o arco s da projecao e o desvio lateral em metros.
+    void project(const Position& p, size_t next_index, double& s, double& offset) const;
+
+    // Distancia em metros no plano local da rota
+    double distance(const Position& a, const Position& b) const;
+
+    // Bytes de heap das tabelas (instrumentacao de memoria)
+    size_t heap_bytes() const {
+        return footprint::heap_bytes(points) +
+               footprint::heap_bytes(segment_length) +
+               footprint::heap_bytes(cumulative);
+    }
+};
+
+} // namespace mineguard
+
+#endif // ROUTE_PATH_HPP
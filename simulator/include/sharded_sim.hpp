@@ -0,0 +1,127 @@
+#pragma once
+
+#ifndef SHARDED_SIM_HPP
+#define SHARDED_SIM_HPP
+
+#include "fleet.hpp"
+#include "collision.hpp"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace mineguard {
+
+// Divide a mina em faixas (shards) ao longo do eixo mais comprido da
+// area dos waypoints. Cada shard tem uma thread que roda navegacao,
+// fisica e colisao dos veiculos que estao na faixa dele.
+//
+// Pares entre shards: o shard de indice menor recebe como halo (copia
+// so-leitura, pelo ponteiro) os veiculos dos shards de indice maior que
+// estao a ate MAX_PAIR_DISTANCE da sua borda. Cada par e checado uma vez.
+// Veiculo que cruza a borda migra de shard no proximo assign.
+//
+// O cache de pares fica particionado pelo shard dono: o detector de cada
+// shard so guarda os pares que ele checou no ultimo tick (mapa esparso
+// chaveado pelos slots globais, collision.hpp), nunca uma tabela do
+// tamanho do pool. Par que passa pra outro shard recomeca a agenda la.
+//
+// Com 1 shard nao ha threads: tudo roda na thread que chama.
+class ShardedSimulation {
+public:
+    ShardedSimulation(FleetManager& fleet, size_t shard_count);
+    ~ShardedSimulation();
+
+    ShardedSimulation(const ShardedSimulation&) = delete;
+    ShardedSimulation& operator=(const ShardedSimulation&) = delete;
+
+    // Navegacao + fisica, cada shard nos seus veiculos
+    void update(double delta_time);
+
+    // Colisao por shard (com halo); alertas de todos os shards em out.
+    // timestamp: epoch ms do tick, carimbado em todos os alertas
+    void check_all(double now, int64_t timestamp, std::vector<CollisionAlert>& out);
+
+    size_t shard_count() const { return shards_.size(); }
+
+    // Veiculos que trocaram de shard no ultimo assign
+    size_t migrations() const { return migrations_; }
+
+    // Copias de halo montadas no ultimo check_all (soma dos shards)
+    size_t halo_vehicles() const;
+
+    // Soma dos detectores de todos os shards (cada par conta em um shard so)
+    MemoryFootprint detector_footprint() const;
+
+    size_t pairs_deferred() const;
+
+    // Degradacao do governador, repassada a todos os shards
+    void set_coarse_stride(size_t stride);
+    size_t pairs_coarse() const;
+
+    // Modo de risco probabilistico em todos os shards
+    void set_risk_mode(bool enabled);
+    size_t pairs_monte_carlo() const;
+
+private:
+    enum class Phase {
+        UPDATE,
+        DETECT
+    };
+
+    struct Shard {
+        std::vector<uint32_t> slots;        // slots do pool que o shard possui
+        std::vector<Vehicle*> vehicles;     // donos primeiro, depois o halo
+        size_t owned;
+        double upper;                       // borda superior da faixa no eixo (metros)
+        CollisionDetector detector;         // cache so com os pares deste shard
+        std::vector<CollisionAlert> alerts;
+    };
+
+    // Coordenada do veiculo no eixo das faixas (metros)
+    double axis_coordinate(const Position& p) const;
+    size_t shard_for(double u) const;
+
+    // Reparte os veiculos vivos entre os shards (migracao, spawn/despawn)
+    void assign();
+    void build_halos();
+
+    void run_parallel(Phase phase);
+    void run_shard(size_t index, Phase phase);
+    void worker_loop(size_t index);
+
+    FleetManager& fleet_;
+    std::vector<Shard> shards_;
+
+    // Plano local das faixas
+    Position origin_;
+    double m_per_deg_lat_;
+    double m_per_deg_lon_;
+    bool axis_east_;                       // true: faixas ao longo do eixo leste
+    double strip_width_;
+
+    std::vector<uint32_t> shard_of_slot_;  // NO_SHARD = slot nunca visto
+    std::vector<uint32_t> generation_of_slot_;
+    std::vector<double> coordinate_;       // por posicao em fleet.vehicles()
+    size_t migrations_;
+    double delta_time_;
+    double now_;
+    int64_t timestamp_;
+
+    static constexpr uint32_t NO_SHARD = UINT32_MAX;
+
+    // Workers (shard 0 roda na thread que chama)
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    Phase phase_;
+    uint64_t epoch_;
+    size_t pending_;
+    bool stopping_;
+};
+
+} // namespace mineguard
+
+#endif // SHARDED_SIM_HPP
@@ -10,7 +10,8 @@ namespace mineguard {
 
 class TcpClient {
 public:
-    TcpClient(const std::string& host, uint16_t port);
+    // source_id vazio = sem handshake (backend trata como fonte "default")
+    TcpClient(const std::string& host, uint16_t port, const std::string& source_id = "");
     ~TcpClient();
 
     // Nao copiavel
@@ -24,14 +25,39 @@ public:
     // Envia string JSON com length-prefix (4 bytes big-endian + payload)
     bool send_message(const std::string& json);
 
+    // Le um frame com length-prefix. timeout_ms so vale ate o primeiro
+    // byte chegar; frame cortado no meio desconecta (framing perdido).
+    // false em timeout, erro ou desconexao.
+    bool receive_message(std::string& json, int timeout_ms);
+
+    // Pede ack por batch no handshake (so com source_id; chamar antes de conectar)
+    void set_ack_enabled(bool enabled) { ack_enabled_ = enabled; }
+
     // Tenta reconectar se desconectado
     bool reconnect();
 
+    const std::string& source_id() const { return source_id_; }
+
+    // ID da sessao atribuido pelo backend no handshake (0 = sem handshake)
+    uint64_t session_id() const { return session_id_; }
+
 private:
     bool send_bytes(const void* data, size_t length);
+    bool recv_bytes(void* data, size_t length);
+
+    // Envia hello e espera o welcome do backend
+    void perform_handshake();
+
+    static constexpr int HANDSHAKE_TIMEOUT_MS = 2000;
+    static constexpr int FRAME_TIMEOUT_MS = 2000;     // resto do frame depois do primeiro byte
+    static constexpr uint32_t MAX_MESSAGE_LENGTH = 1000000;
 
     std::string host_;
     uint16_t port_;
+    std::string source_id_;
+    uint64_t session_id_;
+    bool ack_enabled_;
+    std::string frame_buffer_;     // header + payload, reaproveitado entre envios
     int socket_fd_;
     bool connected_;
 };
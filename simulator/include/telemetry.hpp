@@ -45,7 +45,11 @@ struct CollisionAlert {
     AlertType type;
     double time_to_impact;   // seconds
     double distance;         // meters
+    double probability;      // 0-1 within the horizon (1 when risk mode is off)
+    Position cpa;            // predicted closest point of approach (midpoint of the pair)
     int64_t timestamp;
+    uint32_t slot_1;         // handle().slot of each vehicle (not serialized)
+    uint32_t slot_2;
 };
 
 struct TelemetryPacket {
@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef TICK_CLOCK_HPP
+#define TICK_CLOCK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace mineguard {
+
+// Atraso do despertar em relacao ao deadline, em faixas fixas (us)
+struct JitterHistogram {
+    static constexpr size_t BUCKET_COUNT = 10;
+
+    // Limite superior (exclusivo) de cada faixa; a ultima e aberta
+    static constexpr int64_t BUCKET_LIMITS[BUCKET_COUNT - 1] = {
+        10, 50, 100, 250, 500, 1000, 2000, 5000, 20000
+    };
+
+    uint64_t buckets[BUCKET_COUNT];
+    uint64_t samples;
+    int64_t total_us;
+    int64_t max_us;
+
+    void record(int64_t late_us);
+    void clear();
+
+    // Limite superior da faixa que contem o percentil (0-100)
+    int64_t percentile_us(double p) const;
+};
+
+// Relogio do loop principal com deadlines absolutos em steady_clock.
+// O tick n acorda em start + n * period: atraso de um tick nao empurra
+// os seguintes (nada de drift acumulado).
+//
+// O timestamp do tick (epoch ms) e lido uma vez no inicio do tick e
+// vem do steady_clock ancorado no relogio de parede do start: todos os
+// pacotes e alertas do tick usam o mesmo valor e ele nunca anda pra
+// tras (ajuste de NTP nao reordena os ticks).
+class TickClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // spin: fim da espera em busy-spin (0 = so dorme). Algumas centenas
+    // de us tiram a latencia de acordar do scheduler.
+    explicit TickClock(std::chrono::milliseconds period,
+                       std::chrono::microseconds spin = std::chrono::microseconds(0));
+
+    // Ancora o primeiro deadline em agora
+    void start();
+
+    // Dorme ate o proximo deadline e registra o atraso do despertar.
+    // Atrasado mais de MAX_LAG_TICKS periodos: reancora em agora
+    // (conta como resync) em vez de rodar uma rajada de ticks.
+    void wait_next();
+
+    // Timestamp compartilhado do tick atual (epoch ms)
+    int64_t tick_timestamp_ms() const { return tick_timestamp_ms_; }
+
+    // Atraso do ultimo despertar (us)
+    int64_t last_wake_late_us() const { return last_late_us_; }
+
+    const JitterHistogram& jitter() const { return jitter_; }
+    uint64_t resyncs() const { return resyncs_; }
+
+    // Uma linha com o histograma e zera o acumulado do intervalo
+    void print_jitter(std::ostream& out);
+
+    static constexpr int64_t MAX_LAG_TICKS = 5;
+
+private:
+    void sleep_until(Clock::time_point deadline);
+    void stamp(Clock::time_point now);
+
+    Clock::duration period_;
+    Clock::duration spin_;
+    Clock::time_point start_;
+    Clock::time_point deadline_;
+    int64_t wall_start_ms_;
+    int64_t tick_timestamp_ms_;
+    int64_t last_late_us_;
+    uint64_t resyncs_;
+    JitterHistogram jitter_;
+};
+
+} // namespace mineguard
+
+#endif // TICK_CLOCK_HPP
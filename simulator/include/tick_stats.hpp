@@ -0,0 +1,99 @@
+#pragma once
+
+#ifndef TICK_STATS_HPP
+#define TICK_STATS_HPP
+
+#include "alloc_counter.hpp"
+#include "memory_footprint.hpp"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+namespace mineguard {
+
+// Estagios do tick no loop principal
+enum class TickStage {
+    UPDATE = 0,     // fleet.update
+    SENSE,          // fix de GNSS + filtro de Kalman (fleet.sense)
+    COLLECT,        // collect_telemetry
+    DETECT,         // check_all
+    SERIALIZE,      // serialize_batch
+    OUTPUT,         // envio TCP ou print do modo local
+    COUNT
+};
+
+// Medida de um estagio num tick
+struct StageSample {
+    int64_t micros;
+    uint64_t allocations;   // so com MINEGUARD_ALLOC_COUNTER
+    uint64_t bytes;
+};
+
+// Memoria residente no fim do tick (soma de frota + detector)
+struct MemoryReport {
+    size_t vehicles;
+    size_t bytes_per_vehicle;
+    size_t pair_entries;
+    size_t bytes_per_pair;
+    size_t shared_bytes;
+    int64_t live_heap_bytes;   // heap vivo do processo (so com o contador)
+
+    static MemoryReport from(const MemoryFootprint& fleet, const MemoryFootprint& detector);
+};
+
+// Tempo e alocacoes por estagio do tick.
+// Cada tick vira uma linha no CSV (se aberto); o resumo no console
+// agrega o intervalo desde o ultimo print (media/maximo do tick).
+class TickStats {
+public:
+    TickStats();
+
+    // Abre o CSV e escreve o cabecalho. Retorna false se nao abriu.
+    bool open_csv(const std::string& path);
+
+    void begin_tick();
+    void begin_stage(TickStage stage);
+    void end_stage(TickStage stage);
+    // wake_late_us: atraso do despertar do tick em relacao ao deadline
+    // degradation: nivel do governador de sobrecarga durante o tick
+    void end_tick(uint64_t tick, int64_t wake_late_us, int degradation, const MemoryReport& memory);
+
+    // Custo do ultimo tick (begin_tick ate end_tick)
+    int64_t tick_micros() const { return tick_micros_; }
+
+    const StageSample& stage(TickStage stage) const {
+        return stages_[static_cast<size_t>(stage)];
+    }
+
+    // Resumo do intervalo e zera os acumuladores
+    void print_summary(std::ostream& out, uint64_t tick);
+
+    static const char* stage_name(TickStage stage);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(TickStage::COUNT);
+
+    StageSample stages_[STAGE_COUNT];
+    Clock::time_point stage_start_;
+    alloc_counter::Snapshot stage_heap_;
+    Clock::time_point tick_start_;
+    int64_t tick_micros_;
+    MemoryReport memory_;
+
+    // Acumulado do intervalo de print
+    StageSample interval_[STAGE_COUNT];
+    uint64_t interval_ticks_;
+    int64_t interval_max_micros_;
+    int64_t interval_total_micros_;
+    int interval_max_degradation_;
+
+    std::ofstream csv_;
+};
+
+} // namespace mineguard
+
+#endif // TICK_STATS_HPP
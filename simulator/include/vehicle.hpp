@@ -4,7 +4,9 @@
 #define VEHICLE_HPP
 
 #include "telemetry.hpp"
+#include "route_path.hpp"
 #include <string>
+#include <cstdint>
 
 namespace mineguard {
 
@@ -30,16 +32,36 @@ struct VehicleSpec {
     double safety_radius;     // meters
     double length;            // meters
     double width;             // meters
+    double side_clearance;    // meters - folga lateral alem da largura
+};
+
+// Referencia estavel a um slot do pool da frota. A geracao muda a cada
+// despawn, entao um handle antigo nao alcanca o veiculo que reusou o slot.
+struct VehicleHandle {
+    uint32_t slot;
+    uint32_t generation;
+
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    bool valid() const { return slot != INVALID_SLOT; }
+    bool operator==(const VehicleHandle& o) const { return slot == o.slot && generation == o.generation; }
+    bool operator!=(const VehicleHandle& o) const { return !(*this == o); }
 };
 
 class Vehicle {
 public:
     Vehicle(const std::string& id, VehicleType type, Position start_pos);
 
+    // Reinicializa no lugar (slot reusado): mantem o buffer do id_
+    void reset(const std::string& id, VehicleType type, Position start_pos);
+
     void update(double delta_time);
     Position predict_position(double seconds_ahead) const;
     TelemetryPacket generate_packet() const;
 
+    // Preenche um pacote existente (reusa o buffer do vehicle_id)
+    void fill_packet(TelemetryPacket& out, int64_t timestamp) const;
+
     // Getters
     const std::string& id() const { return id_; }
     VehicleType type() const { return type_; }
@@ -47,13 +69,51 @@ public:
     const Position& position() const { return position_; }
     const Telemetry& telemetry() const { return telemetry_; }
     double safety_radius() const { return spec_.safety_radius; }
+    const VehicleSpec& spec() const { return spec_; }
     bool is_active() const { return active_; }
+    double max_speed() const { return spec_.max_speed; }
+    const RoutePath* route_path() const { return route_path_; }
+    size_t route_next_index() const { return route_next_index_; }
+    VehicleHandle handle() const { return handle_; }
+
+    // Escavadeira que esta carregando este caminhao (handle invalido =
+    // nenhuma). Espelho de NavigationState::loader, escrito pelo
+    // FleetManager; o detector dispensa so o par com ela.
+    VehicleHandle loader() const { return loader_; }
+
+    // Estado que o detector enxerga. Com o pipeline de GNSS ligado
+    // (FleetManager::enable_gnss) e a estimativa do filtro de Kalman;
+    // sem pipeline, ou antes do primeiro fix, e o proprio estado simulado.
+    const Position& sensed_position() const { return has_estimate_ ? estimate_ : position_; }
+    const Telemetry& sensed_telemetry() const { return has_estimate_ ? estimate_telemetry_ : telemetry_; }
+    Position predict_sensed_position(double seconds_ahead) const;
+
+    // Desvio padrao da posicao estimada pelo filtro (metros por eixo);
+    // 0 sem estimativa ou quando quem estima nao sabe (replay sem filtro)
+    double sensed_position_sigma() const { return has_estimate_ ? estimate_sigma_ : 0.0; }
+
+    // Receptor com fix neste tick (false em dropout; sempre true sem pipeline)
+    bool has_gnss_fix() const { return !gnss_ || fix_valid_; }
+
+    // Escritos pelo pipeline de GNSS a cada tick. O pacote de telemetria
+    // passa a levar o fix bruto no lugar da posicao simulada.
+    void set_gnss_fix(const Position& fix, bool valid);
+    void set_estimate(const Position& position, double speed, double heading, double position_sigma);
+
+    // Bytes de heap do proprio veiculo (fora o sizeof do objeto)
+    size_t heap_bytes() const { return footprint::heap_bytes(id_); }
 
     // Setters
     void set_target_speed(double speed);
     void set_heading(double heading);
     void set_active(bool active) { active_ = active; }
     void set_cycle_state(CycleState state) { cycle_state_ = state; }
+    void set_handle(VehicleHandle handle) { handle_ = handle; }
+    void set_loader(VehicleHandle loader) { loader_ = loader; }
+
+    // Rota que o veiculo esta seguindo (nullptr = predicao em linha reta).
+    // next_index: proximo waypoint da rota
+    void set_route_path(const RoutePath* path, size_t next_index);
 
     // Specs por tipo de veiculo
     static VehicleSpec default_spec(VehicleType type);
@@ -62,6 +122,13 @@ private:
     void update_position(double dt);
     void update_fuel(double dt);
     void apply_payload_effects();
+    void refresh_route_lead();
+
+    // Predicao a partir de um estado (simulado ou estimado).
+    // lead: metros de origin ate o proximo waypoint da rota
+    Position predict_from(const Position& origin, const Telemetry& telemetry,
+                          double lead, double seconds_ahead) const;
+    Position predict_along_route(const Position& origin, double lead, double distance) const;
 
     std::string id_;
     VehicleType type_;
@@ -71,6 +138,25 @@ private:
     Telemetry telemetry_;
     double target_speed_;
     bool active_;
+
+    // Predicao ao longo da rota
+    const RoutePath* route_path_;
+    size_t route_next_index_;
+    double route_lead_;           // metros ate o proximo waypoint
+
+    // Slot no pool do FleetManager (chave do cache de pares do detector)
+    VehicleHandle handle_;
+    VehicleHandle loader_;
+
+    // Pipeline de GNSS: fix bruto do receptor e estimativa do filtro
+    bool gnss_;
+    bool fix_valid_;
+    bool has_estimate_;
+    Position fix_;
+    Position estimate_;
+    Telemetry estimate_telemetry_;
+    double estimate_route_lead_;
+    double estimate_sigma_;
 };
 
 } // namespace mineguard
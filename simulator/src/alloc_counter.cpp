@@ -0,0 +1,106 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef MINEGUARD_ALLOC_COUNTER
+#include <malloc.h>
+#endif
+
+// ============================================================
+// Instrumentacao de heap (opt-in)
+//
+// Com MINEGUARD_ALLOC_COUNTER o operator new/delete global passa
+// por aqui. Conta chamadas e bytes (tamanho util do bloco via
+// malloc_usable_size, o mesmo valor na alocacao e na liberacao,
+// entao live_bytes fecha sem cabecalho extra por bloco).
+// ============================================================
+
+namespace mineguard {
+namespace alloc_counter {
+
+#ifdef MINEGUARD_ALLOC_COUNTER
+
+static std::atomic<uint64_t> g_allocations{0};
+static std::atomic<uint64_t> g_frees{0};
+static std::atomic<uint64_t> g_bytes{0};
+static std::atomic<int64_t> g_live_bytes{0};
+
+bool enabled() { return true; }
+
+Snapshot snapshot() {
+    return Snapshot{
+        g_allocations.load(std::memory_order_relaxed),
+        g_frees.load(std::memory_order_relaxed),
+        g_bytes.load(std::memory_order_relaxed),
+        g_live_bytes.load(std::memory_order_relaxed)
+    };
+}
+
+uint64_t allocations() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+static void* counted_alloc(std::size_t size) {
+    if (size == 0) size = 1;
+    void* p = std::malloc(size);
+    if (!p) return nullptr;
+
+    size_t usable = malloc_usable_size(p);
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(usable, std::memory_order_relaxed);
+    g_live_bytes.fetch_add(static_cast<int64_t>(usable), std::memory_order_relaxed);
+    return p;
+}
+
+static void counted_free(void* p) {
+    if (!p) return;
+
+    size_t usable = malloc_usable_size(p);
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    g_live_bytes.fetch_sub(static_cast<int64_t>(usable), std::memory_order_relaxed);
+    std::free(p);
+}
+
+#else
+
+bool enabled() { return false; }
+
+Snapshot snapshot() { return Snapshot{0, 0, 0, 0}; }
+
+uint64_t allocations() { return 0; }
+
+#endif
+
+} // namespace alloc_counter
+} // namespace mineguard
+
+#ifdef MINEGUARD_ALLOC_COUNTER
+
+void* operator new(std::size_t size) {
+    void* p = mineguard::alloc_counter::counted_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    void* p = mineguard::alloc_counter::counted_alloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return mineguard::alloc_counter::counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return mineguard::alloc_counter::counted_alloc(size);
+}
+
+void operator delete(void* p) noexcept { mineguard::alloc_counter::counted_free(p); }
+void operator delete[](void* p) noexcept { mineguard::alloc_counter::counted_free(p); }
+void operator delete(void* p, std::size_t) noexcept { mineguard::alloc_counter::counted_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { mineguard::alloc_counter::counted_free(p); }
+
+#endif
@@ -0,0 +1,96 @@
+#include "batch_runner.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <cstring>
+
+using namespace mineguard;
+
+// ============================================================
+// Lote de cenarios aleatorios pra analise de seguranca
+//
+// Milhares de execucoes independentes (saida dessincronizada,
+// velocidades e tempos de carga sorteados), todas mais rapidas que o
+// tempo real, em todos os cores. Uma linha por execucao no CSV e o
+// agregado por trecho de estrada no console.
+// ============================================================
+
+void print_usage(const char* prog) {
+    std::cout << "MineGuard safety batch runner\n\n";
+    std::cout << "Usage: " << prog << " [options]\n";
+    std::cout << "  --runs <n>          Independent runs (default: 100)\n";
+    std::cout << "  --threads <n>       Worker threads (default: hardware concurrency)\n";
+    std::cout << "  --seed <s>          Base seed; run i uses seed + i (default: 1)\n";
+    std::cout << "  --duration <s>      Simulated seconds per run (default: 3600)\n";
+    std::cout << "  --trucks <n>        Haul trucks added to the default fleet (default: 0)\n";
+    std::cout << "  --light <n>         Light vehicles added to the default fleet (default: 0)\n";
+    std::cout << "  --speed-jitter <f>  Cruise speed x U(1-f, 1+f) per vehicle (default: 0.15)\n";
+    std::cout << "  --dwell-jitter <f>  Loading/dumping time x U(1-f, 1+f) per vehicle (default: 0.3)\n";
+    std::cout << "  --start-offset <s>  Each vehicle starts U(0, s) seconds into its cycle (default: 600)\n";
+    std::cout << "  --out <file>        Per-run CSV (default: batch_results.csv)\n";
+    std::cout << "  --help              Show this message\n";
+}
+
+int main(int argc, char* argv[]) {
+    BatchConfig cfg = BatchConfig::create_default();
+    std::string out_file = "batch_results.csv";
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--runs") == 0 && has_value) {
+            cfg.runs = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            cfg.threads = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            cfg.seed = std::stoull(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--duration") == 0 && has_value) {
+            cfg.duration = std::max(1.0, std::stod(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--trucks") == 0 && has_value) {
+            cfg.extra_trucks = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--light") == 0 && has_value) {
+            cfg.extra_light = static_cast<size_t>(std::max(0, std::stoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--speed-jitter") == 0 && has_value) {
+            cfg.speed_jitter = std::clamp(std::stod(argv[++i]), 0.0, 0.9);
+        }
+        else if (std::strcmp(argv[i], "--dwell-jitter") == 0 && has_value) {
+            cfg.dwell_jitter = std::clamp(std::stod(argv[++i]), 0.0, 0.9);
+        }
+        else if (std::strcmp(argv[i], "--start-offset") == 0 && has_value) {
+            cfg.start_offset_max = std::max(0.0, std::stod(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && has_value) {
+            out_file = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::ofstream out(out_file);
+    if (!out) {
+        std::cerr << "[BATCH] Could not open " << out_file << "\n";
+        return 1;
+    }
+
+    BatchRunner runner(cfg);
+    std::cout << "[BATCH] " << cfg.runs << " runs x " << cfg.duration << "s, seed "
+              << cfg.seed << ", writing " << out_file << "\n";
+    runner.run(out);
+    runner.print_summary(std::cout);
+    return 0;
+}
@@ -0,0 +1,357 @@
+#include "batch_runner.hpp"
+#include "collision.hpp"
+#include "alert_episodes.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace mineguard {
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double EARTH_RADIUS = 6371000.0;
+
+using Clock = std::chrono::steady_clock;
+
+// ============================================================
+// Configuracao padrao: 1 h simulada por execucao, frota padrao
+// ============================================================
+
+BatchConfig BatchConfig::create_default() {
+    FleetVariation variation = FleetVariation::create_default();
+    return BatchConfig{
+        .runs = 100,
+        .threads = 0,
+        .seed = 1,
+        .duration = 3600.0,
+        .delta_time = 1.0,
+        .extra_trucks = 0,
+        .extra_light = 0,
+        .speed_jitter = variation.speed_jitter,
+        .dwell_jitter = variation.dwell_jitter,
+        .start_offset_max = variation.start_offset_max,
+        .section_reach = 100.0
+    };
+}
+
+// ============================================================
+// Trechos no plano local
+// ============================================================
+
+SectionIndex::SectionIndex(const std::vector<RoadSection>& sections, double reach)
+    : lat0_(0.0)
+    , lon0_(0.0)
+    , m_per_deg_lat_(EARTH_RADIUS * DEG_TO_RAD)
+    , m_per_deg_lon_(0.0)
+    , reach_(reach)
+{
+    if (!sections.empty()) {
+        lat0_ = sections.front().from.latitude;
+        lon0_ = sections.front().from.longitude;
+    }
+    m_per_deg_lon_ = m_per_deg_lat_ * std::cos(lat0_ * DEG_TO_RAD);
+
+    for (const RoadSection& s : sections) {
+        names_.push_back(s.name);
+        ax_.push_back((s.from.longitude - lon0_) * m_per_deg_lon_);
+        ay_.push_back((s.from.latitude - lat0_) * m_per_deg_lat_);
+        bx_.push_back((s.to.longitude - lon0_) * m_per_deg_lon_);
+        by_.push_back((s.to.latitude - lat0_) * m_per_deg_lat_);
+    }
+}
+
+size_t SectionIndex::nearest(const Position& p) const {
+    double px = (p.longitude - lon0_) * m_per_deg_lon_;
+    double py = (p.latitude - lat0_) * m_per_deg_lat_;
+
+    size_t best = names_.size();
+    double best_d2 = reach_ * reach_;
+    for (size_t i = 0; i < names_.size(); i++) {
+        double dx = bx_[i] - ax_[i];
+        double dy = by_[i] - ay_[i];
+        double len2 = dx * dx + dy * dy;
+        double t = len2 > 0.0 ? ((px - ax_[i]) * dx + (py - ay_[i]) * dy) / len2 : 0.0;
+        t = std::clamp(t, 0.0, 1.0);
+        double ex = ax_[i] + t * dx - px;
+        double ey = ay_[i] + t * dy - py;
+        double d2 = ex * ex + ey * ey;
+        if (d2 < best_d2) {
+            best_d2 = d2;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// ============================================================
+// Filas com roubo de trabalho
+//
+// Cada thread comeca com um bloco contiguo de execucoes e tira do
+// comeco da propria fila (indices baixos primeiro: o arquivo anda).
+// Fila vazia: rouba do fim da fila de outra thread. Nada e adicionado
+// depois do inicio, entao todas vazias = fim.
+// ============================================================
+
+class WorkQueues {
+public:
+    WorkQueues(size_t workers, size_t items) : queues_(workers) {
+        for (size_t w = 0; w < workers; w++) {
+            size_t begin = items * w / workers;
+            size_t end = items * (w + 1) / workers;
+            for (size_t i = begin; i < end; i++) queues_[w].items.push_back(i);
+        }
+    }
+
+    bool pop(size_t worker, size_t& item) {
+        {
+            Queue& own = queues_[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.items.empty()) {
+                item = own.items.front();
+                own.items.pop_front();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues_.size(); k++) {
+            Queue& victim = queues_[(worker + k) % queues_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.items.empty()) {
+                item = victim.items.back();
+                victim.items.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> items;
+    };
+    std::vector<Queue> queues_;
+};
+
+// ============================================================
+// Execucoes
+// ============================================================
+
+static std::vector<RoadSection> default_sections() {
+    FleetManager mine;
+    mine.initialize();
+    return mine.road_sections();
+}
+
+BatchRunner::BatchRunner(const BatchConfig& config)
+    : config_(config)
+    , sections_(default_sections(), config.section_reach)
+    , wall_seconds_(0.0)
+{
+}
+
+RunResult BatchRunner::run_one(size_t index) const {
+    auto start = Clock::now();
+
+    RunResult r;
+    r.seed = config_.seed + index;
+
+    FleetManager fleet;
+    fleet.set_variation(FleetVariation{
+        .seed = r.seed,
+        .speed_jitter = config_.speed_jitter,
+        .dwell_jitter = config_.dwell_jitter,
+        .start_offset_max = config_.start_offset_max
+    });
+    fleet.initialize();
+    for (size_t k = 0; k < config_.extra_trucks; k++) {
+        fleet.spawn_vehicle("HT-" + std::to_string(104 + k), VehicleType::HAUL_TRUCK);
+    }
+    for (size_t k = 0; k < config_.extra_light; k++) {
+        fleet.spawn_vehicle("LV-" + std::to_string(302 + k), VehicleType::LIGHT_VEHICLE);
+    }
+    fleet.scatter_cycles();
+
+    CollisionDetector detector;
+    detector.set_conflict_zones(&fleet.conflict_zones());
+
+    size_t buckets = sections_.size() + 1;
+    r.near_misses.assign(buckets, 0);
+    r.min_cpa.assign(buckets, INFINITY);
+
+    std::vector<CollisionAlert> alerts;
+    AlertEpisodes episodes;
+
+    uint64_t ticks = static_cast<uint64_t>(config_.duration / config_.delta_time);
+    for (uint64_t t = 0; t < ticks; t++) {
+        double now = t * config_.delta_time;
+        fleet.update(config_.delta_time);
+        detector.check_all(fleet.vehicles(), fleet.vehicle_count(), now,
+                           static_cast<int64_t>(now * 1000.0), alerts);
+
+        for (const CollisionAlert& a : alerts) {
+            // Trecho onde o par chega mais perto (CPA previsto)
+            size_t section = sections_.nearest(a.cpa);
+            r.min_cpa[section] = std::min(r.min_cpa[section], static_cast<float>(a.distance));
+
+            // Evento: episodio novo ou subida de prioridade; quase-colisao
+            // quando o episodio chega a HIGH pela primeira vez
+            AlertPriority peak = episodes.observe(a);
+            if (a.priority <= peak) continue;
+            r.alert_events[static_cast<size_t>(a.priority)]++;
+            if (a.priority >= AlertPriority::HIGH && peak < AlertPriority::HIGH) r.near_misses[section]++;
+        }
+        episodes.end_tick();
+    }
+
+    r.ticks = ticks;
+    r.vehicles = fleet.vehicle_count();
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return r;
+}
+
+void BatchRunner::run(std::ostream& out) {
+    auto start = Clock::now();
+    const size_t runs = config_.runs;
+    results_.assign(runs, RunResult{});
+
+    size_t threads = config_.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, runs));
+
+    WorkQueues queues(threads, runs);
+    std::vector<char> done(runs, 0);
+    std::mutex mutex;
+    std::condition_variable ready;
+
+    // Cada execucao so escreve results_[i]; done[i] publica sob o mutex
+    auto worker = [&](size_t w) {
+        size_t i;
+        while (queues.pop(w, i)) {
+            RunResult r = run_one(i);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                results_[i] = std::move(r);
+                done[i] = 1;
+            }
+            ready.notify_one();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t w = 0; w < threads; w++) workers.emplace_back(worker, w);
+
+    write_header(out);
+    for (size_t i = 0; i < runs; i++) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&] { return done[i] != 0; });
+        }
+        write_row(out, i);
+    }
+
+    for (auto& t : workers) t.join();
+    wall_seconds_ = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// ============================================================
+// Saida
+// ============================================================
+
+void BatchRunner::write_header(std::ostream& out) const {
+    out << "run,seed,vehicles,ticks,low,medium,high,critical,wall_s";
+    for (size_t s = 0; s <= sections_.size(); s++) {
+        const char* name = s < sections_.size() ? sections_.name(s).c_str() : "OFF_ROAD";
+        out << ",near_miss:" << name << ",min_cpa:" << name;
+    }
+    out << '\n';
+}
+
+void BatchRunner::write_row(std::ostream& out, size_t index) const {
+    const RunResult& r = results_[index];
+    char buf[64];
+
+    out << index << ',' << r.seed << ',' << r.vehicles << ',' << r.ticks;
+    for (size_t p = 1; p <= 4; p++) out << ',' << r.alert_events[p];
+    std::snprintf(buf, sizeof(buf), ",%.3f", r.seconds);
+    out << buf;
+
+    for (size_t s = 0; s < r.near_misses.size(); s++) {
+        out << ',' << r.near_misses[s] << ',';
+        if (std::isfinite(r.min_cpa[s])) {
+            std::snprintf(buf, sizeof(buf), "%.1f", r.min_cpa[s]);
+            out << buf;
+        }
+    }
+    out << '\n' << std::flush;
+}
+
+void BatchRunner::print_summary(std::ostream& out) const {
+    if (results_.empty()) return;
+
+    double sim_hours = 0.0;
+    double run_seconds = 0.0;
+    uint64_t events[5] = {};
+    std::vector<double> rates;    // quase-colisoes por hora, por execucao
+    for (const RunResult& r : results_) {
+        double hours = r.ticks * config_.delta_time / 3600.0;
+        sim_hours += hours;
+        run_seconds += r.seconds;
+        for (size_t p = 0; p < 5; p++) events[p] += r.alert_events[p];
+        uint64_t near = 0;
+        for (uint32_t n : r.near_misses) near += n;
+        rates.push_back(hours > 0.0 ? near / hours : 0.0);
+    }
+    std::sort(rates.begin(), rates.end());
+    auto pct = [](const std::vector<double>& v, double p) {
+        return v.empty() ? 0.0 : v[static_cast<size_t>(p / 100.0 * (v.size() - 1))];
+    };
+
+    char buf[256];
+    std::snprintf(buf, sizeof(buf),
+                  "[BATCH] %zu runs, %.1f simulated hours in %.2fs wall (%.0fx real time, %.1f runs/s)\n",
+                  results_.size(), sim_hours, wall_seconds_,
+                  wall_seconds_ > 0.0 ? sim_hours * 3600.0 / wall_seconds_ : 0.0,
+                  wall_seconds_ > 0.0 ? results_.size() / wall_seconds_ : 0.0);
+    out << buf;
+    std::snprintf(buf, sizeof(buf),
+                  "[BATCH] Alert events/hour: LOW %.2f  MEDIUM %.2f  HIGH %.2f  CRITICAL %.2f\n",
+                  events[1] / sim_hours, events[2] / sim_hours,
+                  events[3] / sim_hours, events[4] / sim_hours);
+    out << buf;
+    std::snprintf(buf, sizeof(buf),
+                  "[BATCH] Near misses (episodes reaching HIGH)/hour per run: median %.2f  p95 %.2f  max %.2f\n",
+                  pct(rates, 50), pct(rates, 95), rates.back());
+    out << buf;
+
+    out << "[BATCH] Section                        near-miss/h  runs w/ near miss  min CPA  median min CPA\n";
+    for (size_t s = 0; s <= sections_.size(); s++) {
+        uint64_t near = 0;
+        size_t runs_with = 0;
+        std::vector<double> cpas;
+        for (const RunResult& r : results_) {
+            near += r.near_misses[s];
+            if (r.near_misses[s] > 0) runs_with++;
+            if (std::isfinite(r.min_cpa[s])) cpas.push_back(r.min_cpa[s]);
+        }
+        std::sort(cpas.begin(), cpas.end());
+
+        const char* name = s < sections_.size() ? sections_.name(s).c_str() : "OFF_ROAD";
+        if (cpas.empty()) {
+            std::snprintf(buf, sizeof(buf), "[BATCH] %-30s %11.3f  %16.1f%%        -               -\n",
+                          name, near / sim_hours, 100.0 * runs_with / results_.size());
+        } else {
+            std::snprintf(buf, sizeof(buf), "[BATCH] %-30s %11.3f  %16.1f%%  %6.1fm  %13.1fm\n",
+                          name, near / sim_hours, 100.0 * runs_with / results_.size(),
+                          cpas.front(), pct(cpas, 50));
+        }
+        out << buf;
+    }
+}
+
+} // namespace mineguard
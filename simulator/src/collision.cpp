@@ -1,123 +1,943 @@
 #include "collision.hpp"
 #include <cmath>
 #include <chrono>
+#include <algorithm>
 #include <limits>
 
 namespace mineguard {
 
 static constexpr double DEG_TO_RAD = M_PI / 180.0;
 static constexpr double EARTH_RADIUS = 6371000.0;
-
-CollisionDetector::CollisionDetector() {}
+static constexpr double KMH_TO_MS = 1.0 / 3.6;
+
+CollisionDetector::CollisionDetector()
+    : zones_(nullptr)
+    , pairs_skipped_by_zones_(0)
+    , origin_latitude_(0.0)
+    , origin_longitude_(0.0)
+    , m_per_deg_lon_(0.0)
+    , last_check_time_(0.0)
+    , pairs_deferred_(0)
+    , coarse_stride_(1)
+    , pairs_coarse_(0)
+    , pairs_skipped_by_policy_(0)
+    , risk_mode_(false)
+{
+}
 
 // ============================================================
-// Checa todos os pares de veiculos (N*(N-1)/2 combinacoes)
+// Checa os pares de veiculos ao alcance
+//
+// 1. Trajetorias previstas de cada veiculo (N * amostras)
+// 1b. Grade uniforme enumera so pares a ate MAX_PAIR_DISTANCE
+// 2. Zonas de conflito descartam pares sem ocupacao em comum
+// 3. Agenda por par adia pares que nao podem conflitar tao cedo
+// 4. Teste de circulo barato por par (estagio 1)
+// 5. SAT de retangulos orientados so nos sobreviventes (estagio 2)
 // ============================================================
 
 std::vector<CollisionAlert> CollisionDetector::check_all(
-    const std::vector<std::unique_ptr<Vehicle>>& vehicles
+    const std::vector<Vehicle*>& vehicles,
+    double now
 ) {
     std::vector<CollisionAlert> alerts;
+    check_all(vehicles, now, alerts);
+    return alerts;
+}
 
-    for (size_t i = 0; i < vehicles.size(); i++) {
-        for (size_t j = i + 1; j < vehicles.size(); j++) {
-            if (!vehicles[i]->is_active() || !vehicles[j]->is_active()) continue;
+void CollisionDetector::check_all(
+    const std::vector<Vehicle*>& vehicles,
+    double now,
+    std::vector<CollisionAlert>& alerts
+) {
+    using namespace std::chrono;
+    int64_t ts = duration_cast<milliseconds>(
+        system_clock::now().time_since_epoch()
+    ).count();
+
+    check_all(vehicles, vehicles.size(), now, ts, alerts);
+}
+
+void CollisionDetector::check_all(
+    const std::vector<Vehicle*>& vehicles,
+    size_t owned,
+    double now,
+    int64_t timestamp,
+    std::vector<CollisionAlert>& alerts
+) {
+    alerts.clear();
+    pairs_skipped_by_zones_ = 0;
+    pairs_deferred_ = 0;
+    pairs_coarse_ = 0;
+    pairs_skipped_by_policy_ = 0;
+    candidates_.clear();
+    narrow_.clear();
+    monte_carlo_.clear();
+
+    build_trajectories(vehicles);
+    find_near_pairs(vehicles, owned);
+
+    // Mapa do tick anterior vira a origem das agendas; o do tick atual
+    // ja nasce com espaco pra todos os pares ao alcance
+    std::swap(pair_states_, previous_pairs_);
+    pair_states_.reset(near_pairs_.size());
+
+    // Margem de um tick: o par tem que ser reavaliado antes do
+    // conflito entrar no horizonte de predicao
+    double tick_margin = now - last_check_time_;
+    if (tick_margin <= 0.0 || tick_margin > MAX_PREDICTION_TIME) tick_margin = 1.0;
+    last_check_time_ = now;
+
+    // Ocupacao de zonas por veiculo, uma vez por tick
+    bool use_zones = zones_ && !zones_->empty();
+    if (use_zones) {
+        occupancy_.resize(vehicles.size());
+        zone_bound_.assign(vehicles.size(), 0);
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            zone_bound_[i] = compute_occupancy(*vehicles[i], occupancy_[i]);
+        }
+    }
+
+    // Halo x halo ja ficou fora em find_near_pairs
+    for (uint64_t near : near_pairs_) {
+        size_t a = static_cast<size_t>(near >> 32);
+        size_t b = static_cast<size_t>(near & 0xFFFFFFFFu);
+
+        // Ordem do par pelo slot: estavel mesmo quando o despawn
+        // reordena a lista compacta (cache e ids do alerta)
+        bool swap = vehicles[a]->handle().slot > vehicles[b]->handle().slot;
+        size_t i = swap ? b : a;
+        size_t j = swap ? a : b;
+
+        // Classe do par: instancia de check_pair com as constantes dela
+        PairCheck check = pair_check_for(*vehicles[i], *vehicles[j]);
+        if (!check) {
+            pairs_skipped_by_policy_++;
+            continue;
+        }
+
+        size_t pair = 0;
+        PairState& ps = pair_state(*vehicles[i], *vehicles[j], pair);
+
+        // Rotas diferentes sem zona compartilhada na janela: sem geometria
+        if (use_zones && zone_bound_[i] && zone_bound_[j] &&
+            vehicles[i]->route_path() != vehicles[j]->route_path() &&
+            !zones_->windows_overlap(occupancy_[i], occupancy_[j])) {
+            pairs_skipped_by_zones_++;
+            continue;
+        }
+
+        if (can_defer(ps, *vehicles[i], *vehicles[j], now)) {
+            pairs_deferred_++;
+            continue;
+        }
+
+        size_t before = candidates_.size();
+        size_t stride = 1;
+        if (coarse_stride_ > 1 && can_coarsen(ps, i, j)) {
+            stride = coarse_stride_;
+            pairs_coarse_++;
+        }
+        (this->*check)(vehicles, i, j, stride);
 
-            CollisionAlert alert = check_pair(*vehicles[i], *vehicles[j]);
-            if (alert.priority != AlertPriority::NONE) {
-                alerts.push_back(alert);
+        bool candidate = candidates_.size() > before;
+        if (candidate) candidates_.back().pair = pair;
+        schedule_pair(i, j, ps, *vehicles[i], *vehicles[j], candidate, now, tick_margin);
+    }
+
+    run_narrowphase();
+    if (risk_mode_) compute_risk();
+    emit_alerts(vehicles, timestamp, alerts);
+}
+
+CollisionDetector::PairState& CollisionDetector::pair_state(const Vehicle& lo, const Vehicle& hi,
+                                                            size_t& index) {
+    VehicleHandle h1 = lo.handle();
+    VehicleHandle h2 = hi.handle();
+    uint64_t key = PairStateMap::key(h1.slot, h2.slot);
+
+    const PairState* previous = previous_pairs_.find(key);
+    PairState& ps = pair_states_.insert(key, index);
+    if (previous && previous->generation1 == h1.generation && previous->generation2 == h2.generation) {
+        ps = *previous;
+    } else {
+        ps = PairState{};
+        ps.generation1 = h1.generation;
+        ps.generation2 = h2.generation;
+    }
+    return ps;
+}
+
+// ============================================================
+// Pares ao alcance (grade uniforme)
+//
+// Par mais longe que MAX_PAIR_DISTANCE nunca vira candidato, entao com
+// celulas desse lado so a celula do veiculo e as 8 vizinhas podem ter
+// par. Cada veiculo olha a propria celula e 4 vizinhas; as outras 4
+// veem o par pelo outro lado. A grade cobre a caixa da frota; frota
+// muito espalhada (muito mais celulas que veiculos) dobra o lado da
+// celula ate caber. Os pares saem ordenados por (a, b), a mesma ordem
+// do laco sobre todos os pares: candidatos e alertas nao mudam de ordem.
+// ============================================================
+
+void CollisionDetector::find_near_pairs(const std::vector<Vehicle*>& vehicles, size_t owned) {
+    const size_t K = TRAJECTORY_SAMPLES;
+    const size_t n = vehicles.size();
+    near_pairs_.clear();
+    cell_of_.assign(n, SIZE_MAX);
+
+    double min_x = std::numeric_limits<double>::infinity();
+    double min_y = min_x;
+    double max_x = -min_x;
+    double max_y = -min_x;
+    size_t active = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (!vehicles[i]->is_active()) continue;
+        double x = traj_x_[i * K];
+        double y = traj_y_[i * K];
+        if (!std::isfinite(x) || !std::isfinite(y)) continue;
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+        cell_of_[i] = 0;
+        active++;
+    }
+    if (active < 2) return;
+
+    double cell = MAX_PAIR_DISTANCE;
+    const double max_cells = static_cast<double>(4 * active + 16);
+    double cols = std::floor((max_x - min_x) / cell) + 1.0;
+    double rows = std::floor((max_y - min_y) / cell) + 1.0;
+    while (cols * rows > max_cells) {
+        cell *= 2.0;
+        cols = std::floor((max_x - min_x) / cell) + 1.0;
+        rows = std::floor((max_y - min_y) / cell) + 1.0;
+    }
+    const size_t nx = static_cast<size_t>(cols);
+    const size_t ny = static_cast<size_t>(rows);
+
+    // Ordenacao por contagem: veiculos de cada celula em ordem de indice
+    cell_start_.assign(nx * ny + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        if (cell_of_[i] == SIZE_MAX) continue;
+        size_t cx = static_cast<size_t>((traj_x_[i * K] - min_x) / cell);
+        size_t cy = static_cast<size_t>((traj_y_[i * K] - min_y) / cell);
+        cell_of_[i] = std::min(cy, ny - 1) * nx + std::min(cx, nx - 1);
+        cell_start_[cell_of_[i] + 1]++;
+    }
+    for (size_t c = 0; c < nx * ny; c++) cell_start_[c + 1] += cell_start_[c];
+    cell_items_.resize(active);
+    for (size_t i = 0; i < n; i++) {
+        if (cell_of_[i] != SIZE_MAX) cell_items_[cell_start_[cell_of_[i]]++] = static_cast<uint32_t>(i);
+    }
+    for (size_t c = nx * ny; c > 0; c--) cell_start_[c] = cell_start_[c - 1];
+    cell_start_[0] = 0;
+
+    static constexpr int NEIGHBORS[5][2] = {{0, 0}, {1, -1}, {1, 0}, {1, 1}, {0, 1}};
+    const double range2 = MAX_PAIR_DISTANCE * MAX_PAIR_DISTANCE;
+
+    for (size_t a = 0; a < n; a++) {
+        if (cell_of_[a] == SIZE_MAX) continue;
+        long cx = static_cast<long>(cell_of_[a] % nx);
+        long cy = static_cast<long>(cell_of_[a] / nx);
+        double ax = traj_x_[a * K];
+        double ay = traj_y_[a * K];
+
+        for (const auto& d : NEIGHBORS) {
+            long ncx = cx + d[0];
+            long ncy = cy + d[1];
+            if (ncx < 0 || ncy < 0 || ncx >= static_cast<long>(nx) || ncy >= static_cast<long>(ny)) continue;
+            size_t c = static_cast<size_t>(ncy) * nx + static_cast<size_t>(ncx);
+
+            for (size_t k = cell_start_[c]; k < cell_start_[c + 1]; k++) {
+                size_t b = cell_items_[k];
+                // Mesma celula: cada par uma vez
+                if (d[0] == 0 && d[1] == 0 && b <= a) continue;
+
+                size_t lo = std::min(a, b);
+                size_t hi = std::max(a, b);
+                if (lo >= owned) continue;   // halo x halo
+
+                double dx = traj_x_[b * K] - ax;
+                double dy = traj_y_[b * K] - ay;
+                if (dx * dx + dy * dy > range2) continue;
+
+                near_pairs_.push_back((static_cast<uint64_t>(lo) << 32) | hi);
             }
         }
     }
 
-    return alerts;
+    std::sort(near_pairs_.begin(), near_pairs_.end());
+}
+
+// ============================================================
+// Mapa esparso de pares
+// ============================================================
+
+void CollisionDetector::PairStateMap::reset(size_t expected) {
+    // Carga maxima 3/4
+    size_t capacity = 16;
+    unsigned bits = 4;
+    while (capacity * 3 < expected * 4) {
+        capacity <<= 1;
+        bits++;
+    }
+
+    // Tick com bem menos pares que a capacidade atual: encolhe, pra
+    // limpeza nao custar a capacidade do pico
+    if (entries_.size() < capacity || entries_.size() > capacity * 4) {
+        entries_.assign(capacity, Entry{EMPTY, PairState{}});
+        entries_.shrink_to_fit();
+    } else {
+        capacity = entries_.size();
+        bits = 0;
+        while ((size_t{1} << bits) < capacity) bits++;
+        for (Entry& e : entries_) e.key = EMPTY;
+    }
+
+    mask_ = capacity - 1;
+    shift_ = 64 - bits;
+    count_ = 0;
+}
+
+const CollisionDetector::PairState* CollisionDetector::PairStateMap::find(uint64_t key) const {
+    if (count_ == 0) return nullptr;
+    for (size_t s = slot_of(key); ; s = (s + 1) & mask_) {
+        const Entry& e = entries_[s];
+        if (e.key == key) return &e.state;
+        if (e.key == EMPTY) return nullptr;
+    }
+}
+
+CollisionDetector::PairState& CollisionDetector::PairStateMap::insert(uint64_t key, size_t& index) {
+    size_t s = slot_of(key);
+    while (entries_[s].key != EMPTY) s = (s + 1) & mask_;
+    entries_[s].key = key;
+    count_++;
+    index = s;
+    return entries_[s].state;
+}
+
+size_t CollisionDetector::PairStateMap::heap_bytes() const {
+    return footprint::heap_bytes(entries_);
 }
 
 // ============================================================
-// Algoritmo de deteccao para um par de veiculos
+// Ocupacao de zonas (tabela de reserva)
+//
+// So vale pra veiculos seguindo uma rota da tabela e perto da
+// polilinha; os demais continuam no teste geometrico completo.
+// ============================================================
+
+bool CollisionDetector::compute_occupancy(const Vehicle& v, std::vector<ZoneOccupancy>& out) const {
+    out.clear();
+
+    const RoutePath* path = v.route_path();
+    if (!path) return false;
+
+    double s_now = 0.0;
+    double offset = 0.0;
+    path->project(v.sensed_position(), v.route_next_index(), s_now, offset);
+    if (offset > ZONE_LATERAL_TOLERANCE) return false;
+
+    double speed_ms = v.sensed_telemetry().speed * KMH_TO_MS;
+    double max_speed_ms = v.max_speed() * KMH_TO_MS;
+    zones_->occupancy(path, s_now, speed_ms, max_speed_ms, MAX_PREDICTION_TIME, out);
+    return true;
+}
+
+// ============================================================
+// Trajetorias previstas no plano local
+//
+// Cada veiculo e projetado uma vez por tick em vez de uma vez por
+// par. O eixo longitudinal em cada instante vem da diferenca entre
+// amostras consecutivas (segue as curvas da rota); parado, usa o
+// heading atual.
+// ============================================================
+
+void CollisionDetector::build_trajectories(const std::vector<Vehicle*>& vehicles) {
+    const size_t K = TRAJECTORY_SAMPLES;
+    traj_x_.resize(vehicles.size() * K);
+    traj_y_.resize(vehicles.size() * K);
+    traj_ux_.resize(vehicles.size() * K);
+    traj_uy_.resize(vehicles.size() * K);
+    half_length_.resize(vehicles.size());
+    half_width_.resize(vehicles.size());
+    vel_x_.resize(vehicles.size());
+    vel_y_.resize(vehicles.size());
+    vel_cov_.resize(vehicles.size());
+    pos_var_.resize(vehicles.size());
+
+    if (vehicles.empty()) return;
+
+    // Origem do plano local: escala fixa pra todo o tick
+    const Position& origin = vehicles.front()->sensed_position();
+    double m_per_deg_lat = EARTH_RADIUS * DEG_TO_RAD;
+    double m_per_deg_lon = m_per_deg_lat * std::cos(origin.latitude * DEG_TO_RAD);
+    origin_latitude_ = origin.latitude;
+    origin_longitude_ = origin.longitude;
+    m_per_deg_lon_ = m_per_deg_lon;
+
+    for (size_t i = 0; i < vehicles.size(); i++) {
+        const Vehicle& v = *vehicles[i];
+        if (!v.is_active()) continue;
+
+        double* x = &traj_x_[i * K];
+        double* y = &traj_y_[i * K];
+        double* ux = &traj_ux_[i * K];
+        double* uy = &traj_uy_[i * K];
+
+        for (size_t k = 0; k < K; k++) {
+            Position p = (k == 0) ? v.sensed_position() : v.predict_sensed_position(k * PREDICTION_STEP);
+            x[k] = (p.longitude - origin.longitude) * m_per_deg_lon;
+            y[k] = (p.latitude - origin.latitude) * m_per_deg_lat;
+        }
+
+        double heading_rad = v.sensed_telemetry().heading * DEG_TO_RAD;
+        double hx = std::sin(heading_rad);
+        double hy = std::cos(heading_rad);
+
+        double speed_ms = v.sensed_telemetry().speed * KMH_TO_MS;
+        vel_x_[i] = speed_ms * hx;
+        vel_y_[i] = speed_ms * hy;
+        vel_cov_[i] = risk::velocity_covariance(speed_ms, hx, hy);
+
+        // Com filtro, a incerteza dele (cresce no dropout); sem, a nominal
+        double sigma = v.sensed_position_sigma();
+        if (sigma <= 0.0) sigma = GnssNoise::POSITION_SIGMA;
+        pos_var_[i] = sigma * sigma;
+
+        for (size_t k = 0; k < K; k++) {
+            size_t k0 = (k + 1 < K) ? k : k - 1;
+            double ex = x[k0 + 1] - x[k0];
+            double ey = y[k0 + 1] - y[k0];
+            double len = std::sqrt(ex * ex + ey * ey);
+
+            if (len > 0.01) {
+                ux[k] = ex / len;
+                uy[k] = ey / len;
+            } else {
+                ux[k] = hx;
+                uy[k] = hy;
+            }
+        }
+
+        half_length_[i] = footprint_half_length(v);
+        half_width_[i] = footprint_half_width(v);
+    }
+}
+
+// ============================================================
+// Estagio 1: teste de circulo para um par de veiculos
 //
 // 1. Verifica distancia atual
-// 2. Projeta posicoes futuras (path prediction)
-// 3. Encontra o Closest Point of Approach (CPA)
-// 4. Se CPA < raio de seguranca, gera alerta com TTI
+// 2. Percorre as trajetorias previstas (path prediction)
+// 3. Acompanha o Closest Point of Approach (CPA)
+// 4. Instantes em que os circulos se sobrepoem vao pro SAT
 // ============================================================
 
-CollisionAlert CollisionDetector::check_pair(const Vehicle& v1, const Vehicle& v2) {
-    CollisionAlert no_alert{};
-    no_alert.priority = AlertPriority::NONE;
+template <typename Policy>
+void CollisionDetector::check_pair(const std::vector<Vehicle*>& vehicles,
+                                   size_t i, size_t j, size_t coarse) {
+    // Ultima amostra do horizonte da politica
+    constexpr size_t LAST = static_cast<size_t>(Policy::HORIZON / PREDICTION_STEP);
+    static_assert(LAST * PREDICTION_STEP == Policy::HORIZON, "horizonte fora da grade de amostras");
+    static_assert(LAST < TRAJECTORY_SAMPLES, "horizonte maior que a trajetoria prevista");
+    static_assert(Policy::CUTOFF <= MAX_PAIR_DISTANCE, "corte maior que o alcance do halo");
+    static_assert(Policy::STEP >= 1, "passo da politica");
+
+    const Vehicle& v1 = *vehicles[i];
+    const Vehicle& v2 = *vehicles[j];
 
     // Se ambos estao praticamente parados, sem risco
-    bool v1_moving = v1.telemetry().speed > MIN_SPEED_THRESHOLD;
-    bool v2_moving = v2.telemetry().speed > MIN_SPEED_THRESHOLD;
-    if (!v1_moving && !v2_moving) return no_alert;
+    bool v1_moving = v1.sensed_telemetry().speed > Policy::MIN_SPEED;
+    bool v2_moving = v2.sensed_telemetry().speed > Policy::MIN_SPEED;
+    if (!v1_moving && !v2_moving) return;
+
+    double safety_radius = combined_safety_radius(i, j);
 
-    double safety_radius = combined_safety_radius(v1, v2);
+    const size_t K = TRAJECTORY_SAMPLES;
+    const size_t a = i * K;
+    const size_t b = j * K;
+    const size_t stride = Policy::STEP * coarse;
 
     // Checar distancia atual primeiro
-    double current_dist = calculate_distance(v1.position(), v2.position());
+    double cx = traj_x_[b] - traj_x_[a];
+    double cy = traj_y_[b] - traj_y_[a];
+    double current_dist = std::sqrt(cx * cx + cy * cy);
 
     // Se ja esta muito longe, nem precisa projetar
     // (a 60 km/h em 15s percorre ~250m, entao 500m e um bom corte)
-    if (current_dist > 500.0) return no_alert;
+    if (current_dist > Policy::CUTOFF) return;
 
-    // Se ja esta dentro do raio agora
-    if (current_dist < safety_radius) {
-        using namespace std::chrono;
-        int64_t ts = duration_cast<milliseconds>(
-            system_clock::now().time_since_epoch()
-        ).count();
+    Candidate cand{i, j, 0, narrow_.size(), 0, current_dist, current_dist, 0, 1.0, 0, SIZE_MAX};
 
-        return CollisionAlert{
-            .vehicle_id_1 = v1.id(),
-            .vehicle_id_2 = v2.id(),
-            .priority = AlertPriority::CRITICAL,
-            .type = classify_alert(v1, v2),
-            .time_to_impact = 0.0,
-            .distance = current_dist,
-            .timestamp = ts
-        };
+    // Com stride > 1 a ultima amostra do horizonte entra sempre
+    size_t prev = 0;
+    for (size_t k = 0; ; ) {
+        size_t next = std::min(k + stride, LAST);
+
+        double dx = traj_x_[b + k] - traj_x_[a + k];
+        double dy = traj_y_[b + k] - traj_y_[a + k];
+        double dist = std::sqrt(dx * dx + dy * dy);
+
+        if (dist < cand.min_distance) {
+            cand.min_distance = dist;
+            cand.min_step = k;
+        }
+
+        // Varredura: metade do deslocamento relativo ate a proxima
+        // amostra testada, cobrindo o intervalo entre instantes
+        size_t k0 = (next > k) ? k : prev;
+        size_t k1 = (next > k) ? next : k;
+        double rx = (traj_x_[b + k1] - traj_x_[a + k1]) - (traj_x_[b + k0] - traj_x_[a + k0]);
+        double ry = (traj_y_[b + k1] - traj_y_[a + k1]) - (traj_y_[b + k0] - traj_y_[a + k0]);
+        double sweep = 0.5 * std::sqrt(rx * rx + ry * ry);
+
+        // Circulos se sobrepoem: candidato ao SAT neste instante
+        double margin = risk_mode_ ? risk_margin(i, j, k * PREDICTION_STEP) : 0.0;
+        if (dist < safety_radius + sweep + margin) {
+            narrow_.dx.push_back(dx);
+            narrow_.dy.push_back(dy);
+            narrow_.aux.push_back(traj_ux_[a + k]);
+            narrow_.auy.push_back(traj_uy_[a + k]);
+            narrow_.ahl.push_back(half_length_[i]);
+            narrow_.ahw.push_back(half_width_[i]);
+            narrow_.bux.push_back(traj_ux_[b + k]);
+            narrow_.buy.push_back(traj_uy_[b + k]);
+            narrow_.bhl.push_back(half_length_[j]);
+            narrow_.bhw.push_back(half_width_[j]);
+            narrow_.sweep.push_back(sweep);
+            narrow_.step.push_back(static_cast<uint32_t>(k));
+            cand.sample_count++;
+        }
+
+        // Se as trajetorias estao divergindo, para cedo
+        if (dist > current_dist * 1.5 && k * PREDICTION_STEP > 3.0) break;
+
+        if (next == k) break;
+        prev = k;
+        k = next;
+    }
+
+    if (cand.sample_count > 0) {
+        candidates_.push_back(cand);
+    }
+}
+
+// ============================================================
+// Tabela de politicas por classe de par
+//
+// Indice I -> (tipo A, tipo B, estado). So existem especializacoes
+// com A <= B: o par (B, A) usa a mesma. Politica com EVALUATE false
+// vira nullptr e o par nem entra no cache.
+// ============================================================
+
+template <size_t I>
+CollisionDetector::PairCheck CollisionDetector::pair_check_at() {
+    constexpr auto a = static_cast<VehicleType>(I / (TYPE_COUNT * STATE_COUNT));
+    constexpr auto b = static_cast<VehicleType>((I / STATE_COUNT) % TYPE_COUNT);
+    constexpr auto s = static_cast<CycleState>(I % STATE_COUNT);
+    using Policy = PairPolicy<(a <= b ? a : b), (a <= b ? b : a), s>;
+
+    if constexpr (Policy::EVALUATE) {
+        return &CollisionDetector::check_pair<Policy>;
+    } else {
+        return nullptr;
     }
+}
 
-    // Path Prediction: projeta posicoes no futuro
-    double min_distance = current_dist;
-    double tti = -1.0;
+template <size_t... I>
+std::array<CollisionDetector::PairCheck, sizeof...(I)>
+CollisionDetector::make_pair_dispatch(std::index_sequence<I...>) {
+    return {{ pair_check_at<I>()... }};
+}
 
-    for (double t = PREDICTION_STEP; t <= MAX_PREDICTION_TIME; t += PREDICTION_STEP) {
-        Position pos1 = v1.predict_position(t);
-        Position pos2 = v2.predict_position(t);
+const std::array<CollisionDetector::PairCheck, CollisionDetector::POLICY_COUNT>
+CollisionDetector::PAIR_DISPATCH = make_pair_dispatch(std::make_index_sequence<POLICY_COUNT>{});
+
+// v1 e o veiculo de slot menor (check_all ordena o par pelo slot).
+// A politica usa o estado do veiculo de tipo menor (o caminhao nos pares
+// com caminhao); em par do mesmo tipo vale o estado de v1, o de slot
+// menor, entao a classe de um par caminhao x caminhao nao depende de
+// qual dos dois esta carregando ou descarregando.
+CollisionDetector::PairCheck CollisionDetector::pair_check_for(const Vehicle& v1, const Vehicle& v2) {
+    size_t t1 = static_cast<size_t>(v1.type());
+    size_t t2 = static_cast<size_t>(v2.type());
+
+    const Vehicle& lower = (t1 <= t2) ? v1 : v2;
+    const Vehicle& upper = (t1 <= t2) ? v2 : v1;
+    CycleState state = lower.cycle_state();
+
+    // Caminhao sob a lanca da escavadeira que esta carregando ele
+    if (state == CycleState::LOADING && lower.type() == VehicleType::HAUL_TRUCK &&
+        upper.type() == VehicleType::EXCAVATOR && lower.loader() == upper.handle()) {
+        return nullptr;
+    }
 
-        double dist = calculate_distance(pos1, pos2);
+    return PAIR_DISPATCH[(t1 * TYPE_COUNT + t2) * STATE_COUNT + static_cast<size_t>(state)];
+}
 
-        if (dist < min_distance) {
-            min_distance = dist;
-            tti = t;
+bool CollisionDetector::can_coarsen(const PairState& ps, size_t i, size_t j) const {
+    // Sem historico do par: nao da pra saber a prioridade
+    if (!ps.valid) return false;
+    if (ps.tti >= 0.0 && priority_from_tti(ps.tti) > AlertPriority::LOW) return false;
+
+    const size_t K = TRAJECTORY_SAMPLES;
+    double dx = traj_x_[j * K] - traj_x_[i * K];
+    double dy = traj_y_[j * K] - traj_y_[i * K];
+    return dx * dx + dy * dy >= COARSE_MIN_DISTANCE * COARSE_MIN_DISTANCE;
+}
+
+// ============================================================
+// Estagio 2: SAT de retangulos orientados em lote
+//
+// Eixos de separacao: longitudinal e lateral de A e de B.
+// Com c = |uA.uB| e x = |uA x uB|, o raio projetado de cada
+// retangulo sai direto das meias-dimensoes; a varredura do
+// deslocamento relativo entre amostras soma em todos os eixos. Sem desvios no laco,
+// o compilador vetoriza sobre todas as amostras de todos os pares.
+// ============================================================
+
+void CollisionDetector::run_narrowphase() {
+    const size_t n = narrow_.size();
+    narrow_.hit.resize(n);
+
+    const double* dx = narrow_.dx.data();
+    const double* dy = narrow_.dy.data();
+    const double* aux = narrow_.aux.data();
+    const double* auy = narrow_.auy.data();
+    const double* ahl = narrow_.ahl.data();
+    const double* ahw = narrow_.ahw.data();
+    const double* bux = narrow_.bux.data();
+    const double* buy = narrow_.buy.data();
+    const double* bhl = narrow_.bhl.data();
+    const double* bhw = narrow_.bhw.data();
+    const double* sweep = narrow_.sweep.data();
+    uint8_t* hit = narrow_.hit.data();
+
+    for (size_t s = 0; s < n; s++) {
+        double c = std::abs(aux[s] * bux[s] + auy[s] * buy[s]);
+        double x = std::abs(aux[s] * buy[s] - auy[s] * bux[s]);
+
+        double pa_u = std::abs(dx[s] * aux[s] + dy[s] * auy[s]);
+        double pa_v = std::abs(dy[s] * aux[s] - dx[s] * auy[s]);
+        double pb_u = std::abs(dx[s] * bux[s] + dy[s] * buy[s]);
+        double pb_v = std::abs(dy[s] * bux[s] - dx[s] * buy[s]);
+
+        bool separated =
+            (pa_u > ahl[s] + bhl[s] * c + bhw[s] * x + sweep[s]) |
+            (pa_v > ahw[s] + bhl[s] * x + bhw[s] * c + sweep[s]) |
+            (pb_u > bhl[s] + ahl[s] * c + ahw[s] * x + sweep[s]) |
+            (pb_v > bhw[s] + ahl[s] * x + ahw[s] * c + sweep[s]);
+
+        hit[s] = static_cast<uint8_t>(!separated);
+    }
+}
+
+// ============================================================
+// Estagio 3: probabilidade de colisao (modo de risco)
+//
+// Por amostra, a gaussiana da posicao relativa e projetada nos eixos
+// de A e integrada na caixa de extensoes do SAT nesses eixos. A
+// probabilidade do par e a maior entre as amostras (as amostras
+// compartilham o mesmo erro de GNSS, nao sao eventos independentes).
+// Se a amostra de maior risco cai numa faixa ambigua e a caixa ou a
+// separacao dos eixos e ruim, o Monte Carlo decide.
+// ============================================================
+
+Covariance2 CollisionDetector::relative_covariance(size_t i, size_t j, double t) const {
+    const double pos = pos_var_[i] + pos_var_[j];
+    const double t2 = t * t;
+    return Covariance2{
+        .xx = pos + t2 * (vel_cov_[i].xx + vel_cov_[j].xx),
+        .xy = t2 * (vel_cov_[i].xy + vel_cov_[j].xy),
+        .yy = pos + t2 * (vel_cov_[i].yy + vel_cov_[j].yy)
+    };
+}
+
+double CollisionDetector::risk_margin(size_t i, size_t j, double t) const {
+    // sqrt do traco >= maior desvio em qualquer direcao
+    Covariance2 cov = relative_covariance(i, j, t);
+    return RISK_SIGMA_MARGIN * std::sqrt(cov.xx + cov.yy);
+}
+
+void CollisionDetector::compute_risk() {
+    for (Candidate& cand : candidates_) {
+        size_t end = cand.first_sample + cand.sample_count;
+
+        double best = 0.0;
+        size_t best_s = cand.first_sample;
+        double best_rho = 0.0;
+        cand.risk_sample = end;
+
+        for (size_t s = cand.first_sample; s < end; s++) {
+            Covariance2 cov = relative_covariance(cand.i, cand.j, narrow_.step[s] * PREDICTION_STEP);
+
+            double ux = narrow_.aux[s];
+            double uy = narrow_.auy[s];
+            double mu = narrow_.dx[s] * ux + narrow_.dy[s] * uy;
+            double mv = narrow_.dy[s] * ux - narrow_.dx[s] * uy;
+            double suu = ux * ux * cov.xx + 2.0 * ux * uy * cov.xy + uy * uy * cov.yy;
+            double svv = uy * uy * cov.xx - 2.0 * ux * uy * cov.xy + ux * ux * cov.yy;
+            double suv = ux * uy * (cov.yy - cov.xx) + (ux * ux - uy * uy) * cov.xy;
+
+            double c_ab = std::abs(ux * narrow_.bux[s] + uy * narrow_.buy[s]);
+            double x_ab = std::abs(ux * narrow_.buy[s] - uy * narrow_.bux[s]);
+            double lu = narrow_.ahl[s] + narrow_.bhl[s] * c_ab + narrow_.bhw[s] * x_ab + narrow_.sweep[s];
+            double lv = narrow_.ahw[s] + narrow_.bhl[s] * x_ab + narrow_.bhw[s] * c_ab + narrow_.sweep[s];
+
+            double p = risk::box_probability(mu, mv, std::sqrt(suu), std::sqrt(svv), lu, lv);
+            if (p > best) {
+                best = p;
+                best_s = s;
+                best_rho = std::abs(suv) / std::sqrt(suu * svv);
+            }
+            if (cand.risk_sample == end && p >= RISK_ALERT_PROBABILITY) {
+                cand.risk_sample = s;
+            }
+
+            // Ja e praticamente certo: as demais amostras nao mudam nada
+            if (best > RISK_AMBIGUOUS_MAX) break;
         }
 
-        // Se as trajetorias estao divergindo, para cedo
-        if (dist > current_dist * 1.5 && t > 3.0) break;
+        cand.probability = best;
+        if (cand.risk_sample == end) cand.risk_sample = best_s;
+
+        // Amostra de maior risco ambigua: Monte Carlo com o SAT completo
+        double oblique = std::abs(narrow_.aux[best_s] * narrow_.bux[best_s] +
+                                  narrow_.auy[best_s] * narrow_.buy[best_s]) *
+                         std::abs(narrow_.aux[best_s] * narrow_.buy[best_s] -
+                                  narrow_.auy[best_s] * narrow_.bux[best_s]);
+        if (best >= RISK_AMBIGUOUS_MIN && best <= RISK_AMBIGUOUS_MAX &&
+            (best_rho > RISK_CORRELATION_LIMIT || oblique > RISK_OBLIQUE_LIMIT)) {
+            Covariance2 cov = relative_covariance(cand.i, cand.j, narrow_.step[best_s] * PREDICTION_STEP);
+            cand.monte_carlo = monte_carlo_.add(narrow_.dx[best_s], narrow_.dy[best_s], cov,
+                                           narrow_.aux[best_s], narrow_.auy[best_s],
+                                           narrow_.ahl[best_s], narrow_.ahw[best_s],
+                                           narrow_.bux[best_s], narrow_.buy[best_s],
+                                           narrow_.bhl[best_s], narrow_.bhw[best_s],
+                                           narrow_.sweep[best_s]);
+        }
     }
 
-    // Se o CPA esta dentro do raio de seguranca, gera alerta
-    if (min_distance < safety_radius && tti > 0) {
-        AlertPriority priority = priority_from_tti(tti);
+    if (monte_carlo_.size() == 0) return;
+    monte_carlo_.run();
+
+    for (Candidate& cand : candidates_) {
+        if (cand.monte_carlo != SIZE_MAX) {
+            cand.probability = monte_carlo_.probability(cand.monte_carlo);
+        }
+    }
+}
+
+// ============================================================
+// Alertas: TTI = primeiro instante com retangulos sobrepostos
+// ============================================================
 
-        using namespace std::chrono;
-        int64_t ts = duration_cast<milliseconds>(
-            system_clock::now().time_since_epoch()
-        ).count();
+void CollisionDetector::emit_alerts(const std::vector<Vehicle*>& vehicles, int64_t ts,
+                                    std::vector<CollisionAlert>& alerts) {
+    for (const auto& cand : candidates_) {
+        size_t end = cand.first_sample + cand.sample_count;
+        size_t s = cand.first_sample;
+        while (s < end && !narrow_.hit[s]) s++;
+        if (s == end) {
+            // Circulos tocam, retangulos nao. No modo de risco o ruido
+            // ainda pode levar a sobreposicao: alerta pela probabilidade.
+            if (!risk_mode_ || cand.probability < RISK_ALERT_PROBABILITY) continue;
+            s = cand.risk_sample;
+        }
 
-        return CollisionAlert{
+        const Vehicle& v1 = *vehicles[cand.i];
+        const Vehicle& v2 = *vehicles[cand.j];
+
+        double tti = narrow_.step[s] * PREDICTION_STEP;
+        pair_states_.at(cand.pair).tti = tti;
+
+        // Ja esta dentro da area de seguranca agora
+        if (narrow_.step[s] == 0) {
+            alerts.push_back(CollisionAlert{
+                .vehicle_id_1 = v1.id(),
+                .vehicle_id_2 = v2.id(),
+                .priority = AlertPriority::CRITICAL,
+                .type = classify_alert(v1, v2),
+                .time_to_impact = 0.0,
+                .distance = cand.current_distance,
+                .probability = cand.probability,
+                .cpa = pair_midpoint(vehicles, cand.i, cand.j, 0),
+                .timestamp = ts,
+                .slot_1 = v1.handle().slot,
+                .slot_2 = v2.handle().slot
+            });
+            continue;
+        }
+
+        AlertPriority priority = priority_from_tti(tti);
+        if (priority == AlertPriority::NONE) continue;
+
+        alerts.push_back(CollisionAlert{
             .vehicle_id_1 = v1.id(),
             .vehicle_id_2 = v2.id(),
             .priority = priority,
             .type = classify_alert(v1, v2),
             .time_to_impact = tti,
-            .distance = min_distance,
-            .timestamp = ts
-        };
+            .distance = cand.min_distance,
+            .probability = cand.probability,
+            .cpa = pair_midpoint(vehicles, cand.i, cand.j, cand.min_step),
+            .timestamp = ts,
+            .slot_1 = v1.handle().slot,
+            .slot_2 = v2.handle().slot
+        });
     }
+}
 
-    return no_alert;
+// Mesmo ponto das amostras do teste de circulo: o CPA do alerta e
+// exatamente onde a distancia minima entre centros foi medida
+Position CollisionDetector::pair_midpoint(const std::vector<Vehicle*>& vehicles,
+                                          size_t i, size_t j, size_t k) const {
+    const size_t K = TRAJECTORY_SAMPLES;
+    double x = 0.5 * (traj_x_[i * K + k] + traj_x_[j * K + k]);
+    double y = 0.5 * (traj_y_[i * K + k] + traj_y_[j * K + k]);
+    return Position{
+        origin_latitude_ + y / (EARTH_RADIUS * DEG_TO_RAD),
+        origin_longitude_ + x / m_per_deg_lon_,
+        0.5 * (vehicles[i]->sensed_position().altitude + vehicles[j]->sensed_position().altitude)
+    };
+}
+
+// ============================================================
+// Agenda de reavaliacao por par
+//
+// Com velocidades constantes a distancia entre dois veiculos cai
+// no maximo |v_rel| por segundo. Somando a variacao de velocidade
+// permitida antes de invalidar a agenda (SPEED/HEADING_CHANGE_
+// THRESHOLD), o limite vale ate a proxima mudanca detectada:
+//
+//   t_conflito >= (distancia - raio) / v_max_aproximacao
+//
+// O par so precisa voltar quando t_conflito entra no horizonte de
+// predicao (menos um tick de margem). Pares candidatos ou perto
+// continuam sendo avaliados todo tick.
+// ============================================================
+
+bool CollisionDetector::can_defer(const PairState& ps, const Vehicle& v1,
+                                  const Vehicle& v2, double now) const {
+    if (!ps.valid || now >= ps.next_eval) return false;
+
+    auto heading_delta = [](double a, double b) {
+        double d = std::abs(a - b);
+        return (d > 180.0) ? 360.0 - d : d;
+    };
+
+    if (std::abs(v1.sensed_telemetry().speed - ps.speed1) > SPEED_CHANGE_THRESHOLD) return false;
+    if (std::abs(v2.sensed_telemetry().speed - ps.speed2) > SPEED_CHANGE_THRESHOLD) return false;
+    if (heading_delta(v1.sensed_telemetry().heading, ps.heading1) > HEADING_CHANGE_THRESHOLD) return false;
+    if (heading_delta(v2.sensed_telemetry().heading, ps.heading2) > HEADING_CHANGE_THRESHOLD) return false;
+
+    return true;
+}
+
+void CollisionDetector::schedule_pair(size_t i, size_t j, PairState& ps,
+                                      const Vehicle& v1, const Vehicle& v2,
+                                      bool candidate, double now, double tick_margin) {
+    const size_t K = TRAJECTORY_SAMPLES;
+    double dx = traj_x_[j * K] - traj_x_[i * K];
+    double dy = traj_y_[j * K] - traj_y_[i * K];
+    double dist = std::sqrt(dx * dx + dy * dy);
+
+    double rvx = vel_x_[j] - vel_x_[i];
+    double rvy = vel_y_[j] - vel_y_[i];
+
+    ps.valid = true;
+    ps.last_distance = dist;
+    ps.closing_speed = (dist > 0.0) ? -(dx * rvx + dy * rvy) / dist : 0.0;
+    ps.tti = -1.0;
+    ps.speed1 = v1.sensed_telemetry().speed;
+    ps.heading1 = v1.sensed_telemetry().heading;
+    ps.speed2 = v2.sensed_telemetry().speed;
+    ps.heading2 = v2.sensed_telemetry().heading;
+
+    if (candidate || dist < FULL_RATE_DISTANCE) {
+        ps.next_eval = now;
+        return;
+    }
+
+    // Maior velocidade de aproximacao possivel sem invalidar a agenda
+    double heading_slack = HEADING_CHANGE_THRESHOLD * DEG_TO_RAD;
+    double speed_slack = SPEED_CHANGE_THRESHOLD * KMH_TO_MS;
+    double max_closing = std::sqrt(rvx * rvx + rvy * rvy)
+        + 2.0 * speed_slack
+        + (ps.speed1 + ps.speed2) * KMH_TO_MS * heading_slack;
+
+    // Raio combinado + varredura de um passo de predicao
+    // (+ folga do ruido no fim do horizonte, no modo de risco)
+    double gap = dist - combined_safety_radius(i, j) - max_closing * PREDICTION_STEP;
+    if (risk_mode_) gap -= risk_margin(i, j, MAX_PREDICTION_TIME);
+    if (gap <= 0.0) {
+        ps.next_eval = now;
+        return;
+    }
+
+    double earliest_conflict = gap / max_closing;
+    ps.next_eval = now + std::max(0.0, earliest_conflict - MAX_PREDICTION_TIME - tick_margin);
+}
+
+void CollisionDetector::NarrowphaseBatch::clear() {
+    dx.clear();
+    dy.clear();
+    aux.clear();
+    auy.clear();
+    ahl.clear();
+    ahw.clear();
+    bux.clear();
+    buy.clear();
+    bhl.clear();
+    bhw.clear();
+    sweep.clear();
+    step.clear();
+    hit.clear();
+}
+
+size_t CollisionDetector::NarrowphaseBatch::heap_bytes() const {
+    using footprint::heap_bytes;
+    return heap_bytes(dx) + heap_bytes(dy) +
+           heap_bytes(aux) + heap_bytes(auy) + heap_bytes(ahl) + heap_bytes(ahw) +
+           heap_bytes(bux) + heap_bytes(buy) + heap_bytes(bhl) + heap_bytes(bhw) +
+           heap_bytes(sweep) + heap_bytes(step) + heap_bytes(hit);
+}
+
+// ============================================================
+// Instrumentacao de memoria
+// ============================================================
+
+MemoryFootprint CollisionDetector::footprint() const {
+    using footprint::heap_bytes;
+
+    MemoryFootprint fp{
+        .vehicles = half_length_.size(),
+        .per_vehicle_bytes = 0,
+        .pair_entries = pair_states_.size(),
+        .pair_bytes = pair_states_.heap_bytes() + previous_pairs_.heap_bytes(),
+        .shared_bytes = 0
+    };
+
+    fp.per_vehicle_bytes = heap_bytes(traj_x_) + heap_bytes(traj_y_) +
+                           heap_bytes(traj_ux_) + heap_bytes(traj_uy_) +
+                           heap_bytes(half_length_) + heap_bytes(half_width_) +
+                           heap_bytes(vel_x_) + heap_bytes(vel_y_) +
+                           heap_bytes(cell_of_) + heap_bytes(cell_items_) +
+                           heap_bytes(occupancy_) + heap_bytes(zone_bound_);
+    for (const auto& occ : occupancy_) {
+        fp.per_vehicle_bytes += heap_bytes(occ);
+    }
+
+    fp.per_vehicle_bytes += heap_bytes(vel_cov_);
+    fp.per_vehicle_bytes += heap_bytes(pos_var_);
+
+    fp.shared_bytes = heap_bytes(candidates_) + narrow_.heap_bytes() + monte_carlo_.heap_bytes() +
+                      heap_bytes(cell_start_) + heap_bytes(near_pairs_);
+    return fp;
 }
 
 // ============================================================
@@ -125,8 +945,8 @@ CollisionAlert CollisionDetector::check_pair(const Vehicle& v1, const Vehicle& v
 // ============================================================
 
 AlertType CollisionDetector::classify_alert(const Vehicle& v1, const Vehicle& v2) const {
-    double h1 = v1.telemetry().heading;
-    double h2 = v2.telemetry().heading;
+    double h1 = v1.sensed_telemetry().heading;
+    double h2 = v2.sensed_telemetry().heading;
 
     // Diferenca de heading
     double diff = std::abs(h1 - h2);
@@ -167,26 +987,33 @@ AlertPriority CollisionDetector::priority_from_tti(double tti) const {
 // Raio de seguranca combinado
 // ============================================================
 
-double CollisionDetector::combined_safety_radius(const Vehicle& v1, const Vehicle& v2) const {
-    // Usa o maior raio + margem
-    double r1 = v1.safety_radius();
-    double r2 = v2.safety_radius();
-    return r1 + r2;
+double CollisionDetector::combined_safety_radius(size_t i, size_t j) const {
+    // Circulos que envolvem os retangulos de seguranca:
+    // rejeicao conservadora antes do SAT
+    double l1 = half_length_[i];
+    double w1 = half_width_[i];
+    double l2 = half_length_[j];
+    double w2 = half_width_[j];
+    return std::sqrt(l1 * l1 + w1 * w1) + std::sqrt(l2 * l2 + w2 * w2);
 }
 
 // ============================================================
-// Distancia entre duas posicoes em metros (Haversine simplificado)
+// Retangulo de seguranca a partir de VehicleSpec
+//
+// Lateral: meia largura + side_clearance. Longitudinal: o maior
+// alcance que ainda cabe no circulo de safety_radius, de modo que
+// o retangulo nunca e mais conservador que o circulo antigo.
 // ============================================================
 
-double CollisionDetector::calculate_distance(const Position& a, const Position& b) const {
-    double dlat = (b.latitude - a.latitude) * DEG_TO_RAD;
-    double dlon = (b.longitude - a.longitude) * DEG_TO_RAD;
-    double cos_lat = std::cos(a.latitude * DEG_TO_RAD);
-
-    double dx = dlon * cos_lat * EARTH_RADIUS;
-    double dy = dlat * EARTH_RADIUS;
+double CollisionDetector::footprint_half_length(const Vehicle& v) {
+    double r = v.spec().safety_radius;
+    double hw = footprint_half_width(v);
+    double inscribed = (r > hw) ? std::sqrt(r * r - hw * hw) : 0.0;
+    return std::max(v.spec().length * 0.5, inscribed);
+}
 
-    return std::sqrt(dx * dx + dy * dy);
+double CollisionDetector::footprint_half_width(const Vehicle& v) {
+    return v.spec().width * 0.5 + v.spec().side_clearance;
 }
 
 } // namespace mineguard
@@ -0,0 +1,162 @@
+#include "collision_risk.hpp"
+#include "memory_footprint.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace mineguard {
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr uint32_t MONTE_CARLO_SEED = 20240611;
+
+// ============================================================
+// Fechada: gaussiana separavel nos eixos de A
+// ============================================================
+
+namespace risk {
+
+Covariance2 velocity_covariance(double speed_ms, double ux, double uy) {
+    double s_long = GnssNoise::SPEED_SIGMA;
+    double s_lat = speed_ms * GnssNoise::HEADING_SIGMA * DEG_TO_RAD +
+                   GnssNoise::LOW_SPEED_LATERAL_SIGMA;
+    double var_long = s_long * s_long;
+    double var_lat = s_lat * s_lat;
+
+    // R diag(long, lat) R^T com R = [u, u_perp]
+    return Covariance2{
+        .xx = var_long * ux * ux + var_lat * uy * uy,
+        .xy = (var_long - var_lat) * ux * uy,
+        .yy = var_long * uy * uy + var_lat * ux * ux
+    };
+}
+
+// P(|x - m| <= l) com x ~ N(m, s)
+static double interval_probability(double m, double s, double l) {
+    const double k = 1.0 / (s * std::sqrt(2.0));
+    return 0.5 * (std::erfc((m - l) * k) - std::erfc((m + l) * k));
+}
+
+double box_probability(double mu, double mv, double su, double sv, double lu, double lv) {
+    return interval_probability(mu, su, lu) * interval_probability(mv, sv, lv);
+}
+
+} // namespace risk
+
+// ============================================================
+// Monte Carlo em lote
+//
+// Mesmo SAT do narrowphase, com o centro de B deslocado por L z
+// (Cholesky da covariancia relativa). O laco interno sobre os pontos
+// nao tem desvios: o compilador vetoriza como no narrowphase.
+// ============================================================
+
+MonteCarloRisk::MonteCarloRisk()
+    : z1_(MONTE_CARLO_SAMPLES)
+    , z2_(MONTE_CARLO_SAMPLES)
+{
+    // Box-Muller com pares antiteticos: media amostral exatamente zero
+    std::mt19937 rng(MONTE_CARLO_SEED);
+    const double inv = 1.0 / 4294967296.0;
+    for (size_t n = 0; n + 1 < MONTE_CARLO_SAMPLES; n += 2) {
+        double u1 = (static_cast<double>(rng()) + 0.5) * inv;
+        double u2 = (static_cast<double>(rng()) + 0.5) * inv;
+        double r = std::sqrt(-2.0 * std::log(u1));
+        double a = 2.0 * M_PI * u2;
+        z1_[n] = r * std::cos(a);
+        z2_[n] = r * std::sin(a);
+        z1_[n + 1] = -z1_[n];
+        z2_[n + 1] = -z2_[n];
+    }
+}
+
+void MonteCarloRisk::clear() {
+    mx_.clear();
+    my_.clear();
+    l11_.clear();
+    l21_.clear();
+    l22_.clear();
+    aux_.clear();
+    auy_.clear();
+    ahl_.clear();
+    ahw_.clear();
+    bux_.clear();
+    buy_.clear();
+    bhl_.clear();
+    bhw_.clear();
+    sweep_.clear();
+    probability_.clear();
+}
+
+size_t MonteCarloRisk::add(double mx, double my, const Covariance2& cov,
+                           double aux, double auy, double ahl, double ahw,
+                           double bux, double buy, double bhl, double bhw, double sweep) {
+    // Cholesky 2x2 (cov e positiva: tem o ruido de posicao na diagonal)
+    double l11 = std::sqrt(cov.xx);
+    double l21 = cov.xy / l11;
+    double l22 = std::sqrt(std::max(cov.yy - l21 * l21, 0.0));
+
+    mx_.push_back(mx);
+    my_.push_back(my);
+    l11_.push_back(l11);
+    l21_.push_back(l21);
+    l22_.push_back(l22);
+    aux_.push_back(aux);
+    auy_.push_back(auy);
+    ahl_.push_back(ahl);
+    ahw_.push_back(ahw);
+    bux_.push_back(bux);
+    buy_.push_back(buy);
+    bhl_.push_back(bhl);
+    bhw_.push_back(bhw);
+    sweep_.push_back(sweep);
+    return mx_.size() - 1;
+}
+
+void MonteCarloRisk::run() {
+    const size_t n = size();
+    probability_.resize(n);
+
+    const double* z1 = z1_.data();
+    const double* z2 = z2_.data();
+
+    for (size_t q = 0; q < n; q++) {
+        const double mx = mx_[q], my = my_[q];
+        const double l11 = l11_[q], l21 = l21_[q], l22 = l22_[q];
+        const double aux = aux_[q], auy = auy_[q], bux = bux_[q], buy = buy_[q];
+        const double c = std::abs(aux * bux + auy * buy);
+        const double x = std::abs(aux * buy - auy * bux);
+
+        // Extensoes do SAT: so dependem da geometria, fora do laco
+        const double ra_u = ahl_[q] + bhl_[q] * c + bhw_[q] * x + sweep_[q];
+        const double ra_v = ahw_[q] + bhl_[q] * x + bhw_[q] * c + sweep_[q];
+        const double rb_u = bhl_[q] + ahl_[q] * c + ahw_[q] * x + sweep_[q];
+        const double rb_v = bhw_[q] + ahl_[q] * x + ahw_[q] * c + sweep_[q];
+
+        uint32_t inside = 0;
+        for (size_t s = 0; s < MONTE_CARLO_SAMPLES; s++) {
+            double dx = mx + l11 * z1[s];
+            double dy = my + l21 * z1[s] + l22 * z2[s];
+
+            bool separated =
+                (std::abs(dx * aux + dy * auy) > ra_u) |
+                (std::abs(dy * aux - dx * auy) > ra_v) |
+                (std::abs(dx * bux + dy * buy) > rb_u) |
+                (std::abs(dy * bux - dx * buy) > rb_v);
+            inside += static_cast<uint32_t>(!separated);
+        }
+
+        probability_[q] = static_cast<double>(inside) / MONTE_CARLO_SAMPLES;
+    }
+}
+
+size_t MonteCarloRisk::heap_bytes() const {
+    using footprint::heap_bytes;
+    return heap_bytes(z1_) + heap_bytes(z2_) +
+           heap_bytes(mx_) + heap_bytes(my_) +
+           heap_bytes(l11_) + heap_bytes(l21_) + heap_bytes(l22_) +
+           heap_bytes(aux_) + heap_bytes(auy_) + heap_bytes(ahl_) + heap_bytes(ahw_) +
+           heap_bytes(bux_) + heap_bytes(buy_) + heap_bytes(bhl_) + heap_bytes(bhw_) +
+           heap_bytes(sweep_) + heap_bytes(probability_);
+}
+
+} // namespace mineguard
@@ -0,0 +1,244 @@
+#include "conflict_zones.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace mineguard {
+
+// ============================================================
+// Montagem da tabela (startup)
+//
+// 1. Amostra cada rota a cada SAMPLE_STEP metros
+// 2. Indexa as amostras numa grade de CELL_SIZE
+// 3. Amostras de rotas diferentes a menos de CLEARANCE marcam
+//    suas celulas como zona de conflito
+// 4. Para cada rota, converte as celulas marcadas em intervalos
+//    de comprimento de arco
+// ============================================================
+
+void ConflictZoneTable::build(const std::vector<const RoutePath*>& paths) {
+    zones_.clear();
+    cell_zone_.clear();
+    intervals_.clear();
+
+    if (paths.empty() || paths.front()->points.empty()) return;
+
+    const RoutePath& ref = *paths.front();
+    lat0_ = ref.points.front().latitude;
+    lon0_ = ref.points.front().longitude;
+    m_per_deg_lat_ = ref.m_per_deg_lat;
+    m_per_deg_lon_ = ref.m_per_deg_lon;
+
+    // 1. Amostragem das rotas
+    std::vector<Sample> samples;
+    std::vector<size_t> path_begin;
+    for (size_t p = 0; p < paths.size(); p++) {
+        path_begin.push_back(samples.size());
+
+        double length = paths[p]->length();
+        for (double s = 0.0; ; s += SAMPLE_STEP) {
+            if (s > length) s = length;
+
+            Sample sample{};
+            to_local(paths[p]->position_at(s), sample.x, sample.y);
+            sample.s = s;
+            sample.path = p;
+            samples.push_back(sample);
+
+            if (s >= length) break;
+        }
+    }
+    path_begin.push_back(samples.size());
+
+    // 2. Grade espacial das amostras
+    std::unordered_map<int64_t, std::vector<size_t>> grid;
+    for (size_t i = 0; i < samples.size(); i++) {
+        grid[cell_of(samples[i].x, samples[i].y)].push_back(i);
+    }
+
+    // 3. Cruzamento entre rotas diferentes (so celulas vizinhas)
+    std::unordered_set<int64_t> marked;
+    const double clearance_sq = CLEARANCE * CLEARANCE;
+
+    for (const auto& [key, cell_samples] : grid) {
+        int cx = cell_x(key);
+        int cy = cell_y(key);
+        if (marked.count(key)) continue;
+
+        bool conflict = false;
+        for (int dx = -1; dx <= 1 && !conflict; dx++) {
+            for (int dy = -1; dy <= 1 && !conflict; dy++) {
+                auto it = grid.find(cell_key(cx + dx, cy + dy));
+                if (it == grid.end()) continue;
+
+                for (size_t i : cell_samples) {
+                    for (size_t j : it->second) {
+                        if (samples[i].path == samples[j].path) continue;
+
+                        double ex = samples[i].x - samples[j].x;
+                        double ey = samples[i].y - samples[j].y;
+                        if (ex * ex + ey * ey < clearance_sq) {
+                            conflict = true;
+                            break;
+                        }
+                    }
+                    if (conflict) break;
+                }
+            }
+        }
+
+        if (conflict) marked.insert(key);
+    }
+
+    // Numeracao deterministica das zonas
+    std::vector<int64_t> keys(marked.begin(), marked.end());
+    std::sort(keys.begin(), keys.end());
+
+    for (int64_t key : keys) {
+        int cx = cell_x(key);
+        int cy = cell_y(key);
+
+        cell_zone_[key] = static_cast<int>(zones_.size());
+        zones_.push_back(ConflictZone{
+            .x = (cx + 0.5) * CELL_SIZE,
+            .y = (cy + 0.5) * CELL_SIZE,
+            .neighbors = {}
+        });
+    }
+
+    for (size_t z = 0; z < keys.size(); z++) {
+        int cx = cell_x(keys[z]);
+        int cy = cell_y(keys[z]);
+
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                auto it = cell_zone_.find(cell_key(cx + dx, cy + dy));
+                if (it != cell_zone_.end()) {
+                    zones_[z].neighbors.push_back(it->second);
+                }
+            }
+        }
+    }
+
+    // 4. Intervalos de arco de cada rota dentro das zonas
+    for (size_t p = 0; p < paths.size(); p++) {
+        auto& intervals = intervals_[paths[p]];
+        double half_step = SAMPLE_STEP * 0.5;
+
+        for (size_t i = path_begin[p]; i < path_begin[p + 1]; i++) {
+            auto it = cell_zone_.find(cell_of(samples[i].x, samples[i].y));
+            if (it == cell_zone_.end()) continue;
+
+            double s_begin = std::max(0.0, samples[i].s - half_step);
+            double s_end = samples[i].s + half_step;
+
+            // Estende o intervalo anterior se continua na mesma zona
+            if (!intervals.empty() && intervals.back().zone == it->second &&
+                intervals.back().s_end >= s_begin) {
+                intervals.back().s_end = s_end;
+            } else {
+                intervals.push_back(ZoneInterval{it->second, s_begin, s_end});
+            }
+        }
+    }
+}
+
+// ============================================================
+// Ocupacao por tick: intervalo de arco -> janelas por zona
+// ============================================================
+
+void ConflictZoneTable::occupancy(const RoutePath* path, double s_now,
+                                  double speed_ms, double max_speed_ms, double horizon,
+                                  std::vector<ZoneOccupancy>& out) const {
+    out.clear();
+
+    auto it = intervals_.find(path);
+    if (it == intervals_.end()) return;
+
+    // Rota fechada: considera tambem a proxima volta
+    int laps = path->closed ? 2 : 1;
+    double length = path->length();
+    if (max_speed_ms < 0.01) max_speed_ms = 0.01;
+
+    for (int lap = 0; lap < laps; lap++) {
+        double offset = lap * length;
+
+        for (const auto& iv : it->second) {
+            double a = iv.s_begin + offset;
+            double b = iv.s_end + offset;
+            if (b < s_now) continue;  // ja passou
+
+            double t_enter = (a <= s_now) ? 0.0 : (a - s_now) / max_speed_ms;
+            if (t_enter > horizon) continue;
+
+            double t_exit = horizon;
+            if (speed_ms > 0.01) {
+                t_exit = std::min(horizon, (b - s_now) / speed_ms * EXIT_SLACK);
+            }
+
+            out.push_back(ZoneOccupancy{iv.zone, t_enter, std::max(t_enter, t_exit)});
+        }
+    }
+}
+
+bool ConflictZoneTable::windows_overlap(const std::vector<ZoneOccupancy>& a,
+                                        const std::vector<ZoneOccupancy>& b) const {
+    for (const auto& oa : a) {
+        const auto& neighbors = zones_[oa.zone].neighbors;
+
+        for (const auto& ob : b) {
+            if (oa.t_enter > ob.t_exit || ob.t_enter > oa.t_exit) continue;
+            if (std::find(neighbors.begin(), neighbors.end(), ob.zone) != neighbors.end()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// ============================================================
+// Plano local e grade
+// ============================================================
+
+void ConflictZoneTable::to_local(const Position& p, double& x, double& y) const {
+    x = (p.longitude - lon0_) * m_per_deg_lon_;
+    y = (p.latitude - lat0_) * m_per_deg_lat_;
+}
+
+int64_t ConflictZoneTable::cell_key(int cx, int cy) {
+    uint64_t hi = static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32;
+    return static_cast<int64_t>(hi | static_cast<uint32_t>(cy));
+}
+
+int ConflictZoneTable::cell_x(int64_t key) {
+    return static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint64_t>(key) >> 32));
+}
+
+int ConflictZoneTable::cell_y(int64_t key) {
+    return static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint64_t>(key)));
+}
+
+int64_t ConflictZoneTable::cell_of(double x, double y) const {
+    int cx = static_cast<int>(std::floor(x / CELL_SIZE));
+    int cy = static_cast<int>(std::floor(y / CELL_SIZE));
+    return cell_key(cx, cy);
+}
+
+// ============================================================
+// Instrumentacao de memoria
+// ============================================================
+
+size_t ConflictZoneTable::heap_bytes() const {
+    size_t bytes = footprint::heap_bytes(zones_) +
+                   footprint::heap_bytes(cell_zone_) +
+                   footprint::heap_bytes(intervals_);
+    for (const auto& zone : zones_) {
+        bytes += footprint::heap_bytes(zone.neighbors);
+    }
+    for (const auto& entry : intervals_) {
+        bytes += footprint::heap_bytes(entry.second);
+    }
+    return bytes;
+}
+
+} // namespace mineguard
@@ -0,0 +1,178 @@
+#include "gnss_error.hpp"
+#include "kalman_filter.hpp"
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+using namespace mineguard;
+
+// ============================================================
+// Benchmark do pipeline de GNSS
+//
+// Frota sintetica em circulos no plano local (velocidade constante,
+// curva continua: o pior caso pro modelo de velocidade constante).
+// O vies do receptor passa pelo filtro: so o ruido branco cai.
+// Por tick: erro do receptor + medida por veiculo (escalar) e o
+// step do filtro em lote. Mede tempo por tick e por veiculo e o
+// erro RMS do fix bruto contra a estimativa filtrada.
+// ============================================================
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    size_t vehicles = 10000;
+    int ticks = 1000;
+    double delta_time = 1.0;
+    double dropout_rate = 0.002;
+};
+
+static int64_t percentile(std::vector<int64_t> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * (v.size() - 1));
+    return v[rank];
+}
+
+void print_usage(const char* prog) {
+    std::cout << "MineGuard GNSS filter benchmark\n\n";
+    std::cout << "Usage: " << prog << " [options]\n";
+    std::cout << "  --vehicles <n>   Fleet size (default: 10000)\n";
+    std::cout << "  --ticks <n>      Ticks to run (default: 1000)\n";
+    std::cout << "  --dropout <r>    Dropouts per second per vehicle (default: 0.002)\n";
+    std::cout << "  --help           Show this message\n";
+}
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--vehicles") == 0 && has_value) {
+            cfg.vehicles = static_cast<size_t>(std::max(1, std::stoi(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--ticks") == 0 && has_value) {
+            cfg.ticks = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--dropout") == 0 && has_value) {
+            cfg.dropout_rate = std::max(0.0, std::stod(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    GnssErrorConfig error_config = GnssErrorConfig::create_default();
+    error_config.dropout_rate = cfg.dropout_rate;
+    GnssErrorModel error(error_config);
+
+    KalmanConfig filter_config = KalmanConfig::create_default();
+    FleetKalmanFilter filter(filter_config);
+
+    const size_t n = cfg.vehicles;
+    error.resize(n);
+    filter.resize(n);
+
+    // Curvas de estrada de mina: raio 500-2500 m a 5-15 m/s, fases espalhadas
+    std::vector<double> cx(n), cy(n), radius(n), omega(n), phase(n);
+    for (size_t i = 0; i < n; i++) {
+        cx[i] = static_cast<double>(i % 100) * 1000.0;
+        cy[i] = static_cast<double>(i / 100) * 1000.0;
+        radius[i] = 500.0 + static_cast<double>(i % 5) * 500.0;
+        omega[i] = (5.0 + static_cast<double>(i % 11)) / radius[i];
+        phase[i] = static_cast<double>(i) * 0.618;
+    }
+
+    std::vector<int64_t> measure_us;
+    std::vector<int64_t> step_us;
+    measure_us.reserve(cfg.ticks);
+    step_us.reserve(cfg.ticks);
+
+    double raw_sq = 0.0;
+    double est_sq = 0.0;
+    double vel_sq = 0.0;
+    uint64_t raw_count = 0;
+    uint64_t est_count = 0;
+    uint64_t dropouts = 0;
+    const int warmup = 20;
+
+    for (int t = 0; t < cfg.ticks; t++) {
+        double time = t * cfg.delta_time;
+
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < n; i++) {
+            double a = phase[i] + omega[i] * time;
+            double x = cx[i] + radius[i] * std::cos(a);
+            double y = cy[i] + radius[i] * std::sin(a);
+
+            double ex = 0.0;
+            double ey = 0.0;
+            if (!error.sample(static_cast<uint32_t>(i), cfg.delta_time, ex, ey)) {
+                dropouts++;
+                continue;
+            }
+            filter.measure(static_cast<uint32_t>(i), x + ex, y + ey);
+
+            if (t >= warmup) {
+                raw_sq += ex * ex + ey * ey;
+                raw_count++;
+            }
+        }
+        auto t1 = Clock::now();
+        filter.step(cfg.delta_time);
+        auto t2 = Clock::now();
+
+        measure_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count());
+        step_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count());
+
+        if (t < warmup) continue;
+        for (size_t i = 0; i < n; i++) {
+            uint32_t slot = static_cast<uint32_t>(i);
+            if (!filter.initialized(slot)) continue;
+
+            double a = phase[i] + omega[i] * time;
+            double dx = filter.x(slot) - (cx[i] + radius[i] * std::cos(a));
+            double dy = filter.y(slot) - (cy[i] + radius[i] * std::sin(a));
+            double dvx = filter.vx(slot) + radius[i] * omega[i] * std::sin(a);
+            double dvy = filter.vy(slot) - radius[i] * omega[i] * std::cos(a);
+            est_sq += dx * dx + dy * dy;
+            vel_sq += dvx * dvx + dvy * dvy;
+            est_count++;
+        }
+    }
+
+    auto avg = [](const std::vector<int64_t>& v) {
+        int64_t total = 0;
+        for (int64_t x : v) total += x;
+        return v.empty() ? 0.0 : static_cast<double>(total) / v.size();
+    };
+
+    double step_avg = avg(step_us);
+    double measure_avg = avg(measure_us);
+
+    std::printf("[BENCH] %zu vehicles, %d ticks, filter state %zu KB\n",
+                n, cfg.ticks, (filter.heap_bytes() + error.heap_bytes()) / 1024);
+    std::printf("[BENCH] Error model + measure: avg %.1fus p99 %lldus (%.1f ns/vehicle)\n",
+                measure_avg, static_cast<long long>(percentile(measure_us, 99)),
+                measure_avg * 1000.0 / n);
+    std::printf("[BENCH] Kalman step:           avg %.1fus p99 %lldus (%.1f ns/vehicle)\n",
+                step_avg, static_cast<long long>(percentile(step_us, 99)),
+                step_avg * 1000.0 / n);
+    std::printf("[BENCH] Position RMS: raw fix %.2fm, filtered %.2fm; velocity RMS %.2fm/s; dropouts %llu\n",
+                raw_count ? std::sqrt(raw_sq / raw_count) : 0.0,
+                est_count ? std::sqrt(est_sq / est_count) : 0.0,
+                est_count ? std::sqrt(vel_sq / est_count) : 0.0,
+                static_cast<unsigned long long>(dropouts));
+    return 0;
+}
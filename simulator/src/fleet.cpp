@@ -1,5 +1,6 @@
 #include "fleet.hpp"
 #include <cmath>
+#include <chrono>
 #include <iostream>
 
 namespace mineguard {
@@ -46,111 +47,274 @@ MineLayout MineLayout::create_default() {
 // FleetManager
 // ============================================================
 
-FleetManager::FleetManager() {}
+FleetManager::FleetManager()
+    : loading_excavator_{VehicleHandle::INVALID_SLOT, 0}
+    , gnss_origin_{0.0, 0.0, 0.0}
+    , m_per_deg_lat_(EARTH_RADIUS * DEG_TO_RAD)
+    , m_per_deg_lon_(0.0)
+    , gnss_dropouts_(0)
+    , clock_(0.0)
+    , varied_(false)
+    , variation_(FleetVariation::create_default())
+    , variation_rng_(0)
+{
+}
+
+FleetVariation FleetVariation::create_default() {
+    return FleetVariation{
+        .seed = 1,
+        .speed_jitter = 0.15,
+        .dwell_jitter = 0.3,
+        .start_offset_max = 600.0
+    };
+}
+
+void FleetManager::set_variation(const FleetVariation& variation) {
+    varied_ = true;
+    variation_ = variation;
+    variation_rng_.seed(variation.seed);
+}
+
+void FleetManager::scatter_cycles() {
+    if (!varied_ || variation_.start_offset_max <= 0.0) return;
+
+    // Pre-rolagem fora do relogio: nao gera eventos de KPI
+    std::unique_ptr<ProductionKpi> kpi = std::move(kpi_);
+
+    std::uniform_real_distribution<double> offset(0.0, variation_.start_offset_max);
+    for (uint32_t index : active_slots_) {
+        int steps = static_cast<int>(offset(variation_rng_));
+        for (int s = 0; s < steps; s++) update_slot(index, 1.0);
+    }
+
+    kpi_ = std::move(kpi);
+}
 
 void FleetManager::initialize() {
     mine_ = MineLayout::create_default();
+    build_route_paths();
     create_fleet();
-    setup_routes();
 }
 
-// --- Criacao da frota ---
+// --- Frota inicial: cada veiculo numa posicao diferente do ciclo ---
 
 void FleetManager::create_fleet() {
-    // 3 Haul Trucks - comecam em posicoes diferentes do ciclo
-    vehicles_.push_back(std::make_unique<Vehicle>(
-        "HT-101", VehicleType::HAUL_TRUCK, mine_.waypoints["PIT_LOAD_1"]
-    ));
-    vehicles_.push_back(std::make_unique<Vehicle>(
-        "HT-102", VehicleType::HAUL_TRUCK, mine_.waypoints["ROAD_1"]
-    ));
-    vehicles_.push_back(std::make_unique<Vehicle>(
-        "HT-103", VehicleType::HAUL_TRUCK, mine_.waypoints["DUMP_APPROACH"]
-    ));
-
-    // 1 Excavator - fica fixo na area de carga
-    vehicles_.push_back(std::make_unique<Vehicle>(
-        "EX-201", VehicleType::EXCAVATOR, mine_.waypoints["PIT_LOAD_1"]
-    ));
-
-    // 1 Light Vehicle - patrulha de seguranca
-    vehicles_.push_back(std::make_unique<Vehicle>(
-        "LV-301", VehicleType::LIGHT_VEHICLE, mine_.waypoints["PATROL_1"]
-    ));
-}
-
-// --- Setup inicial de rotas e estado de navegacao ---
-
-void FleetManager::setup_routes() {
     // HT-101: comeca carregando no pit
-    nav_states_["HT-101"] = NavigationState{
-        .current_route = get_haul_route(),
+    spawn("HT-101", VehicleType::HAUL_TRUCK, mine_.waypoints["PIT_LOAD_1"], NavigationState{
+        .current_route = &haul_route_,
         .current_waypoint_index = 0,
         .arrival_threshold = 20.0,
         .wait_timer = LOADING_TIME,
-        .waiting = true
-    };
-    vehicles_[0]->set_cycle_state(CycleState::LOADING);
-    vehicles_[0]->set_target_speed(0);
+        .waiting = true,
+        .path = &haul_path_
+    }, CycleState::LOADING, 0);
 
     // HT-102: ja na estrada, hauling com carga
-    nav_states_["HT-102"] = NavigationState{
-        .current_route = get_haul_route(),
+    spawn("HT-102", VehicleType::HAUL_TRUCK, mine_.waypoints["ROAD_1"], NavigationState{
+        .current_route = &haul_route_,
         .current_waypoint_index = 4, // ROAD_1 em diante
         .arrival_threshold = 20.0,
         .wait_timer = 0,
-        .waiting = false
-    };
-    vehicles_[1]->set_cycle_state(CycleState::HAULING);
-    vehicles_[1]->set_target_speed(HAUL_SPEED);
+        .waiting = false,
+        .path = &haul_path_
+    }, CycleState::HAULING, HAUL_SPEED);
 
     // HT-103: chegando no dump
-    nav_states_["HT-103"] = NavigationState{
-        .current_route = get_haul_route(),
+    spawn("HT-103", VehicleType::HAUL_TRUCK, mine_.waypoints["DUMP_APPROACH"], NavigationState{
+        .current_route = &haul_route_,
         .current_waypoint_index = 6, // DUMP_APPROACH em diante
         .arrival_threshold = 20.0,
         .wait_timer = 0,
-        .waiting = false
-    };
-    vehicles_[2]->set_cycle_state(CycleState::HAULING);
-    vehicles_[2]->set_target_speed(APPROACH_SPEED);
+        .waiting = false,
+        .path = &haul_path_
+    }, CycleState::HAULING, HAUL_SPEED);
 
     // EX-201: escavadeira fica parada operando
-    nav_states_["EX-201"] = NavigationState{
-        .current_route = Route{{"PIT_LOAD_1"}},
-        .current_waypoint_index = 0,
-        .arrival_threshold = 5.0,
-        .wait_timer = 0,
-        .waiting = true
-    };
-    vehicles_[3]->set_cycle_state(CycleState::IDLE);
-    vehicles_[3]->set_target_speed(0);
+    spawn("EX-201", VehicleType::EXCAVATOR, mine_.waypoints["PIT_LOAD_1"],
+          initial_nav(VehicleType::EXCAVATOR), CycleState::IDLE, 0);
 
     // LV-301: patrulha circulando
-    nav_states_["LV-301"] = NavigationState{
-        .current_route = Route{{"PATROL_1", "PATROL_2", "PATROL_3", "PATROL_4"}},
+    spawn("LV-301", VehicleType::LIGHT_VEHICLE, mine_.waypoints["PATROL_1"], NavigationState{
+        .current_route = &patrol_route_,
+        .current_waypoint_index = 1,
+        .arrival_threshold = 15.0,
+        .wait_timer = 0,
+        .waiting = false,
+        .path = &patrol_path_
+    }, CycleState::HAULING, LV_PATROL_SPEED); // "em transito"
+}
+
+// ============================================================
+// Pool de slots: entrada/saida de veiculos
+//
+// slots_ so cresce; slots livres voltam pra free_slots_ e o Vehicle
+// do slot e reinicializado no lugar. active_ e a lista compacta que
+// os loops quentes percorrem (update, telemetria, colisao).
+// ============================================================
+
+NavigationState FleetManager::initial_nav(VehicleType type) const {
+    switch (type) {
+        case VehicleType::HAUL_TRUCK:
+            return NavigationState{
+                .current_route = &haul_route_,
+                .current_waypoint_index = 0,
+                .arrival_threshold = 20.0,
+                .wait_timer = LOADING_TIME,
+                .waiting = true,
+                .path = &haul_path_
+            };
+        case VehicleType::EXCAVATOR:
+            return NavigationState{
+                .current_route = &excavator_route_,
+                .current_waypoint_index = 0,
+                .arrival_threshold = 5.0,
+                .wait_timer = 0,
+                .waiting = true,
+                .path = nullptr
+            };
+        case VehicleType::LIGHT_VEHICLE:
+            break;
+    }
+    return NavigationState{
+        .current_route = &patrol_route_,
         .current_waypoint_index = 1,
         .arrival_threshold = 15.0,
         .wait_timer = 0,
-        .waiting = false
+        .waiting = false,
+        .path = &patrol_path_
     };
-    vehicles_[4]->set_cycle_state(CycleState::HAULING); // "em transito"
-    vehicles_[4]->set_target_speed(LV_PATROL_SPEED);
-
-    // Setar headings iniciais pra quem esta em movimento
-    for (auto& v : vehicles_) {
-        auto& nav = nav_states_[v->id()];
-        if (!nav.waiting && nav.current_waypoint_index < nav.current_route.waypoint_names.size()) {
-            const auto& target_name = nav.current_route.waypoint_names[nav.current_waypoint_index];
-            double heading = calculate_heading(v->position(), mine_.waypoints[target_name]);
-            v->set_heading(heading);
+}
+
+VehicleHandle FleetManager::spawn_vehicle(const std::string& id, VehicleType type) {
+    NavigationState nav = initial_nav(type);
+
+    switch (type) {
+        case VehicleType::HAUL_TRUCK:
+            return spawn(id, type, mine_.waypoints.at("PIT_LOAD_1"), nav, CycleState::LOADING, 0);
+        case VehicleType::EXCAVATOR:
+            return spawn(id, type, mine_.waypoints.at("PIT_LOAD_1"), nav, CycleState::IDLE, 0);
+        case VehicleType::LIGHT_VEHICLE:
+            break;
+    }
+    return spawn(id, type, mine_.waypoints.at("PATROL_1"), nav, CycleState::HAULING, LV_PATROL_SPEED);
+}
+
+VehicleHandle FleetManager::spawn(const std::string& id, VehicleType type, const Position& start,
+                                  const NavigationState& nav, CycleState state, double target_speed) {
+    if (find_vehicle(id).valid()) {
+        std::cerr << "[FLEET] Vehicle " << id << " already in fleet\n";
+        return VehicleHandle{VehicleHandle::INVALID_SLOT, 0};
+    }
+
+    uint32_t index;
+    if (!free_slots_.empty()) {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[index].vehicle->reset(id, type, start);
+    } else {
+        index = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(VehicleSlot{
+            .vehicle = std::make_unique<Vehicle>(id, type, start),
+            .nav = nav,
+            .generation = 0,
+            .active_index = INACTIVE
+        });
+    }
+
+    VehicleSlot& slot = slots_[index];
+    slot.nav = nav;
+    if (varied_) {
+        std::uniform_real_distribution<double> unit(-1.0, 1.0);
+        slot.nav.speed_factor = 1.0 + variation_.speed_jitter * unit(variation_rng_);
+        slot.nav.dwell_factor = 1.0 + variation_.dwell_jitter * unit(variation_rng_);
+        slot.nav.wait_timer *= slot.nav.dwell_factor;
+    }
+    slot.active_index = static_cast<uint32_t>(active_.size());
+    active_.push_back(slot.vehicle.get());
+    active_slots_.push_back(index);
+
+    Vehicle& v = *slot.vehicle;
+    VehicleHandle handle{index, slot.generation};
+    v.set_handle(handle);
+    v.set_cycle_state(state);
+    v.set_target_speed(target_speed * slot.nav.speed_factor);
+
+    // Heading inicial pra quem ja sai em movimento
+    if (!nav.waiting && nav.current_waypoint_index < nav.current_route->waypoint_names.size()) {
+        const auto& target_name = nav.current_route->waypoint_names[nav.current_waypoint_index];
+        v.set_heading(calculate_heading(v.position(), mine_.waypoints.at(target_name)));
+    }
+    v.set_route_path(nav.path, nav.current_waypoint_index);
+    v.set_loader(slot.nav.loader);
+
+    // Primeira escavadeira (ou a que chega depois da anterior sair)
+    // assume o ponto de carga
+    if (type == VehicleType::EXCAVATOR && !get(loading_excavator_)) {
+        loading_excavator_ = handle;
+    }
+
+    // Receptor novo: vies zerado, filtro reinicia no primeiro fix
+    if (gnss_error_) {
+        gnss_error_->reset_slot(index);
+        gnss_filter_->reset(index);
+    }
+    if (kpi_) kpi_->on_spawn(index, v, clock_);
+
+    return handle;
+}
+
+bool FleetManager::despawn_vehicle(VehicleHandle handle) {
+    if (!get(handle)) return false;
+
+    VehicleSlot& slot = slots_[handle.slot];
+
+    // Swap-remove: o ultimo vivo ocupa a posicao que ficou vaga
+    uint32_t pos = slot.active_index;
+    uint32_t last = static_cast<uint32_t>(active_.size() - 1);
+    if (pos != last) {
+        active_[pos] = active_[last];
+        active_slots_[pos] = active_slots_[last];
+        slots_[active_slots_[pos]].active_index = pos;
+    }
+    active_.pop_back();
+    active_slots_.pop_back();
+
+    if (kpi_) kpi_->on_despawn(handle.slot, clock_);
+
+    slot.active_index = INACTIVE;
+    slot.generation++;
+    slot.vehicle->set_handle(VehicleHandle{VehicleHandle::INVALID_SLOT, 0});
+    free_slots_.push_back(handle.slot);
+
+    // Escavadeira do ponto de carga saiu: outra que esteja na frota assume
+    if (handle == loading_excavator_) {
+        loading_excavator_ = VehicleHandle{VehicleHandle::INVALID_SLOT, 0};
+        for (const Vehicle* v : active_) {
+            if (v->type() == VehicleType::EXCAVATOR) {
+                loading_excavator_ = v->handle();
+                break;
+            }
         }
     }
+    return true;
+}
 
-    // Payload inicial pra quem ta carregado
-    // HT-102 e HT-103 ja estao em rota com carga
-    vehicles_[1]->set_target_speed(HAUL_SPEED); // reafirma
-    vehicles_[2]->set_target_speed(HAUL_SPEED);
+Vehicle* FleetManager::get(VehicleHandle handle) {
+    if (handle.slot >= slots_.size()) return nullptr;
+    VehicleSlot& slot = slots_[handle.slot];
+    if (slot.generation != handle.generation || slot.active_index == INACTIVE) return nullptr;
+    return slot.vehicle.get();
+}
+
+const Vehicle* FleetManager::get(VehicleHandle handle) const {
+    return const_cast<FleetManager*>(this)->get(handle);
+}
+
+VehicleHandle FleetManager::find_vehicle(const std::string& id) const {
+    for (const Vehicle* v : active_) {
+        if (v->id() == id) return v->handle();
+    }
+    return VehicleHandle{VehicleHandle::INVALID_SLOT, 0};
 }
 
 // --- Rotas ---
@@ -171,23 +335,80 @@ Route FleetManager::get_return_route() const {
     }};
 }
 
+Route FleetManager::get_patrol_route() const {
+    // Patrulha circular do veiculo leve
+    return Route{{"PATROL_1", "PATROL_2", "PATROL_3", "PATROL_4"}};
+}
+
+// --- Rotas e tabelas de arco (uma vez no startup) ---
+
+void FleetManager::build_route_paths() {
+    haul_route_ = get_haul_route();
+    return_route_ = get_return_route();
+    patrol_route_ = get_patrol_route();
+    excavator_route_ = Route{{"PIT_LOAD_1"}};
+
+    haul_path_ = build_path(haul_route_, false);
+    return_path_ = build_path(return_route_, false);
+    patrol_path_ = build_path(patrol_route_, true);
+
+    // Cruza todas as rotas pra montar as zonas de conflito
+    conflict_zones_.build({&haul_path_, &return_path_, &patrol_path_});
+}
+
+RoutePath FleetManager::build_path(const Route& route, bool closed) const {
+    std::vector<Position> points;
+    points.reserve(route.waypoint_names.size());
+    for (const auto& name : route.waypoint_names) {
+        points.push_back(mine_.waypoints.at(name));
+    }
+    return RoutePath::build(points, closed);
+}
+
+std::vector<RoadSection> FleetManager::road_sections() const {
+    std::vector<RoadSection> sections;
+
+    auto add = [&](const std::string& a, const std::string& b) {
+        for (const RoadSection& s : sections) {
+            if (s.name == a + "-" + b || s.name == b + "-" + a) return;
+        }
+        sections.push_back(RoadSection{a + "-" + b, mine_.waypoints.at(a), mine_.waypoints.at(b)});
+    };
+
+    for (const Route* route : {&haul_route_, &return_route_}) {
+        const auto& names = route->waypoint_names;
+        for (size_t i = 1; i < names.size(); i++) add(names[i - 1], names[i]);
+    }
+    const auto& patrol = patrol_route_.waypoint_names;
+    for (size_t i = 0; i < patrol.size(); i++) add(patrol[i], patrol[(i + 1) % patrol.size()]);
+
+    return sections;
+}
+
 // ============================================================
 // Update principal - chamado a cada tick
 // ============================================================
 
 void FleetManager::update(double delta_time) {
-    for (auto& vehicle : vehicles_) {
-        auto& nav = nav_states_[vehicle->id()];
+    advance_clock(delta_time);
+    for (uint32_t index : active_slots_) {
+        update_slot(index, delta_time);
+    }
+}
 
-        // Escavadeira fica parada
-        if (vehicle->type() == VehicleType::EXCAVATOR) {
-            vehicle->update(delta_time);
-            continue;
-        }
+void FleetManager::update_slot(uint32_t slot, double delta_time) {
+    auto& vehicle = slots_[slot].vehicle;
+    auto& nav = slots_[slot].nav;
 
-        update_navigation(*vehicle, nav, delta_time);
+    // Escavadeira fica parada
+    if (vehicle->type() == VehicleType::EXCAVATOR) {
         vehicle->update(delta_time);
+        return;
     }
+
+    update_navigation(*vehicle, nav, delta_time);
+    vehicle->set_route_path(nav.path, nav.current_waypoint_index);
+    vehicle->update(delta_time);
 }
 
 // --- Navegacao: mover veiculo entre waypoints ---
@@ -195,6 +416,11 @@ void FleetManager::update(double delta_time) {
 void FleetManager::update_navigation(Vehicle& vehicle, NavigationState& nav, double dt) {
     // Se ta esperando (loading/dumping), conta o timer
     if (nav.waiting) {
+        // Carregando sem escavadeira viva (spawn antes dela, ou ela saiu)
+        if (vehicle.cycle_state() == CycleState::LOADING && nav.loader != loading_excavator_) {
+            assign_loader(vehicle, nav, loading_excavator_);
+        }
+
         nav.wait_timer -= dt;
         if (nav.wait_timer <= 0) {
             nav.waiting = false;
@@ -204,11 +430,11 @@ void FleetManager::update_navigation(Vehicle& vehicle, NavigationState& nav, dou
     }
 
     // Verifica se nao ha rota
-    if (nav.current_route.waypoint_names.empty()) return;
-    if (nav.current_waypoint_index >= nav.current_route.waypoint_names.size()) return;
+    if (nav.current_route->waypoint_names.empty()) return;
+    if (nav.current_waypoint_index >= nav.current_route->waypoint_names.size()) return;
 
     // Pega waypoint alvo
-    const auto& target_name = nav.current_route.waypoint_names[nav.current_waypoint_index];
+    const auto& target_name = nav.current_route->waypoint_names[nav.current_waypoint_index];
     const auto& target_pos = mine_.waypoints.at(target_name);
 
     // Calcula distancia ate o waypoint
@@ -223,20 +449,20 @@ void FleetManager::update_navigation(Vehicle& vehicle, NavigationState& nav, dou
         nav.current_waypoint_index++;
 
         // Chegou no final da rota?
-        if (nav.current_waypoint_index >= nav.current_route.waypoint_names.size()) {
+        if (nav.current_waypoint_index >= nav.current_route->waypoint_names.size()) {
             handle_route_complete(vehicle, nav);
             return;
         }
 
         // Reduz velocidade perto do proximo waypoint se for curva
-        const auto& next_name = nav.current_route.waypoint_names[nav.current_waypoint_index];
+        const auto& next_name = nav.current_route->waypoint_names[nav.current_waypoint_index];
         const auto& next_pos = mine_.waypoints.at(next_name);
         double new_heading = calculate_heading(vehicle.position(), next_pos);
         double heading_diff = std::abs(new_heading - vehicle.telemetry().heading);
         if (heading_diff > 180) heading_diff = 360 - heading_diff;
 
         if (heading_diff > 30) {
-            vehicle.set_target_speed(APPROACH_SPEED);
+            vehicle.set_target_speed(APPROACH_SPEED * nav.speed_factor);
         }
     }
 }
@@ -249,23 +475,30 @@ void FleetManager::advance_cycle(Vehicle& vehicle, NavigationState& nav) {
     switch (current) {
         case CycleState::LOADING:
             // Terminou de carregar -> vai pro dump
+            assign_loader(vehicle, nav, VehicleHandle{VehicleHandle::INVALID_SLOT, 0});
             vehicle.set_cycle_state(CycleState::HAULING);
-            nav.current_route = get_haul_route();
+            nav.current_route = &haul_route_;
             nav.current_waypoint_index = 1; // pula PIT_LOAD, ja ta la
-            vehicle.set_target_speed(HAUL_SPEED);
+            nav.path = &haul_path_;
+            vehicle.set_target_speed(HAUL_SPEED * nav.speed_factor);
             break;
 
         case CycleState::DUMPING:
             // Terminou de descarregar -> volta pro pit
             vehicle.set_cycle_state(CycleState::RETURNING);
-            nav.current_route = get_return_route();
+            nav.current_route = &return_route_;
             nav.current_waypoint_index = 1; // pula DUMP_1, ja ta la
-            vehicle.set_target_speed(RETURN_SPEED);
+            nav.path = &return_path_;
+            vehicle.set_target_speed(RETURN_SPEED * nav.speed_factor);
             break;
 
         default:
             break;
     }
+
+    if (kpi_ && vehicle.cycle_state() != current) {
+        kpi_->record_transition(vehicle.handle().slot, vehicle, current, vehicle.cycle_state(), clock_);
+    }
 }
 
 // --- Funcao privada: quando veiculo chega no fim da rota ---
@@ -275,39 +508,228 @@ void FleetManager::handle_route_complete(Vehicle& vehicle, NavigationState& nav)
 
     if (vehicle.type() == VehicleType::LIGHT_VEHICLE) {
         // Veiculo leve: reinicia patrulha circular
-        nav.current_route = Route{{"PATROL_1", "PATROL_2", "PATROL_3", "PATROL_4"}};
+        nav.current_route = &patrol_route_;
         nav.current_waypoint_index = 0;
-        vehicle.set_target_speed(LV_PATROL_SPEED);
+        nav.path = &patrol_path_;
+        vehicle.set_target_speed(LV_PATROL_SPEED * nav.speed_factor);
         return;
     }
 
     CycleState current = vehicle.cycle_state();
+    if (kpi_) kpi_->record_arrival(vehicle.handle().slot, clock_);
 
     if (current == CycleState::HAULING) {
         // Chegou no dump -> comeca a descarregar
         vehicle.set_cycle_state(CycleState::DUMPING);
         nav.waiting = true;
-        nav.wait_timer = DUMPING_TIME;
+        nav.wait_timer = DUMPING_TIME * nav.dwell_factor;
     }
     else if (current == CycleState::RETURNING) {
         // Voltou pro pit -> comeca a carregar
         vehicle.set_cycle_state(CycleState::LOADING);
+        assign_loader(vehicle, nav, loading_excavator_);
         nav.waiting = true;
-        nav.wait_timer = LOADING_TIME;
+        nav.wait_timer = LOADING_TIME * nav.dwell_factor;
     }
+
+    if (kpi_ && vehicle.cycle_state() != current) {
+        kpi_->record_transition(vehicle.handle().slot, vehicle, current, vehicle.cycle_state(), clock_);
+    }
+}
+
+void FleetManager::assign_loader(Vehicle& vehicle, NavigationState& nav, VehicleHandle loader) {
+    nav.loader = loader;
+    vehicle.set_loader(loader);
 }
 
 // --- Coleta de telemetria de todos os veiculos ---
 
 std::vector<TelemetryPacket> FleetManager::collect_telemetry() const {
+    using namespace std::chrono;
+    int64_t ts = duration_cast<milliseconds>(
+        system_clock::now().time_since_epoch()
+    ).count();
+
     std::vector<TelemetryPacket> packets;
-    packets.reserve(vehicles_.size());
-    for (const auto& v : vehicles_) {
-        packets.push_back(v->generate_packet());
-    }
+    collect_telemetry(packets, ts);
     return packets;
 }
 
+// ============================================================
+// Instrumentacao de memoria
+// ============================================================
+
+MemoryFootprint FleetManager::footprint() const {
+    MemoryFootprint fp{
+        .vehicles = active_.size(),
+        .per_vehicle_bytes = 0,
+        .pair_entries = 0,
+        .pair_bytes = 0,
+        .shared_bytes = 0
+    };
+
+    // Slots livres entram na conta: a memoria fica reservada pro proximo spawn
+    for (const auto& slot : slots_) {
+        fp.per_vehicle_bytes += sizeof(Vehicle) + slot.vehicle->heap_bytes();
+    }
+    fp.per_vehicle_bytes += footprint::heap_bytes(slots_) + footprint::heap_bytes(free_slots_);
+    fp.per_vehicle_bytes += footprint::heap_bytes(active_) + footprint::heap_bytes(active_slots_);
+    if (gnss_error_) {
+        fp.per_vehicle_bytes += gnss_error_->heap_bytes() + gnss_filter_->heap_bytes();
+    }
+
+    fp.shared_bytes += footprint::heap_bytes(mine_.waypoints);
+    for (const auto& entry : mine_.waypoints) {
+        fp.shared_bytes += footprint::heap_bytes(entry.first);
+    }
+    for (const Route* route : {&haul_route_, &return_route_, &patrol_route_, &excavator_route_}) {
+        fp.shared_bytes += footprint::heap_bytes(route->waypoint_names);
+        for (const auto& name : route->waypoint_names) {
+            fp.shared_bytes += footprint::heap_bytes(name);
+        }
+    }
+    fp.shared_bytes += haul_path_.heap_bytes() + return_path_.heap_bytes() + patrol_path_.heap_bytes();
+    fp.shared_bytes += conflict_zones_.heap_bytes();
+
+    return fp;
+}
+
+void FleetManager::collect_telemetry(std::vector<TelemetryPacket>& out, int64_t timestamp) const {
+    if (gnss_error_) {
+        collect_telemetry(out, timestamp, 0, 1);
+        return;
+    }
+
+    // resize mantem os pacotes existentes (e os buffers dos IDs)
+    out.resize(active_.size());
+    for (size_t i = 0; i < active_.size(); i++) {
+        active_[i]->fill_packet(out[i], timestamp);
+    }
+}
+
+void FleetManager::collect_telemetry(std::vector<TelemetryPacket>& out, int64_t timestamp,
+                                     uint64_t tick, uint32_t stationary_interval) const {
+    if (stationary_interval <= 1 && !gnss_error_) {
+        collect_telemetry(out, timestamp);
+        return;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < active_.size(); i++) {
+        const Vehicle& v = *active_[i];
+
+        // Dropout do GNSS: sem posicao, sem pacote
+        if (!v.has_gnss_fix()) continue;
+
+        if (stationary_interval > 1 && v.telemetry().speed < STATIONARY_SPEED &&
+            (tick + active_slots_[i]) % stationary_interval != 0) {
+            continue;
+        }
+
+        if (count == out.size()) out.emplace_back();
+        v.fill_packet(out[count++], timestamp);
+    }
+    out.resize(count);
+}
+
+// ============================================================
+// Pipeline de GNSS
+//
+// Fix = posicao simulada + erro do receptor, no plano local da mina.
+// O filtro roda em lote sobre todos os slots; a estimativa volta pros
+// veiculos em lat/lon, velocidade (km/h) e heading. Parado, o heading
+// da velocidade estimada e so ruido: fica o ultimo.
+// ============================================================
+
+void FleetManager::enable_gnss(const GnssErrorConfig& error, const KalmanConfig& filter) {
+    double min_lat = 0.0;
+    double min_lon = 0.0;
+    double max_lat = 0.0;
+    bool first = true;
+    for (const auto& entry : mine_.waypoints) {
+        const Position& p = entry.second;
+        if (first || p.latitude < min_lat) min_lat = p.latitude;
+        if (first || p.longitude < min_lon) min_lon = p.longitude;
+        if (first || p.latitude > max_lat) max_lat = p.latitude;
+        first = false;
+    }
+
+    gnss_origin_ = Position{min_lat, min_lon, 0.0};
+    m_per_deg_lon_ = m_per_deg_lat_ * std::cos(0.5 * (min_lat + max_lat) * DEG_TO_RAD);
+
+    gnss_error_ = std::make_unique<GnssErrorModel>(error);
+    gnss_filter_ = std::make_unique<FleetKalmanFilter>(filter);
+    for (uint32_t slot : active_slots_) {
+        gnss_error_->reset_slot(slot);
+        gnss_filter_->reset(slot);
+    }
+}
+
+void FleetManager::sense(double delta_time) {
+    if (!gnss_error_) return;
+
+    gnss_error_->resize(slots_.size());
+    gnss_filter_->resize(slots_.size());
+    gnss_dropouts_ = 0;
+
+    for (size_t i = 0; i < active_.size(); i++) {
+        Vehicle& v = *active_[i];
+        uint32_t slot = active_slots_[i];
+        const Position& p = v.position();
+
+        double ex = 0.0;
+        double ey = 0.0;
+        if (!gnss_error_->sample(slot, delta_time, ex, ey)) {
+            v.set_gnss_fix(p, false);
+            gnss_dropouts_++;
+            continue;
+        }
+
+        double x = (p.longitude - gnss_origin_.longitude) * m_per_deg_lon_ + ex;
+        double y = (p.latitude - gnss_origin_.latitude) * m_per_deg_lat_ + ey;
+        gnss_filter_->measure(slot, x, y);
+        v.set_gnss_fix(Position{
+            gnss_origin_.latitude + y / m_per_deg_lat_,
+            gnss_origin_.longitude + x / m_per_deg_lon_,
+            p.altitude
+        }, true);
+    }
+
+    gnss_filter_->step(delta_time);
+
+    for (size_t i = 0; i < active_.size(); i++) {
+        Vehicle& v = *active_[i];
+        uint32_t slot = active_slots_[i];
+        if (!gnss_filter_->initialized(slot)) continue;
+
+        double vx = gnss_filter_->vx(slot);
+        double vy = gnss_filter_->vy(slot);
+        double speed = std::sqrt(vx * vx + vy * vy) * 3.6;
+        double heading = v.sensed_telemetry().heading;
+        if (speed >= STATIONARY_SPEED) {
+            heading = std::atan2(vx, vy) * (180.0 / M_PI);
+            if (heading < 0.0) heading += 360.0;
+        }
+
+        v.set_estimate(Position{
+            gnss_origin_.latitude + gnss_filter_->y(slot) / m_per_deg_lat_,
+            gnss_origin_.longitude + gnss_filter_->x(slot) / m_per_deg_lon_,
+            v.position().altitude
+        }, speed, heading, gnss_filter_->position_sigma(slot));
+    }
+}
+
+// ============================================================
+// KPIs de producao
+// ============================================================
+
+void FleetManager::enable_kpi(const KpiConfig& config) {
+    kpi_ = std::make_unique<ProductionKpi>(config, clock_);
+    for (uint32_t slot : active_slots_) {
+        kpi_->on_spawn(slot, *slots_[slot].vehicle, clock_);
+    }
+}
+
 // ============================================================
 // Funcoes de geometria
 // ============================================================
@@ -0,0 +1,82 @@
+#include "gnss_error.hpp"
+#include "memory_footprint.hpp"
+#include <cmath>
+
+namespace mineguard {
+
+// ============================================================
+// Configuracao padrao: receptor de navegacao sem correcao RTK
+// ============================================================
+
+GnssErrorConfig GnssErrorConfig::create_default() {
+    return GnssErrorConfig{
+        .white_sigma = 1.0,
+        .bias_walk_sigma = 0.05,
+        .bias_limit = 2.0,
+        .dropout_rate = 0.002,     // ~1 por veiculo a cada 8 min
+        .dropout_mean = 4.0,
+        .seed = 1
+    };
+}
+
+// ============================================================
+// Erro por slot
+// ============================================================
+
+GnssErrorModel::GnssErrorModel(const GnssErrorConfig& config)
+    : config_(config)
+    , rng_(config.seed)
+    , normal_(0.0, 1.0)
+    , uniform_(0.0, 1.0)
+{
+}
+
+void GnssErrorModel::resize(size_t slots) {
+    if (slots <= bias_x_.size()) return;
+    bias_x_.resize(slots, 0.0);
+    bias_y_.resize(slots, 0.0);
+    dropout_left_.resize(slots, 0.0);
+}
+
+void GnssErrorModel::reset_slot(uint32_t slot) {
+    resize(static_cast<size_t>(slot) + 1);
+    bias_x_[slot] = 0.0;
+    bias_y_[slot] = 0.0;
+    dropout_left_[slot] = 0.0;
+}
+
+double GnssErrorModel::reflect(double bias) const {
+    double limit = config_.bias_limit;
+    if (bias > limit) return 2.0 * limit - bias;
+    if (bias < -limit) return -2.0 * limit - bias;
+    return bias;
+}
+
+bool GnssErrorModel::sample(uint32_t slot, double delta_time, double& ex, double& ey) {
+    // Vies anda mesmo sem fix: o receptor volta com o erro atual
+    double walk = config_.bias_walk_sigma * std::sqrt(delta_time);
+    bias_x_[slot] = reflect(bias_x_[slot] + walk * normal_(rng_));
+    bias_y_[slot] = reflect(bias_y_[slot] + walk * normal_(rng_));
+
+    if (dropout_left_[slot] > 0.0) {
+        dropout_left_[slot] -= delta_time;
+        return false;
+    }
+
+    if (uniform_(rng_) < config_.dropout_rate * delta_time) {
+        // Duracao exponencial; este tick ja conta
+        dropout_left_[slot] = -config_.dropout_mean * std::log(1.0 - uniform_(rng_)) - delta_time;
+        return false;
+    }
+
+    ex = bias_x_[slot] + config_.white_sigma * normal_(rng_);
+    ey = bias_y_[slot] + config_.white_sigma * normal_(rng_);
+    return true;
+}
+
+size_t GnssErrorModel::heap_bytes() const {
+    return footprint::heap_bytes(bias_x_) + footprint::heap_bytes(bias_y_) +
+           footprint::heap_bytes(dropout_left_);
+}
+
+} // namespace mineguard
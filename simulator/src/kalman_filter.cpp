@@ -0,0 +1,152 @@
+#include "kalman_filter.hpp"
+#include "memory_footprint.hpp"
+#include <cmath>
+
+namespace mineguard {
+
+// ============================================================
+// Configuracao padrao: caminhao/veiculo leve em estrada de mina
+// ============================================================
+
+KalmanConfig KalmanConfig::create_default() {
+    return KalmanConfig{
+        .accel_sigma = 1.0,
+        .measurement_sigma = 1.5,
+        .initial_velocity_sigma = 10.0
+    };
+}
+
+FleetKalmanFilter::FleetKalmanFilter(const KalmanConfig& config)
+    : config_(config)
+{
+}
+
+void FleetKalmanFilter::resize(size_t slots) {
+    if (slots <= x_.size()) return;
+    x_.resize(slots, 0.0);
+    y_.resize(slots, 0.0);
+    vx_.resize(slots, 0.0);
+    vy_.resize(slots, 0.0);
+    p_pp_.resize(slots, 0.0);
+    p_pv_.resize(slots, 0.0);
+    p_vv_.resize(slots, 0.0);
+    mx_.resize(slots, 0.0);
+    my_.resize(slots, 0.0);
+    fix_.resize(slots, 0.0);
+    init_.resize(slots, 0.0);
+}
+
+void FleetKalmanFilter::reset(uint32_t slot) {
+    resize(static_cast<size_t>(slot) + 1);
+    x_[slot] = y_[slot] = 0.0;
+    vx_[slot] = vy_[slot] = 0.0;
+    p_pp_[slot] = p_pv_[slot] = p_vv_[slot] = 0.0;
+    fix_[slot] = 0.0;
+    init_[slot] = 0.0;
+}
+
+void FleetKalmanFilter::measure(uint32_t slot, double x, double y) {
+    mx_[slot] = x;
+    my_[slot] = y;
+    fix_[slot] = 1.0;
+}
+
+double FleetKalmanFilter::position_sigma(uint32_t slot) const {
+    return std::sqrt(p_pp_[slot]);
+}
+
+// ============================================================
+// Predicao + atualizacao em lote
+//
+// Por eixo, com aceleracao branca constante no intervalo:
+//   F = [1 dt; 0 1], Q = a^2 [dt^4/4 dt^3/2; dt^3/2 dt^2], H = [1 0]
+// Slot sem fix: ganho zero (so predicao). Primeiro fix depois do
+// reset: o estado vai pra medida com velocidade zero e covariancia
+// inicial. Os dois casos sao pesos 0/1, sem desvio no laco.
+// ============================================================
+
+// Ruidos do passo, iguais pra todos os slots
+struct StepNoise {
+    double dt, dt2;
+    double q_pp, q_pv, q_vv;
+    double r, v0;
+};
+
+// Os vetores do estado nao se sobrepoem; sem o __restrict o compilador
+// nao prova isso e deixa o laco escalar.
+static void step_kernel(size_t n, const StepNoise& k,
+                        double* __restrict x, double* __restrict y,
+                        double* __restrict vx, double* __restrict vy,
+                        double* __restrict p_pp, double* __restrict p_pv,
+                        double* __restrict p_vv,
+                        const double* __restrict mx, const double* __restrict my,
+                        double* __restrict fix, double* __restrict init) {
+    const double dt = k.dt;
+    const double dt2 = k.dt2;
+
+    for (size_t i = 0; i < n; i++) {
+        // Predicao
+        double px = x[i] + vx[i] * dt;
+        double py = y[i] + vy[i] * dt;
+        double pp = p_pp[i] + 2.0 * dt * p_pv[i] + dt2 * p_vv[i] + k.q_pp;
+        double pv = p_pv[i] + dt * p_vv[i] + k.q_pv;
+        double vv = p_vv[i] + k.q_vv;
+
+        // Atualizacao (f = 0: sem fix ou filtro ainda nao iniciado)
+        double f = fix[i] * init[i];
+        double s = pp + k.r;
+        double kp = f * pp / s;
+        double kv = f * pv / s;
+        double ix = mx[i] - px;
+        double iy = my[i] - py;
+
+        double nx = px + kp * ix;
+        double ny = py + kp * iy;
+        double nvx = vx[i] + kv * ix;
+        double nvy = vy[i] + kv * iy;
+        double npp = (1.0 - kp) * pp;
+        double npv = (1.0 - kp) * pv;
+        double nvv = vv - kv * pv;
+
+        // Primeiro fix: reinicia na medida
+        double a = fix[i] * (1.0 - init[i]);
+        x[i] = nx + a * (mx[i] - nx);
+        y[i] = ny + a * (my[i] - ny);
+        vx[i] = nvx * (1.0 - a);
+        vy[i] = nvy * (1.0 - a);
+        p_pp[i] = npp + a * (k.r - npp);
+        p_pv[i] = npv * (1.0 - a);
+        p_vv[i] = nvv + a * (k.v0 - nvv);
+
+        init[i] += a;
+        fix[i] = 0.0;
+    }
+}
+
+void FleetKalmanFilter::step(double delta_time) {
+    const double dt = delta_time;
+    const double q = config_.accel_sigma * config_.accel_sigma;
+    const double dt2 = dt * dt;
+    const StepNoise noise{
+        .dt = dt,
+        .dt2 = dt2,
+        .q_pp = q * dt2 * dt2 * 0.25,
+        .q_pv = q * dt2 * dt * 0.5,
+        .q_vv = q * dt2,
+        .r = config_.measurement_sigma * config_.measurement_sigma,
+        .v0 = config_.initial_velocity_sigma * config_.initial_velocity_sigma
+    };
+
+    step_kernel(x_.size(), noise, x_.data(), y_.data(), vx_.data(), vy_.data(),
+                p_pp_.data(), p_pv_.data(), p_vv_.data(),
+                mx_.data(), my_.data(), fix_.data(), init_.data());
+}
+
+size_t FleetKalmanFilter::heap_bytes() const {
+    using footprint::heap_bytes;
+    return heap_bytes(x_) + heap_bytes(y_) + heap_bytes(vx_) + heap_bytes(vy_) +
+           heap_bytes(p_pp_) + heap_bytes(p_pv_) + heap_bytes(p_vv_) +
+           heap_bytes(mx_) + heap_bytes(my_) + heap_bytes(fix_) + heap_bytes(init_);
+}
+
+} // namespace mineguard
@@ -0,0 +1,539 @@
+#include "tcp_client.hpp"
+#include "json_serializer.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <unistd.h>
+
+using namespace mineguard;
+
+// ============================================================
+// Gerador de carga pro backend
+//
+// Abre N conexoes concorrentes (uma thread por conexao), cada uma
+// com handshake proprio e ack por batch. Mede frames aceitos/s,
+// latencia de ack e falhas; no modo --ramp dobra as conexoes a
+// cada passo ate o backend saturar. Antes e depois de cada passo le
+// os contadores de GC do backend (/api/status) e reporta quanto ele
+// alocou por frame e por pacote aceito.
+// ============================================================
+
+static volatile bool running = true;
+
+void signal_handler(int) {
+    running = false;
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig {
+    std::string host = "localhost";
+    uint16_t port = 5000;
+    uint16_t http_port = 5100;     // API HTTP do backend (contadores de GC)
+    int connections = 1;
+    int vehicles = 5;              // por conexao
+    int alerts = 0;                // alertas sinteticos por batch
+    double rate = 1.0;             // batches/s por conexao
+    double duration = 10.0;        // segundos (por passo no --ramp)
+    bool ramp = false;
+    int max_connections = 256;
+    double max_latency_ms = 250.0; // p99 acima disso = saturado
+    std::vector<std::string> replay;
+};
+
+// Resultado de uma conexao (sem compartilhamento entre threads)
+struct WorkerStats {
+    uint64_t frames_sent = 0;
+    uint64_t acks = 0;
+    uint64_t rejected = 0;         // ack com ok=false (parse falhou no backend)
+    uint64_t connect_failures = 0;
+    uint64_t send_failures = 0;
+    uint64_t disconnects = 0;
+    uint64_t lost_acks = 0;        // frames sem ack quando o passo terminou
+    bool no_ack_support = false;
+    std::vector<double> latencies_ms;
+};
+
+struct StepResult {
+    int connections;
+    double offered_fps;
+    double sent_fps;
+    double accepted_fps;
+    double p50_ms;
+    double p99_ms;
+    double max_ms;
+    uint64_t failures;
+    uint64_t rejected;
+    uint64_t accepted;             // frames com ack ok
+    uint64_t packets;              // pacotes de telemetria aceitos (so sintetico)
+
+    // Diferenca dos contadores de GC do backend no passo
+    bool gc_ok;
+    double gc_allocated_bytes;
+    double gc_gen0;
+    double gc_gen1;
+    double gc_gen2;
+    double gc_pause_ms;
+};
+
+// Contadores de GC do backend (campo "gc" de /api/status)
+struct BackendGc {
+    double allocated_bytes = 0.0;
+    double gen0 = 0.0;
+    double gen1 = 0.0;
+    double gen2 = 0.0;
+    double pause_ms = 0.0;
+};
+
+static constexpr double BASE_LATITUDE = -20.1190;
+static constexpr double BASE_LONGITUDE = -43.9490;
+static constexpr double SATURATION_RATIO = 0.95;  // aceitos/ofertados abaixo disso = saturado
+static constexpr int DRAIN_TIMEOUT_MS = 2000;
+
+static int64_t epoch_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+// ============================================================
+// Batch sintetico: veiculos andando em circulo em volta da mina
+// ============================================================
+
+static std::string build_synthetic_batch(const LoadConfig& cfg, int conn, uint64_t tick) {
+    std::vector<TelemetryPacket> packets;
+    packets.reserve(cfg.vehicles);
+
+    int64_t now = epoch_ms();
+    for (int v = 0; v < cfg.vehicles; v++) {
+        double phase = (tick * 0.01) + v * (2.0 * M_PI / cfg.vehicles);
+
+        TelemetryPacket p{};
+        p.vehicle_id = "LG" + std::to_string(conn) + "-" + std::to_string(v);
+        p.timestamp = now;
+        p.position = {BASE_LATITUDE + 0.002 * std::sin(phase), BASE_LONGITUDE + 0.002 * std::cos(phase), 900.0};
+        p.telemetry = {20.0, std::fmod(phase * 180.0 / M_PI, 360.0), 0.0, 80.0, 1200.0};
+        p.vehicle_type = v % 3;
+        p.cycle_state = 2;
+        packets.push_back(p);
+    }
+
+    std::vector<CollisionAlert> alerts;
+    for (int a = 0; a < cfg.alerts && cfg.vehicles > 1; a++) {
+        alerts.push_back(CollisionAlert{
+            .vehicle_id_1 = packets[a % cfg.vehicles].vehicle_id,
+            .vehicle_id_2 = packets[(a + 1) % cfg.vehicles].vehicle_id,
+            .priority = AlertPriority::LOW,
+            .type = AlertType::APPROACH,
+            .time_to_impact = 12.0,
+            .distance = 80.0,
+            .probability = 1.0,
+            .cpa = packets[a % cfg.vehicles].position,
+            .timestamp = now,
+            .slot_1 = static_cast<uint32_t>(a % cfg.vehicles),
+            .slot_2 = static_cast<uint32_t>((a + 1) % cfg.vehicles)
+        });
+    }
+
+    return JsonSerializer::serialize_batch(packets, alerts, tick, now);
+}
+
+// ============================================================
+// Uma conexao: envia no ritmo configurado e casa os acks em
+// ordem (o backend processa e responde os frames em sequencia)
+// ============================================================
+
+static void run_connection(const LoadConfig& cfg, int conn, Clock::time_point stop_at, WorkerStats& stats) {
+    TcpClient client(cfg.host, cfg.port, "loadgen-" + std::to_string(conn));
+    client.set_ack_enabled(true);
+
+    if (!client.connect_to_server()) {
+        stats.connect_failures++;
+        return;
+    }
+    if (client.session_id() == 0) {
+        stats.no_ack_support = true;
+    }
+
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / cfg.rate));
+
+    std::deque<Clock::time_point> in_flight;
+    std::string reply;
+    uint64_t tick = 0;
+    auto next_send = Clock::now();
+
+    auto handle_ack = [&](const std::string& ack) {
+        if (in_flight.empty()) return;
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - in_flight.front()).count();
+        in_flight.pop_front();
+
+        if (ack.find("\"ok\":false") != std::string::npos) {
+            stats.rejected++;
+        } else {
+            stats.acks++;
+            stats.latencies_ms.push_back(ms);
+        }
+    };
+
+    while (running && Clock::now() < stop_at) {
+        auto now = Clock::now();
+
+        if (now >= next_send) {
+            std::string json = cfg.replay.empty()
+                ? build_synthetic_batch(cfg, conn, tick)
+                : cfg.replay[tick % cfg.replay.size()];
+
+            if (!client.send_message(json)) {
+                stats.send_failures++;
+                break;
+            }
+            in_flight.push_back(Clock::now());
+            stats.frames_sent++;
+            tick++;
+
+            // Atrasado demais: nao tenta compensar com rajada
+            next_send += interval;
+            if (next_send < now - std::chrono::seconds(1)) next_send = now;
+        }
+
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_send - Clock::now()).count();
+        if (client.receive_message(reply, static_cast<int>(std::max<int64_t>(wait, 0)))) {
+            handle_ack(reply);
+            // Esvazia acks que ja chegaram antes do proximo envio
+            while (client.receive_message(reply, 0)) handle_ack(reply);
+        } else if (!client.is_connected()) {
+            stats.disconnects++;
+            break;
+        }
+    }
+
+    // Drena acks pendentes antes de fechar
+    auto drain_until = Clock::now() + std::chrono::milliseconds(DRAIN_TIMEOUT_MS);
+    while (!in_flight.empty() && client.is_connected() && Clock::now() < drain_until) {
+        if (client.receive_message(reply, DRAIN_TIMEOUT_MS)) handle_ack(reply);
+    }
+    stats.lost_acks = in_flight.size();
+}
+
+// ============================================================
+// Contadores de GC do backend: GET /api/status (HTTP/1.0, resposta
+// inteira ate o servidor fechar) e leitura dos numeros do campo gc
+// ============================================================
+
+static bool http_get(const std::string& host, uint16_t port, const std::string& path, std::string& body) {
+    struct hostent* server = gethostbyname(host.c_str());
+    if (!server) return false;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    struct timeval timeout{2, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    std::memcpy(&addr.sin_addr.s_addr, server->h_addr, server->h_length);
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return false;
+    }
+
+    std::string request = "GET " + path + " HTTP/1.0\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        close(fd);
+        return false;
+    }
+
+    std::string response;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+        response.append(chunk, static_cast<size_t>(n));
+    }
+    close(fd);
+
+    size_t header_end = response.find("\r\n\r\n");
+    size_t status_end = response.find("\r\n");
+    if (header_end == std::string::npos || response.find(" 200 ") > status_end) return false;
+    body = response.substr(header_end + 4);
+    return true;
+}
+
+// Numero logo depois de "key": a partir de from (sem parser JSON completo)
+static bool json_number(const std::string& json, size_t from, const char* key, double& out) {
+    std::string pattern = std::string("\"") + key + "\":";
+    size_t pos = json.find(pattern, from);
+    if (pos == std::string::npos) return false;
+
+    const char* start = json.c_str() + pos + pattern.size();
+    char* end = nullptr;
+    out = std::strtod(start, &end);
+    return end != start;
+}
+
+static bool fetch_backend_gc(const LoadConfig& cfg, BackendGc& gc) {
+    std::string body;
+    if (!http_get(cfg.host, cfg.http_port, "/api/status", body)) return false;
+
+    size_t at = body.find("\"gc\":{");
+    if (at == std::string::npos) return false;
+
+    return json_number(body, at, "allocatedBytes", gc.allocated_bytes)
+        && json_number(body, at, "gen0Collections", gc.gen0)
+        && json_number(body, at, "gen1Collections", gc.gen1)
+        && json_number(body, at, "gen2Collections", gc.gen2)
+        && json_number(body, at, "pauseMs", gc.pause_ms);
+}
+
+// ============================================================
+// Um passo de carga: N conexoes durante cfg.duration segundos
+// ============================================================
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+    return sorted[idx];
+}
+
+static StepResult run_step(const LoadConfig& cfg, int connections) {
+    std::vector<WorkerStats> stats(connections);
+    std::vector<std::thread> threads;
+    threads.reserve(connections);
+
+    BackendGc gc_before, gc_after;
+    bool gc_ok = fetch_backend_gc(cfg, gc_before);
+
+    auto start = Clock::now();
+    auto stop_at = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(cfg.duration));
+
+    for (int c = 0; c < connections; c++) {
+        threads.emplace_back(run_connection, std::cref(cfg), c, stop_at, std::ref(stats[c]));
+    }
+    for (auto& t : threads) t.join();
+
+    gc_ok = gc_ok && fetch_backend_gc(cfg, gc_after);
+
+    double elapsed = std::chrono::duration<double>(std::min(Clock::now(), stop_at) - start).count();
+    if (elapsed <= 0.0) elapsed = cfg.duration;
+
+    StepResult r{};
+    r.connections = connections;
+    r.offered_fps = connections * cfg.rate;
+
+    std::vector<double> latencies;
+    uint64_t sent = 0, acks = 0;
+    bool no_ack = false;
+    for (const auto& s : stats) {
+        sent += s.frames_sent;
+        acks += s.acks;
+        r.rejected += s.rejected;
+        r.failures += s.connect_failures + s.send_failures + s.disconnects + s.lost_acks;
+        no_ack = no_ack || s.no_ack_support;
+        latencies.insert(latencies.end(), s.latencies_ms.begin(), s.latencies_ms.end());
+    }
+
+    if (no_ack) {
+        std::cerr << "[LOAD] Backend did not answer the handshake: acks unavailable\n";
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    r.sent_fps = sent / elapsed;
+    r.accepted_fps = acks / elapsed;
+    r.p50_ms = percentile(latencies, 0.50);
+    r.p99_ms = percentile(latencies, 0.99);
+    r.max_ms = latencies.empty() ? 0.0 : latencies.back();
+
+    r.accepted = acks;
+    r.packets = cfg.replay.empty() ? acks * static_cast<uint64_t>(cfg.vehicles) : 0;
+    r.gc_ok = gc_ok;
+    if (gc_ok) {
+        r.gc_allocated_bytes = gc_after.allocated_bytes - gc_before.allocated_bytes;
+        r.gc_gen0 = gc_after.gen0 - gc_before.gen0;
+        r.gc_gen1 = gc_after.gen1 - gc_before.gen1;
+        r.gc_gen2 = gc_after.gen2 - gc_before.gen2;
+        r.gc_pause_ms = gc_after.pause_ms - gc_before.pause_ms;
+    }
+    return r;
+}
+
+static void print_step(const StepResult& r) {
+    std::printf("[LOAD] conns=%4d  offered=%9.1f fps  sent=%9.1f fps  accepted=%9.1f fps  "
+                "ack p50=%7.2f ms  p99=%7.2f ms  max=%7.2f ms  failures=%llu  rejected=%llu\n",
+                r.connections, r.offered_fps, r.sent_fps, r.accepted_fps,
+                r.p50_ms, r.p99_ms, r.max_ms,
+                static_cast<unsigned long long>(r.failures),
+                static_cast<unsigned long long>(r.rejected));
+
+    // Inclui tudo que o processo alocou no passo (API e publicador tambem)
+    if (!r.gc_ok) {
+        std::printf("[LOAD]   backend gc: unavailable (no /api/status on http port)\n");
+    } else {
+        double per_frame = r.accepted > 0 ? r.gc_allocated_bytes / r.accepted : 0.0;
+        double per_packet = r.packets > 0 ? r.gc_allocated_bytes / r.packets : 0.0;
+        std::printf("[LOAD]   backend gc: allocated=%.0f B (%.1f B/frame, %.1f B/packet)  "
+                    "gen0=%.0f gen1=%.0f gen2=%.0f  pause=%.1f ms\n",
+                    r.gc_allocated_bytes, per_frame, per_packet,
+                    r.gc_gen0, r.gc_gen1, r.gc_gen2, r.gc_pause_ms);
+    }
+    std::fflush(stdout);
+}
+
+static bool saturated(const LoadConfig& cfg, const StepResult& r) {
+    return r.failures > 0
+        || r.accepted_fps < SATURATION_RATIO * r.offered_fps
+        || r.p99_ms > cfg.max_latency_ms;
+}
+
+// ============================================================
+// Uso
+// ============================================================
+
+void print_usage(const char* prog) {
+    std::cout << "MineGuard Load Generator\n\n";
+    std::cout << "Usage:\n";
+    std::cout << "  " << prog << " [options]\n";
+    std::cout << "\nOptions:\n";
+    std::cout << "  --host <addr>          Backend hostname/IP (default: localhost)\n";
+    std::cout << "  --port <port>          Backend port (default: 5000)\n";
+    std::cout << "  --http-port <port>     Backend API port for GC counters (default: 5100)\n";
+    std::cout << "  --connections <n>      Concurrent connections (default: 1)\n";
+    std::cout << "  --vehicles <n>         Vehicles per batch (default: 5)\n";
+    std::cout << "  --alerts <n>           Synthetic alerts per batch (default: 0)\n";
+    std::cout << "  --rate <hz>            Batches per second per connection (default: 1)\n";
+    std::cout << "  --duration <s>         Run time, per step with --ramp (default: 10)\n";
+    std::cout << "  --replay <file>        Send recorded batches (one JSON batch per line)\n";
+    std::cout << "  --ramp                 Double connections each step until saturation\n";
+    std::cout << "  --max-connections <n>  Ramp limit (default: 256)\n";
+    std::cout << "  --max-latency <ms>     p99 ack latency that counts as saturated (default: 250)\n";
+    std::cout << "  --help                 Show this message\n";
+}
+
+static bool load_replay(const std::string& path, std::vector<std::string>& out) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) out.push_back(line);
+    }
+    return !out.empty();
+}
+
+// ============================================================
+// Main
+// ============================================================
+
+int main(int argc, char* argv[]) {
+    LoadConfig cfg;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--host") == 0 && has_value) {
+            cfg.host = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--port") == 0 && has_value) {
+            cfg.port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--http-port") == 0 && has_value) {
+            cfg.http_port = static_cast<uint16_t>(std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--connections") == 0 && has_value) {
+            cfg.connections = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--vehicles") == 0 && has_value) {
+            cfg.vehicles = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--alerts") == 0 && has_value) {
+            cfg.alerts = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--rate") == 0 && has_value) {
+            cfg.rate = std::max(0.1, std::stod(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--duration") == 0 && has_value) {
+            cfg.duration = std::max(1.0, std::stod(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && has_value) {
+            std::string path = argv[++i];
+            if (!load_replay(path, cfg.replay)) {
+                std::cerr << "Failed to read replay file: " << path << "\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--ramp") == 0) {
+            cfg.ramp = true;
+        }
+        else if (std::strcmp(argv[i], "--max-connections") == 0 && has_value) {
+            cfg.max_connections = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--max-latency") == 0 && has_value) {
+            cfg.max_latency_ms = std::stod(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else {
+            std::cerr << "Unknown option: " << argv[i] << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, signal_handler);
+
+    std::cout << "[LOAD] Target " << cfg.host << ":" << cfg.port
+              << ", " << cfg.rate << " batch/s per connection, "
+              << (cfg.replay.empty() ? std::to_string(cfg.vehicles) + " vehicles/batch"
+                                     : std::to_string(cfg.replay.size()) + " recorded batches")
+              << "\n";
+
+    if (!cfg.ramp) {
+        print_step(run_step(cfg, cfg.connections));
+        return 0;
+    }
+
+    // Rampa: dobra conexoes ate saturar ou bater o limite
+    StepResult last_good{};
+    bool have_good = false;
+
+    for (int conns = cfg.connections; running && conns <= cfg.max_connections; conns *= 2) {
+        StepResult r = run_step(cfg, conns);
+        print_step(r);
+
+        if (saturated(cfg, r)) {
+            std::cout << "[LOAD] Saturated at " << conns << " connections\n";
+            break;
+        }
+        last_good = r;
+        have_good = true;
+    }
+
+    if (have_good) {
+        std::printf("[LOAD] Sustained: %d connections, %.1f accepted fps, p99 %.2f ms\n",
+                    last_good.connections, last_good.accepted_fps, last_good.p99_ms);
+    } else {
+        std::cout << "[LOAD] No step sustained the offered load\n";
+    }
+
+    return 0;
+}
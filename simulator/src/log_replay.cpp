@@ -0,0 +1,848 @@
+#include "log_replay.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mineguard {
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double EARTH_RADIUS = 6371000.0;
+static constexpr double KNOTS_TO_KMH = 1.852;
+static constexpr float NO_VALUE = std::numeric_limits<float>::quiet_NaN();
+
+static constexpr double M_PER_DEG_LAT = EARTH_RADIUS * DEG_TO_RAD;
+
+// Deslocamento minimo entre amostras pra derivar rumo (abaixo disso e ruido)
+static constexpr double MIN_HEADING_DISTANCE = 1.0;   // metros
+
+// Velocidade do filtro abaixo disso: rumo e ruido, fica o ultimo
+static constexpr double STATIONARY_SPEED = 1.0;       // km/h
+
+using Clock = std::chrono::steady_clock;
+
+static double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool sample_before(const LogSample& a, const LogSample& b) {
+    return a.time_ms < b.time_ms;
+}
+
+// ============================================================
+// Configuracao padrao
+// ============================================================
+
+ReplayConfig ReplayConfig::create_default() {
+    return ReplayConfig{
+        .tick_seconds = 1.0,
+        .stale_seconds = 10.0,
+        .threads = 0,
+        .batch_bytes = 256u << 20,
+        .format = LogFormat::AUTO,
+        .filter = true,
+        .kalman = KalmanConfig::create_default()
+    };
+}
+
+// ============================================================
+// Arquivo mapeado
+// ============================================================
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        // Leitura em ordem: o kernel le adiantado
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+    }
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+    if (!data_ || length == 0) return;
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = offset / page * page;
+    size_t end = std::min(offset + length, size_) / page * page;
+    if (end > begin) {
+        madvise(const_cast<char*>(data_) + begin, end - begin, MADV_DONTNEED);
+    }
+}
+
+// ============================================================
+// Parse de campos (sem alocacao, sem locale)
+// ============================================================
+
+// Campos separados por virgula dentro de uma linha
+struct FieldCursor {
+    const char* p;
+    const char* end;
+    bool done;
+
+    FieldCursor(const char* begin, const char* line_end) : p(begin), end(line_end), done(false) {}
+
+    bool next(std::string_view& field) {
+        if (done) return false;
+        const char* comma = static_cast<const char*>(std::memchr(p, ',', end - p));
+        const char* field_end = comma ? comma : end;
+        field = std::string_view(p, field_end - p);
+        if (comma) p = comma + 1;
+        else done = true;
+        return true;
+    }
+};
+
+static const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+// Decimal com sinal e fracao opcional (sem expoente). Mantissa inteira
+// de ate 18 digitos / 10^n: sai corretamente arredondado; digitos de
+// fracao alem disso sao truncados.
+static bool parse_decimal(std::string_view s, double& out) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+        negative = s[i] == '-';
+        i++;
+    }
+
+    uint64_t mantissa = 0;
+    int fraction = 0;
+    bool dot = false;
+    bool any_digit = false;
+    for (; i < s.size(); i++) {
+        char c = s[i];
+        if (c >= '0' && c <= '9') {
+            any_digit = true;
+            if (mantissa < 100000000000000000ULL && fraction < 18) {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+                if (dot) fraction++;
+            } else if (!dot) {
+                return false;   // inteiro grande demais pra um campo de log
+            }
+        } else if (c == '.' && !dot) {
+            dot = true;
+        } else {
+            return false;
+        }
+    }
+    if (!any_digit) return false;
+
+    double value = static_cast<double>(mantissa) / POW10[fraction];
+    out = negative ? -value : value;
+    return true;
+}
+
+// Campo vazio = sem valor (NaN)
+static bool parse_optional(std::string_view s, float& out) {
+    if (s.empty()) {
+        out = NO_VALUE;
+        return true;
+    }
+    double value;
+    if (!parse_decimal(s, value)) return false;
+    out = static_cast<float>(value);
+    return true;
+}
+
+static bool parse_digits(std::string_view s, size_t pos, size_t count, int& out) {
+    if (pos + count > s.size()) return false;
+    int value = 0;
+    for (size_t i = pos; i < pos + count; i++) {
+        char c = s[i];
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    out = value;
+    return true;
+}
+
+// Dias desde 1970-01-01 no calendario gregoriano proleptico
+static int64_t days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// hhmmss[.sss] -> ms no dia
+static bool parse_clock(std::string_view s, int64_t& out) {
+    int hh, mm, ss;
+    if (!parse_digits(s, 0, 2, hh) || !parse_digits(s, 2, 2, mm) || !parse_digits(s, 4, 2, ss)) {
+        return false;
+    }
+    double fraction = 0.0;
+    if (s.size() > 6) {
+        if (s[6] != '.' || !parse_decimal(s.substr(6), fraction)) return false;
+    }
+    out = ((hh * 60 + mm) * 60 + ss) * 1000LL + std::llround(fraction * 1000.0);
+    return true;
+}
+
+// YYYY-MM-DD[T ]HH:MM:SS[.fff][Z|+hh:mm|-hh:mm]
+static bool parse_iso8601(std::string_view s, int64_t& out) {
+    int year, month, day, hh, mm, ss;
+    if (s.size() < 19 || s[4] != '-' || s[7] != '-' || (s[10] != 'T' && s[10] != ' ') ||
+        s[13] != ':' || s[16] != ':') {
+        return false;
+    }
+    if (!parse_digits(s, 0, 4, year) || !parse_digits(s, 5, 2, month) ||
+        !parse_digits(s, 8, 2, day) || !parse_digits(s, 11, 2, hh) ||
+        !parse_digits(s, 14, 2, mm) || !parse_digits(s, 17, 2, ss)) {
+        return false;
+    }
+
+    size_t i = 19;
+    int64_t millis = 0;
+    if (i < s.size() && s[i] == '.') {
+        size_t start = i;
+        i++;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') i++;
+        double fraction;
+        if (!parse_decimal(s.substr(start, i - start), fraction)) return false;
+        millis = std::llround(fraction * 1000.0);
+    }
+
+    int64_t offset_min = 0;
+    if (i < s.size()) {
+        if (s[i] == 'Z' && i + 1 == s.size()) {
+            // UTC
+        } else if ((s[i] == '+' || s[i] == '-') && s.size() == i + 6 && s[i + 3] == ':') {
+            int oh, om;
+            if (!parse_digits(s, i + 1, 2, oh) || !parse_digits(s, i + 4, 2, om)) return false;
+            offset_min = (oh * 60 + om) * (s[i] == '-' ? -1 : 1);
+        } else {
+            return false;
+        }
+    }
+
+    int64_t days = days_from_civil(year, month, day);
+    out = ((days * 24 + hh) * 60 + mm) * 60000LL + ss * 1000LL + millis - offset_min * 60000LL;
+    return true;
+}
+
+// Epoch em segundos ou ms (com fracao), ou ISO 8601
+static bool parse_timestamp(std::string_view s, int64_t& out) {
+    if (s.size() >= 19 && s[4] == '-') return parse_iso8601(s, out);
+
+    double value;
+    if (!parse_decimal(s, value)) return false;
+    // Abaixo de 1e11: segundos (1e11 s e o ano 5138; 1e11 ms e 1973)
+    out = value < 1e11 ? std::llround(value * 1000.0) : std::llround(value);
+    return true;
+}
+
+// Tipo pela coluna: digito do enum ou nome (HaulTruck, excavator, LV...)
+static uint32_t parse_type(std::string_view s) {
+    if (s.empty()) return LogChunk::TYPE_UNKNOWN;
+    if (s.size() == 1 && s[0] >= '0' && s[0] <= '2') return static_cast<uint32_t>(s[0] - '0');
+    switch (s[0] | 0x20) {
+        case 'h': return static_cast<uint32_t>(VehicleType::HAUL_TRUCK);
+        case 'e': return static_cast<uint32_t>(VehicleType::EXCAVATOR);
+        case 'l': return static_cast<uint32_t>(VehicleType::LIGHT_VEHICLE);
+        default:  return LogChunk::TYPE_UNKNOWN;
+    }
+}
+
+// Tipo pelo prefixo do ID (convencao da frota: HT-101, EX-201, LV-301).
+// Sem prefixo conhecido: caminhao, o maior raio de seguranca.
+static VehicleType type_from_id(std::string_view id) {
+    if (id.size() >= 2 && (id.size() == 2 || !std::isalpha(static_cast<unsigned char>(id[2])))) {
+        char a = static_cast<char>(id[0] | 0x20);
+        char b = static_cast<char>(id[1] | 0x20);
+        if (a == 'e' && b == 'x') return VehicleType::EXCAVATOR;
+        if (a == 'l' && b == 'v') return VehicleType::LIGHT_VEHICLE;
+    }
+    return VehicleType::HAUL_TRUCK;
+}
+
+// ddmm.mmmm / dddmm.mmmm + hemisferio -> graus decimais
+static bool parse_nmea_angle(std::string_view value, std::string_view hemisphere,
+                             size_t degree_digits, double& out) {
+    int degrees;
+    double minutes;
+    if (value.size() <= degree_digits || hemisphere.size() != 1) return false;
+    if (!parse_digits(value, 0, degree_digits, degrees)) return false;
+    if (!parse_decimal(value.substr(degree_digits), minutes)) return false;
+
+    double angle = degrees + minutes / 60.0;
+    char h = hemisphere[0];
+    if (h == 'S' || h == 'W') angle = -angle;
+    else if (h != 'N' && h != 'E') return false;
+    out = angle;
+    return true;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// ============================================================
+// Parse de um pedaco
+// ============================================================
+
+void LogChunk::clear() {
+    samples.clear();
+    ids.clear();
+    types.clear();
+    id_index.clear();
+    lines = 0;
+    bad_lines = 0;
+    skipped_lines = 0;
+}
+
+uint32_t LogChunk::intern(std::string_view id, uint32_t type) {
+    auto it = id_index.find(id);
+    if (it != id_index.end()) {
+        if (types[it->second] == TYPE_UNKNOWN) types[it->second] = type;
+        return it->second;
+    }
+    uint32_t index = static_cast<uint32_t>(ids.size());
+    ids.push_back(id);
+    types.push_back(type);
+    id_index.emplace(id, index);
+    return index;
+}
+
+void LogChunk::parse(const char* begin, const char* end, LogFormat format, bool first_in_file) {
+    // ~40 bytes por linha de log: evita realocar no meio do pedaco
+    size_t expected = static_cast<size_t>(end - begin) / 40 + 16;
+    if (samples.capacity() < expected) samples.reserve(expected);
+
+    bool first_line = first_in_file;
+    const char* p = begin;
+    while (p < end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* line_end = newline ? newline : end;
+        const char* next = newline ? newline + 1 : end;
+        if (line_end > p && line_end[-1] == '\r') line_end--;
+
+        if (line_end == p) {
+            p = next;
+            continue;
+        }
+        lines++;
+
+        if (*p == '#') {
+            skipped_lines++;
+        } else if (format == LogFormat::NMEA) {
+            bool skipped = false;
+            if (!parse_nmea(p, line_end, skipped)) {
+                if (skipped) skipped_lines++;
+                else bad_lines++;
+            }
+        } else if (!parse_csv(p, line_end)) {
+            // Primeira linha do arquivo que nao parseia: cabecalho
+            if (first_line) skipped_lines++;
+            else bad_lines++;
+        }
+
+        first_line = false;
+        p = next;
+    }
+
+    // Log agrupado por veiculo/gravador: ordena aqui, na thread do pedaco
+    if (!std::is_sorted(samples.begin(), samples.end(), sample_before)) {
+        std::stable_sort(samples.begin(), samples.end(), sample_before);
+    }
+}
+
+bool LogChunk::parse_csv(const char* begin, const char* end) {
+    FieldCursor fields(begin, end);
+    std::string_view time_field, id, lat_field, lon_field;
+    if (!fields.next(time_field) || !fields.next(id) ||
+        !fields.next(lat_field) || !fields.next(lon_field) || id.empty()) {
+        return false;
+    }
+
+    LogSample sample;
+    if (!parse_timestamp(time_field, sample.time_ms) ||
+        !parse_decimal(lat_field, sample.latitude) ||
+        !parse_decimal(lon_field, sample.longitude)) {
+        return false;
+    }
+
+    std::string_view field;
+    sample.speed = NO_VALUE;
+    sample.heading = NO_VALUE;
+    uint32_t type = TYPE_UNKNOWN;
+    if (fields.next(field) && !parse_optional(field, sample.speed)) return false;
+    if (fields.next(field) && !parse_optional(field, sample.heading)) return false;
+    if (fields.next(field)) type = parse_type(field);
+
+    sample.vehicle = intern(id, type);
+    samples.push_back(sample);
+    return true;
+}
+
+bool LogChunk::parse_nmea(const char* begin, const char* end, bool& skipped) {
+    const char* dollar = static_cast<const char*>(std::memchr(begin, '$', end - begin));
+    if (!dollar || dollar < begin + 2 || dollar[-1] != ',') return false;
+    std::string_view id(begin, dollar - 1 - begin);
+
+    // Checksum: XOR de tudo entre '$' e '*'
+    const char* star = end - 3;
+    if (star <= dollar || *star != '*') return false;
+    int hi = hex_value(star[1]);
+    int lo = hex_value(star[2]);
+    if (hi < 0 || lo < 0) return false;
+    unsigned char sum = 0;
+    for (const char* c = dollar + 1; c < star; c++) sum ^= static_cast<unsigned char>(*c);
+    if (sum != ((hi << 4) | lo)) return false;
+
+    FieldCursor fields(dollar, star);
+    std::string_view sentence, clock, status, lat, ns, lon, ew, speed, course, date;
+    if (!fields.next(sentence)) return false;
+    if (sentence.size() != 6 || sentence.substr(3) != "RMC") {
+        skipped = true;   // GGA, GSV...: so RMC tem data, velocidade e rumo
+        return false;
+    }
+    if (!fields.next(clock) || !fields.next(status) || !fields.next(lat) || !fields.next(ns) ||
+        !fields.next(lon) || !fields.next(ew) || !fields.next(speed) ||
+        !fields.next(course) || !fields.next(date)) {
+        return false;
+    }
+    if (status != "A") {
+        skipped = true;   // receptor sem fix
+        return false;
+    }
+
+    LogSample sample;
+    int64_t ms_of_day;
+    int dd, mo, yy;
+    if (!parse_clock(clock, ms_of_day) || date.size() != 6 ||
+        !parse_digits(date, 0, 2, dd) || !parse_digits(date, 2, 2, mo) || !parse_digits(date, 4, 2, yy) ||
+        !parse_nmea_angle(lat, ns, 2, sample.latitude) ||
+        !parse_nmea_angle(lon, ew, 3, sample.longitude) ||
+        !parse_optional(speed, sample.speed) || !parse_optional(course, sample.heading)) {
+        return false;
+    }
+    int year = yy < 80 ? 2000 + yy : 1900 + yy;
+    sample.time_ms = days_from_civil(year, mo, dd) * 86400000LL + ms_of_day;
+    sample.speed *= static_cast<float>(KNOTS_TO_KMH);
+
+    sample.vehicle = intern(id, TYPE_UNKNOWN);
+    samples.push_back(sample);
+    return true;
+}
+
+// ============================================================
+// Replay
+// ============================================================
+
+LogReplay::LogReplay(const ReplayConfig& config)
+    : config_(config)
+    , format_(config.format)
+    , events_(nullptr)
+    , filter_(config.kalman)
+    , plane_origin_{0.0, 0.0, 0.0}
+    , m_per_deg_lon_(M_PER_DEG_LAT)
+    , started_(false)
+    , origin_ms_(0)
+    , tick_ms_(std::max<int64_t>(1, std::llround(config.tick_seconds * 1000.0)))
+    , tick_(0)
+    , newest_ms_(0)
+{
+}
+
+bool LogReplay::open(const std::string& path) {
+    if (!file_.open(path)) return false;
+    if (config_.format == LogFormat::AUTO) {
+        format_ = detect_format(file_.data(), file_.size());
+    }
+    return true;
+}
+
+LogFormat LogReplay::detect_format(const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + std::min<size_t>(size, 1 << 16);
+    while (p < end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* line_end = newline ? newline : end;
+        if (line_end > p && *p != '#' && *p != '\r') {
+            // ID do gravador seguido da sentenca
+            const char* dollar = static_cast<const char*>(std::memchr(p, '$', line_end - p));
+            return dollar && dollar > p && dollar[-1] == ',' ? LogFormat::NMEA : LogFormat::CSV;
+        }
+        if (!newline) break;
+        p = newline + 1;
+    }
+    return LogFormat::CSV;
+}
+
+// Corta [begin, end) em um pedaco por thread, sempre depois de '\n'
+void LogReplay::parse_batch(size_t begin, size_t end, std::vector<LogChunk>& chunks) const {
+    const char* data = file_.data();
+    const size_t n = chunks.size();
+
+    std::vector<size_t> bounds(n + 1);
+    bounds[0] = begin;
+    bounds[n] = end;
+    for (size_t i = 1; i < n; i++) {
+        size_t pos = std::max(bounds[i - 1], begin + (end - begin) * i / n);
+        const char* newline = pos < end
+            ? static_cast<const char*>(std::memchr(data + pos, '\n', end - pos))
+            : nullptr;
+        bounds[i] = newline ? static_cast<size_t>(newline - data) + 1 : end;
+    }
+
+    auto parse_one = [&](size_t i) {
+        chunks[i].clear();
+        chunks[i].parse(data + bounds[i], data + bounds[i + 1], format_, bounds[i] == 0);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(n - 1);
+    for (size_t i = 1; i < n; i++) workers.emplace_back(parse_one, i);
+    parse_one(0);
+    for (auto& w : workers) w.join();
+}
+
+// IDs locais do pedaco -> indices globais (veiculo novo na primeira vez)
+void LogReplay::merge_chunk(LogChunk& chunk) {
+    remap_.resize(chunk.ids.size());
+    for (size_t i = 0; i < chunk.ids.size(); i++) {
+        auto it = global_ids_.find(chunk.ids[i]);
+        if (it != global_ids_.end()) {
+            remap_[i] = it->second;
+            continue;
+        }
+
+        uint32_t index = static_cast<uint32_t>(tracks_.size());
+        VehicleType type = chunk.types[i] != LogChunk::TYPE_UNKNOWN
+            ? static_cast<VehicleType>(chunk.types[i])
+            : type_from_id(chunk.ids[i]);
+
+        VehicleTrack track;
+        track.vehicle = std::make_unique<Vehicle>(std::string(chunk.ids[i]), type, Position{0.0, 0.0, 0.0});
+        track.vehicle->set_handle(VehicleHandle{index, 0});
+        track.last_ms = 0;
+        track.last_heading = 0.0;
+        track.seen = false;
+        tracks_.push_back(std::move(track));
+
+        global_ids_.emplace(std::string_view(tracks_.back().vehicle->id()), index);
+        remap_[i] = index;
+    }
+
+    for (LogSample& s : chunk.samples) s.vehicle = remap_[s.vehicle];
+}
+
+// Pedacos do lote (cada um ja em ordem de tempo) intercalados em batch_,
+// dois a dois. Pedaco que ja comeca depois do anterior nao mexe.
+void LogReplay::merge_batch(std::vector<LogChunk>& chunks, ReplayReport& report) {
+    batch_.clear();
+    runs_.assign(1, 0);
+    for (LogChunk& chunk : chunks) {
+        merge_chunk(chunk);
+        report.lines += chunk.lines;
+        report.bad_lines += chunk.bad_lines;
+        report.skipped_lines += chunk.skipped_lines;
+        report.samples += chunk.samples.size();
+
+        batch_.insert(batch_.end(), chunk.samples.begin(), chunk.samples.end());
+        runs_.push_back(batch_.size());
+    }
+
+    while (runs_.size() > 2) {
+        size_t out = 1;
+        for (size_t i = 0; i + 2 < runs_.size(); i += 2) {
+            auto first = batch_.begin() + runs_[i];
+            auto middle = batch_.begin() + runs_[i + 1];
+            auto last = batch_.begin() + runs_[i + 2];
+            if (first != middle && middle != last && sample_before(*middle, middle[-1])) {
+                std::inplace_merge(first, middle, last, sample_before);
+            }
+            runs_[out++] = runs_[i + 2];
+        }
+        // Numero impar de pedacos: o ultimo passa pra proxima rodada
+        if (runs_.size() % 2 == 0) runs_[out++] = runs_.back();
+        runs_.resize(out);
+    }
+
+    if (config_.filter) filter_.resize(tracks_.size());
+}
+
+// Amostra vira o estado do veiculo no tick. Sem velocidade/rumo no log
+// (CSV so com posicao, RMC parado), deriva da amostra anterior.
+//
+// Com filtro a amostra e so o fix do tick: a estimativa sai em
+// update_estimates(). Veiculo que some por mais que o stale reinicia
+// o filtro no fix seguinte.
+bool LogReplay::apply_sample(const LogSample& s) {
+    VehicleTrack& track = tracks_[s.vehicle];
+    if (track.seen && s.time_ms <= track.last_ms) return false;
+
+    if (config_.filter) {
+        if (!track.seen || s.time_ms - track.last_ms > std::llround(config_.stale_seconds * 1000.0)) {
+            filter_.reset(s.vehicle);
+        }
+        Position fix{s.latitude, s.longitude, 0.0};
+        filter_.measure(s.vehicle,
+                        (s.longitude - plane_origin_.longitude) * m_per_deg_lon_,
+                        (s.latitude - plane_origin_.latitude) * M_PER_DEG_LAT);
+        track.vehicle->set_gnss_fix(fix, true);
+        track.last_ms = s.time_ms;
+        track.seen = true;
+        return true;
+    }
+
+    double speed = s.speed;
+    double heading = s.heading;
+    if (std::isnan(speed) || std::isnan(heading)) {
+        double distance = 0.0;
+        double bearing = track.last_heading;
+        double dt = 0.0;
+        if (track.seen) {
+            const Position& prev = track.vehicle->sensed_position();
+            double dn = (s.latitude - prev.latitude) * M_PER_DEG_LAT;
+            double de = (s.longitude - prev.longitude) * M_PER_DEG_LAT * std::cos(s.latitude * DEG_TO_RAD);
+            distance = std::sqrt(dn * dn + de * de);
+            dt = (s.time_ms - track.last_ms) / 1000.0;
+            if (distance >= MIN_HEADING_DISTANCE) {
+                bearing = std::atan2(de, dn) / DEG_TO_RAD;
+                if (bearing < 0.0) bearing += 360.0;
+            }
+        }
+        if (std::isnan(speed)) {
+            // Buraco maior que o stale: velocidade media nao diz nada
+            speed = dt > 0.0 && dt <= config_.stale_seconds ? distance / dt * 3.6 : 0.0;
+        }
+        if (std::isnan(heading)) heading = bearing;
+    }
+
+    // Fix bruto: o erro do receptor nao e conhecido (o detector usa o nominal)
+    track.vehicle->set_estimate(Position{s.latitude, s.longitude, 0.0}, speed, heading, 0.0);
+    track.last_ms = s.time_ms;
+    track.last_heading = heading;
+    track.seen = true;
+    return true;
+}
+
+// Um passo do filtro por tick (todos os slots; veiculo parado no log so
+// e predito e reinicia quando volta). Estimativa vira o estado dos
+// veiculos ativos, como em FleetManager::sense.
+void LogReplay::update_estimates() {
+    filter_.step(config_.tick_seconds);
+
+    for (Vehicle* v : active_) {
+        uint32_t slot = v->handle().slot;
+        if (!filter_.initialized(slot)) continue;
+
+        VehicleTrack& track = tracks_[slot];
+        double vx = filter_.vx(slot);
+        double vy = filter_.vy(slot);
+        double speed = std::sqrt(vx * vx + vy * vy) * 3.6;
+        if (speed >= STATIONARY_SPEED) {
+            track.last_heading = std::atan2(vx, vy) / DEG_TO_RAD;
+            if (track.last_heading < 0.0) track.last_heading += 360.0;
+        }
+
+        v->set_estimate(Position{
+            plane_origin_.latitude + filter_.y(slot) / M_PER_DEG_LAT,
+            plane_origin_.longitude + filter_.x(slot) / m_per_deg_lon_,
+            0.0
+        }, speed, track.last_heading, filter_.position_sigma(slot));
+    }
+}
+
+int64_t LogReplay::tick_start_ms(uint64_t tick) const {
+    return origin_ms_ + static_cast<int64_t>(tick) * tick_ms_;
+}
+
+static const char* priority_name(AlertPriority p) {
+    switch (p) {
+        case AlertPriority::LOW:      return "LOW";
+        case AlertPriority::MEDIUM:   return "MEDIUM";
+        case AlertPriority::HIGH:     return "HIGH";
+        case AlertPriority::CRITICAL: return "CRITICAL";
+        default: return "NONE";
+    }
+}
+
+// Estado no fim do tick: ultima amostra de cada veiculo ainda fresco
+void LogReplay::run_tick(CollisionDetector& detector, ReplayReport& report) {
+    int64_t end_ms = tick_start_ms(tick_ + 1);
+    int64_t stale_ms = std::llround(config_.stale_seconds * 1000.0);
+
+    active_.clear();
+    for (VehicleTrack& t : tracks_) {
+        if (t.seen && t.last_ms >= end_ms - stale_ms) active_.push_back(t.vehicle.get());
+    }
+
+    auto start = Clock::now();
+    if (config_.filter) update_estimates();
+    detector.check_all(active_, active_.size(), tick_ * config_.tick_seconds, end_ms, alerts_);
+    report.detect_seconds += seconds_since(start);
+    report.ticks++;
+
+    // Slot do alerta = indice global do veiculo (set_handle em merge_chunk)
+    for (const CollisionAlert& a : alerts_) {
+        size_t p = static_cast<size_t>(a.priority);
+        report.alert_ticks[p]++;
+
+        // Episodio novo ou subida de prioridade: evento
+        if (a.priority <= episodes_.observe(a)) continue;
+        report.alert_events[p]++;
+        if (events_) {
+            // CPA com 6 casas (~0.1 m), fora da precisao padrao do stream
+            char cpa[64];
+            std::snprintf(cpa, sizeof(cpa), "%.6f,%.6f", a.cpa.latitude, a.cpa.longitude);
+            *events_ << a.timestamp << ',' << a.vehicle_id_1 << ',' << a.vehicle_id_2 << ','
+                     << priority_name(a.priority) << ',' << a.time_to_impact << ','
+                     << a.distance << ',' << a.probability << ',' << cpa << '\n';
+        }
+    }
+    episodes_.end_tick();
+}
+
+ReplayReport LogReplay::run(CollisionDetector& detector) {
+    ReplayReport report;
+    auto run_start = Clock::now();
+
+    const size_t size = file_.size();
+    report.bytes = size;
+
+    size_t threads = config_.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t batch = std::max<size_t>(config_.batch_bytes, 1 << 16);
+
+    // Fim de lote sempre depois de '\n'
+    auto batch_end = [&](size_t begin) {
+        if (size - begin <= batch) return size;
+        const char* newline = static_cast<const char*>(
+            std::memchr(file_.data() + begin + batch, '\n', size - begin - batch));
+        return newline ? static_cast<size_t>(newline - file_.data()) + 1 : size;
+    };
+
+    if (events_) {
+        *events_ << "timestamp_ms,vehicle_1,vehicle_2,priority,time_to_impact,distance,probability,cpa_latitude,cpa_longitude\n";
+    }
+
+    // Dois conjuntos de pedacos: um parseando, outro alimentando o detector
+    std::vector<LogChunk> current(threads);
+    std::vector<LogChunk> next(threads);
+
+    size_t begin = 0;
+    size_t end = batch_end(0);
+    if (size > 0) {
+        auto start = Clock::now();
+        parse_batch(begin, end, current);
+        report.parse_seconds += seconds_since(start);
+    }
+
+    const int64_t stale_ms = std::llround(config_.stale_seconds * 1000.0);
+
+    while (begin < size) {
+        size_t next_begin = end;
+        size_t next_end = next_begin < size ? batch_end(next_begin) : size;
+
+        double next_parse_seconds = 0.0;
+        std::thread parser;
+        if (next_begin < size) {
+            parser = std::thread([&] {
+                auto start = Clock::now();
+                parse_batch(next_begin, next_end, next);
+                next_parse_seconds = seconds_since(start);
+            });
+        }
+
+        merge_batch(current, report);
+        for (const LogSample& s : batch_) {
+            if (!started_) {
+                started_ = true;
+                origin_ms_ = s.time_ms;
+                newest_ms_ = s.time_ms;
+                report.first_ms = s.time_ms;
+                report.last_ms = s.time_ms;
+                plane_origin_ = Position{s.latitude, s.longitude, 0.0};
+                m_per_deg_lon_ = M_PER_DEG_LAT * std::cos(s.latitude * DEG_TO_RAD);
+            }
+
+            int64_t offset = s.time_ms - origin_ms_;
+            int64_t sample_tick = offset >= 0 ? offset / tick_ms_ : -1;
+
+            while (sample_tick > static_cast<int64_t>(tick_)) {
+                run_tick(detector, report);
+                tick_++;
+
+                // Frota toda parada no log (troca de turno, noite): pula
+                // direto pro tick da amostra
+                if (newest_ms_ < tick_start_ms(tick_ + 1) - stale_ms &&
+                    sample_tick > static_cast<int64_t>(tick_)) {
+                    report.gap_ticks += static_cast<uint64_t>(sample_tick) - tick_;
+                    tick_ = static_cast<uint64_t>(sample_tick);
+                }
+            }
+
+            if (sample_tick < static_cast<int64_t>(tick_)) report.late_samples++;
+            if (!apply_sample(s)) continue;
+            newest_ms_ = std::max(newest_ms_, s.time_ms);
+            report.last_ms = std::max(report.last_ms, s.time_ms);
+        }
+
+        if (parser.joinable()) {
+            parser.join();
+            report.parse_seconds += next_parse_seconds;
+        }
+
+        // Lote consumido: paginas podem sair do page cache
+        file_.release(begin, end - begin);
+
+        std::swap(current, next);
+        begin = next_begin;
+        end = next_end;
+    }
+
+    if (started_) run_tick(detector, report);
+
+    report.vehicles = tracks_.size();
+    report.total_seconds = seconds_since(run_start);
+    return report;
+}
+
+} // namespace mineguard
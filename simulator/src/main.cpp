@@ -1,14 +1,21 @@
 #include "fleet.hpp"
 #include "collision.hpp"
+#include "sharded_sim.hpp"
 #include "tcp_client.hpp"
 #include "json_serializer.hpp"
+#include "alloc_counter.hpp"
+#include "tick_stats.hpp"
+#include "tick_clock.hpp"
+#include "overload_governor.hpp"
+#include "near_miss_heatmap.hpp"
 
 #include <iostream>
 #include <string>
-#include <thread>
+#include <algorithm>
 #include <chrono>
 #include <csignal>
 #include <cstring>
+#include <cmath>
 
 using namespace mineguard;
 
@@ -93,22 +100,43 @@ void print_alerts(const std::vector<CollisionAlert>& alerts) {
     if (alerts.empty()) {
         std::cout << "  [ALERTS] No active alerts\n";
     } else {
-        std::cout << "  ┌─────────────────── COLLISION ALERTS ───────────────────┐\n";
+        std::cout << "  ┌─────────────────────── COLLISION ALERTS ───────────────────────┐\n";
         for (const auto& a : alerts) {
-            std::printf("  │ %-8s ↔ %-8s  %-10s  %-12s  TTI: %4.1fs  Dist: %5.1fm │\n",
+            std::printf("  │ %-8s ↔ %-8s  %-10s  %-12s  TTI: %4.1fs  Dist: %5.1fm  P: %3.0f%% │\n",
                 a.vehicle_id_1.c_str(),
                 a.vehicle_id_2.c_str(),
                 priority_str(a.priority),
                 alert_type_str(a.type),
                 a.time_to_impact,
-                a.distance
+                a.distance,
+                a.probability * 100.0
             );
         }
-        std::cout << "  └──────────────────────────────────────────────────────────┘\n";
+        std::cout << "  └──────────────────────────────────────────────────────────────────┘\n";
     }
     std::cout << "\n  Press Ctrl+C to stop\n";
 }
 
+// Valor de KPI ou "-" se a janela ainda nao tem dados
+static const char* kpi_field(char (&buf)[32], double value, const char* format) {
+    if (std::isnan(value)) return "-";
+    std::snprintf(buf, sizeof(buf), format, value);
+    return buf;
+}
+
+void print_kpi(const KpiReport& report) {
+    for (size_t w = 0; w < KPI_WINDOWS; w++) {
+        const KpiValues& v = report.fleet[w];
+        char cycle[32], rate[32], queue[32], fuel[32];
+        std::printf("  [KPI %5.0fs] cycles %u  cycle %ss  %.0ft (%st/h)  queue %ss  fuel %sL/t\n",
+            report.windows[w], v.cycles,
+            kpi_field(cycle, v.cycle_time, "%.0f"), v.tonnes,
+            kpi_field(rate, v.tonnes_per_hour, "%.0f"),
+            kpi_field(queue, v.queue_time, "%.0f"),
+            kpi_field(fuel, v.fuel_per_tonne, "%.3f"));
+    }
+}
+
 // ============================================================
 // Uso
 // ============================================================
@@ -122,6 +150,14 @@ void print_usage(const char* prog) {
     std::cout << "  --local          Console output only, no network\n";
     std::cout << "  --host <addr>    Backend hostname/IP (default: localhost)\n";
     std::cout << "  --port <port>    Backend port (default: 5000)\n";
+    std::cout << "  --source-id <id> Source/gateway ID sent in the session handshake\n";
+    std::cout << "  --stats-file <f> Write per-tick stage timing/allocation stats as CSV\n";
+    std::cout << "  --shards <n>     Split the mine into n spatial shards, one thread each (default: 1)\n";
+    std::cout << "  --spin-us <us>   Busy-spin the last <us> microseconds before each tick deadline\n";
+    std::cout << "  --risk           Model GNSS noise and report collision probability per alert\n";
+    std::cout << "  --gnss-noise <m> Add GNSS error (white noise sigma <m>, bias walk, dropouts)\n";
+    std::cout << "                   and feed the detector from a Kalman filter\n";
+    std::cout << "  --gnss-dropout <r> GNSS dropouts per second per vehicle (with --gnss-noise)\n";
     std::cout << "  --help           Show this message\n";
 }
 
@@ -133,6 +169,13 @@ int main(int argc, char* argv[]) {
     bool local_mode = false;
     std::string host = "localhost";
     uint16_t port = 5000;
+    std::string source_id;
+    std::string stats_file;
+    size_t shard_count = 1;
+    int spin_us = 0;
+    bool risk_mode = false;
+    bool gnss_noise = false;
+    GnssErrorConfig gnss_config = GnssErrorConfig::create_default();
 
     // Parse argumentos
     for (int i = 1; i < argc; i++) {
@@ -145,6 +188,29 @@ int main(int argc, char* argv[]) {
         else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
             port = static_cast<uint16_t>(std::stoi(argv[++i]));
         }
+        else if (std::strcmp(argv[i], "--source-id") == 0 && i + 1 < argc) {
+            source_id = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            stats_file = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            int n = std::stoi(argv[++i]);
+            shard_count = n > 0 ? static_cast<size_t>(n) : 1;
+        }
+        else if (std::strcmp(argv[i], "--spin-us") == 0 && i + 1 < argc) {
+            spin_us = std::max(0, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--risk") == 0) {
+            risk_mode = true;
+        }
+        else if (std::strcmp(argv[i], "--gnss-noise") == 0 && i + 1 < argc) {
+            gnss_noise = true;
+            gnss_config.white_sigma = std::max(0.0, std::stod(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--gnss-dropout") == 0 && i + 1 < argc) {
+            gnss_config.dropout_rate = std::max(0.0, std::stod(argv[++i]));
+        }
         else if (std::strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -165,16 +231,50 @@ int main(int argc, char* argv[]) {
     // Registrar signal handler pra Ctrl+C
     std::signal(SIGINT, signal_handler);
 
-    // Inicializar fleet e collision detector
+    // Inicializar fleet e shards (cada um com seu collision detector)
     FleetManager fleet;
     fleet.initialize();
 
-    CollisionDetector collision;
+    ShardedSimulation sim(fleet, shard_count);
+    std::cout << "[SIM] Conflict zones: " << fleet.conflict_zones().size() << "\n";
+    if (sim.shard_count() > 1) {
+        std::cout << "[SIM] Spatial shards: " << sim.shard_count() << "\n";
+    }
+    if (gnss_noise) {
+        // Filtro espera o ruido total do fix: branco + vies tipico
+        KalmanConfig filter = KalmanConfig::create_default();
+        filter.measurement_sigma = std::sqrt(gnss_config.white_sigma * gnss_config.white_sigma +
+                                             gnss_config.bias_limit * gnss_config.bias_limit / 3.0);
+        fleet.enable_gnss(gnss_config, filter);
+        std::cout << "[SIM] GNSS noise " << gnss_config.white_sigma << "m, dropouts "
+                  << gnss_config.dropout_rate << "/s, Kalman filter on\n";
+    }
+    if (risk_mode) {
+        sim.set_risk_mode(true);
+        std::cout << "[SIM] Probabilistic risk mode (GNSS noise model)\n";
+    }
+
+    // Mapa de calor de quase-colisoes sobre a area das rotas
+    Position south_west{90.0, 180.0, 0.0};
+    Position north_east{-90.0, -180.0, 0.0};
+    for (const auto& [name, p] : fleet.mine().waypoints) {
+        south_west.latitude = std::min(south_west.latitude, p.latitude);
+        south_west.longitude = std::min(south_west.longitude, p.longitude);
+        north_east.latitude = std::max(north_east.latitude, p.latitude);
+        north_east.longitude = std::max(north_east.longitude, p.longitude);
+    }
+    NearMissHeatmap heatmap(HeatmapConfig::create_default(), south_west, north_east);
+    HeatmapTile heatmap_tile{};
+    std::cout << "[SIM] Near-miss heatmap " << heatmap.cols() << "x" << heatmap.rows() << " cells\n";
+
+    // KPIs de producao pelas transicoes de ciclo
+    fleet.enable_kpi(KpiConfig::create_default());
+    KpiReport kpi_report{};
 
     // Conectar ao backend se nao for modo local
     std::unique_ptr<TcpClient> tcp;
     if (!local_mode) {
-        tcp = std::make_unique<TcpClient>(host, port);
+        tcp = std::make_unique<TcpClient>(host, port, source_id);
         std::cout << "[SIM] Connecting to backend at " << host << ":" << port << "...\n";
 
         if (!tcp->connect_to_server()) {
@@ -188,31 +288,104 @@ int main(int argc, char* argv[]) {
     // Loop principal - 1 Hz (1 update por segundo)
     // ========================================================
 
-    int tick = 0;
+    uint64_t tick = 0;
     int reconnect_counter = 0;
     constexpr double DELTA_TIME = 1.0; // 1 segundo
+    constexpr uint64_t STATS_REPORT_INTERVAL = 10; // ticks
+
+    // Buffers do tick: limpos e reescritos, nunca liberados
+    std::vector<TelemetryPacket> packets;
+    std::vector<CollisionAlert> alerts;
+    std::string json;
+
+    // Tempo/alocacoes por estagio e memoria por veiculo/par
+    TickStats stats;
+    if (!stats_file.empty()) {
+        if (stats.open_csv(stats_file)) {
+            std::cout << "[SIM] Writing tick stats to " << stats_file << "\n";
+        } else {
+            std::cerr << "[SIM] Could not open stats file " << stats_file << "\n";
+        }
+    }
+
+    if (alloc_counter::enabled()) {
+        std::cout << "[SIM] Heap allocation counter enabled\n";
+    }
+
+    // Deadlines absolutos: o tick n comeca em start + n * 1s
+    TickClock clock(std::chrono::milliseconds(1000), std::chrono::microseconds(spin_us));
+    clock.start();
+
+    // Custo do tick contra o periodo: degrada pares LOW/longe antes de atrasar
+    OverloadGovernor governor(1000000);
 
     while (running) {
-        auto tick_start = std::chrono::steady_clock::now();
+        stats.begin_tick();
+
+        // Um timestamp por tick, compartilhado por pacotes e alertas
+        int64_t tick_ts = clock.tick_timestamp_ms();
+        DegradationLevel level = governor.level();
+        sim.set_coarse_stride(governor.coarse_stride());
 
         // 1. Update da frota (movimentacao, navegacao, ciclo)
-        fleet.update(DELTA_TIME);
+        stats.begin_stage(TickStage::UPDATE);
+        sim.update(DELTA_TIME);
+        stats.end_stage(TickStage::UPDATE);
+
+        // 1b. GNSS: fix com erro + filtro (o detector usa a estimativa)
+        stats.begin_stage(TickStage::SENSE);
+        fleet.sense(DELTA_TIME);
+        stats.end_stage(TickStage::SENSE);
 
         // 2. Coleta de telemetria
-        auto packets = fleet.collect_telemetry();
+        stats.begin_stage(TickStage::COLLECT);
+        fleet.collect_telemetry(packets, tick_ts, tick, governor.stationary_interval());
+        stats.end_stage(TickStage::COLLECT);
 
         // 3. Deteccao de colisao
-        auto alerts = collision.check_all(fleet.vehicles());
+        stats.begin_stage(TickStage::DETECT);
+        sim.check_all(tick * DELTA_TIME, tick_ts, alerts);
+        heatmap.record(alerts, tick * DELTA_TIME);
+        stats.end_stage(TickStage::DETECT);
+
+        // Tile do mapa de calor e KPIs em baixa frequencia (vao junto do batch)
+        bool publish_heatmap = heatmap.publish_due(tick * DELTA_TIME);
+        if (publish_heatmap) {
+            heatmap.publish(tick * DELTA_TIME, tick_ts, heatmap_tile);
+        }
+        bool publish_kpi = fleet.kpi()->publish_due(fleet.clock());
+        if (publish_kpi) {
+            fleet.kpi()->publish(fleet.clock(), tick_ts, kpi_report);
+        }
 
         // 4. Output
         if (local_mode) {
             // Modo local: imprime no console
+            stats.begin_stage(TickStage::OUTPUT);
             print_telemetry(packets);
             print_alerts(alerts);
+            if (publish_heatmap) {
+                std::cout << "  [HEATMAP] " << heatmap.events_recorded() << " events, "
+                          << heatmap_tile.events << " decayed in grid, "
+                          << heatmap_tile.outside << " outside\n";
+            }
+            if (publish_kpi) {
+                print_kpi(kpi_report);
+            }
+            stats.end_stage(TickStage::OUTPUT);
         } else {
             // Modo rede: serializa e envia via TCP
-            std::string json = JsonSerializer::serialize_batch(packets, alerts);
-
+            stats.begin_stage(TickStage::SERIALIZE);
+            // sent_at e o instante real do envio (latencia no backend)
+            int64_t sent_at = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+            JsonSerializer::serialize_batch(packets, alerts, tick, sent_at, json,
+                                            publish_heatmap ? &heatmap_tile : nullptr,
+                                            publish_kpi ? &kpi_report : nullptr);
+            stats.end_stage(TickStage::SERIALIZE);
+
+            stats.begin_stage(TickStage::OUTPUT);
             if (tcp->is_connected()) {
                 if (!tcp->send_message(json)) {
                     std::cerr << "[SIM] Send failed at tick " << tick << "\n";
@@ -226,17 +399,29 @@ int main(int argc, char* argv[]) {
                     reconnect_counter = 0;
                 }
             }
+            stats.end_stage(TickStage::OUTPUT);
         }
 
-        tick++;
+        stats.end_tick(tick, clock.last_wake_late_us(), static_cast<int>(level),
+                       MemoryReport::from(fleet.footprint(), sim.detector_footprint()));
 
-        // Esperar ate completar 1 segundo
-        auto tick_end = std::chrono::steady_clock::now();
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(tick_end - tick_start);
-        auto sleep_time = std::chrono::milliseconds(1000) - elapsed;
-        if (sleep_time.count() > 0) {
-            std::this_thread::sleep_for(sleep_time);
+        governor.observe(stats.tick_micros());
+        if (governor.level() != level) {
+            std::cout << "[GOV] Tick " << tick << ": " << OverloadGovernor::level_name(level)
+                      << " -> " << OverloadGovernor::level_name(governor.level())
+                      << " (tick cost " << stats.tick_micros() << "us, "
+                      << sim.pairs_coarse() << " coarse pairs, "
+                      << (fleet.vehicle_count() - packets.size()) << " deferred packets)\n";
         }
+        if (tick % STATS_REPORT_INTERVAL == 0) {
+            stats.print_summary(std::cout, tick);
+            clock.print_jitter(std::cout);
+        }
+
+        tick++;
+
+        // Dorme ate o deadline do proximo tick (atraso nao acumula)
+        clock.wait_next();
     }
 
     std::cout << "\n[SIM] Shutting down after " << tick << " ticks.\n";
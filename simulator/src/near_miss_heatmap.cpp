@@ -0,0 +1,167 @@
+#include "near_miss_heatmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mineguard {
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double EARTH_RADIUS = 6371000.0;
+
+HeatmapConfig HeatmapConfig::create_default() {
+    return HeatmapConfig{
+        .cell_size = 10.0,
+        .margin = 200.0,
+        .half_life = 3600.0,
+        .publish_interval = 30.0
+    };
+}
+
+// ============================================================
+// Grade: plano local com origem no canto sudoeste (mesma
+// aproximacao equiretangular do detector)
+// ============================================================
+
+NearMissHeatmap::NearMissHeatmap(const HeatmapConfig& config,
+                                 const Position& south_west, const Position& north_east)
+    : config_(config)
+    , m_per_deg_lat_(EARTH_RADIUS * DEG_TO_RAD)
+    , m_per_deg_lon_(0.0)
+    , cols_(0)
+    , rows_(0)
+    , weight_origin_(0.0)
+    , events_(0.0)
+    , next_publish_(0.0)
+    , events_recorded_(0)
+    , outside_(0)
+{
+    // Escala de longitude na latitude da origem: quem le o tile so
+    // precisa da origem pra refazer a conversao
+    double origin_lat = south_west.latitude - config_.margin / m_per_deg_lat_;
+    m_per_deg_lon_ = m_per_deg_lat_ * std::cos(origin_lat * DEG_TO_RAD);
+
+    origin_ = Position{
+        origin_lat,
+        south_west.longitude - config_.margin / m_per_deg_lon_,
+        0.0
+    };
+
+    double width = (north_east.longitude - south_west.longitude) * m_per_deg_lon_ + 2.0 * config_.margin;
+    double height = (north_east.latitude - south_west.latitude) * m_per_deg_lat_ + 2.0 * config_.margin;
+    cols_ = static_cast<size_t>(std::ceil(std::max(width, config_.cell_size) / config_.cell_size));
+    rows_ = static_cast<size_t>(std::ceil(std::max(height, config_.cell_size) / config_.cell_size));
+
+    for (auto& layer : cells_) {
+        layer.assign(cols_ * rows_, 0.0f);
+    }
+}
+
+size_t NearMissHeatmap::cell_of(const Position& p) const {
+    double x = (p.longitude - origin_.longitude) * m_per_deg_lon_ / config_.cell_size;
+    double y = (p.latitude - origin_.latitude) * m_per_deg_lat_ / config_.cell_size;
+    if (!(x >= 0.0 && y >= 0.0)) return SIZE_MAX;
+
+    size_t col = static_cast<size_t>(x);
+    size_t row = static_cast<size_t>(y);
+    if (col >= cols_ || row >= rows_) return SIZE_MAX;
+    return row * cols_ + col;
+}
+
+// ============================================================
+// Eventos do tick
+//
+// Um episodio e a sequencia de ticks em que o par alerta sem
+// interrupcao. O comeco soma nas camadas da prioridade e do tipo;
+// cada subida acima da maior prioridade do episodio soma so na
+// camada da prioridade nova. Assim a camada CRITICAL conta os
+// episodios que chegaram a CRITICAL, e as de tipo contam episodios.
+// ============================================================
+
+void NearMissHeatmap::record(const std::vector<CollisionAlert>& alerts, double now) {
+    double weight = std::exp2((now - weight_origin_) / config_.half_life);
+    if (weight > RENORMALIZE_WEIGHT) {
+        renormalize(now);
+        weight = 1.0;
+    }
+    float w = static_cast<float>(weight);
+
+    for (const CollisionAlert& a : alerts) {
+        if (a.priority == AlertPriority::NONE) continue;
+
+        AlertPriority peak = episodes_.observe(a);
+        if (a.priority <= peak) continue;
+
+        events_recorded_++;
+        size_t cell = cell_of(a.cpa);
+        if (cell == SIZE_MAX) {
+            outside_++;
+            continue;
+        }
+
+        cells_[static_cast<size_t>(a.priority) - 1][cell] += w;
+        events_ += weight;
+        if (peak == AlertPriority::NONE) {
+            cells_[HEATMAP_PRIORITY_LAYERS + static_cast<size_t>(a.type)][cell] += w;
+        }
+    }
+    episodes_.end_tick();
+}
+
+void NearMissHeatmap::renormalize(double now) {
+    float factor = static_cast<float>(std::exp2(-(now - weight_origin_) / config_.half_life));
+    for (auto& layer : cells_) {
+        for (float& c : layer) c *= factor;
+    }
+    events_ *= factor;
+    weight_origin_ = now;
+}
+
+// ============================================================
+// Publicacao: quantiza o valor decaido e codifica cada camada
+// em run-length esparso (grade quase toda zerada)
+// ============================================================
+
+void NearMissHeatmap::publish(double now, int64_t timestamp, HeatmapTile& tile) {
+    double decay = std::exp2(-(now - weight_origin_) / config_.half_life);
+    float factor = static_cast<float>(decay * TILE_SCALE);
+
+    tile.timestamp = timestamp;
+    tile.origin = origin_;
+    tile.cell_size = config_.cell_size;
+    tile.cols = cols_;
+    tile.rows = rows_;
+    tile.half_life = config_.half_life;
+    tile.scale = TILE_SCALE;
+    tile.events = events_ * decay;
+    tile.outside = outside_;
+
+    const size_t n = cols_ * rows_;
+    for (size_t l = 0; l < HEATMAP_LAYERS; l++) {
+        const float* c = cells_[l].data();
+        std::vector<uint32_t>& out = tile.layers[l];
+        out.clear();
+
+        size_t zeros = 0;
+        size_t run_header = SIZE_MAX;    // posicao do n do run aberto
+        for (size_t i = 0; i < n; i++) {
+            uint32_t q = static_cast<uint32_t>(std::lround(c[i] * factor));
+            if (q == 0) {
+                zeros++;
+                run_header = SIZE_MAX;
+                continue;
+            }
+            if (run_header == SIZE_MAX) {
+                out.push_back(static_cast<uint32_t>(zeros));
+                out.push_back(0);
+                run_header = out.size() - 1;
+                zeros = 0;
+            }
+            out[run_header]++;
+            out.push_back(q);
+        }
+    }
+
+    next_publish_ = now + config_.publish_interval;
+}
+
+} // namespace mineguard
@@ -0,0 +1,65 @@
+#include "overload_governor.hpp"
+
+namespace mineguard {
+
+// ============================================================
+// Governador de sobrecarga
+// ============================================================
+
+OverloadGovernor::OverloadGovernor(int64_t budget_us)
+    : budget_us_(budget_us)
+    , level_(DegradationLevel::NORMAL)
+    , calm_ticks_(0)
+    , transitions_(0)
+{
+}
+
+void OverloadGovernor::observe(int64_t tick_cost_us) {
+    int current = static_cast<int>(level_);
+    int max_level = static_cast<int>(DegradationLevel::DEFER_STATIONARY);
+
+    if (tick_cost_us > budget_us_ * RAISE_FRACTION) {
+        calm_ticks_ = 0;
+        if (current < max_level) {
+            level_ = static_cast<DegradationLevel>(current + 1);
+            transitions_++;
+        }
+        return;
+    }
+
+    if (tick_cost_us < budget_us_ * RELAX_FRACTION) {
+        if (current > 0 && ++calm_ticks_ >= RELAX_TICKS) {
+            level_ = static_cast<DegradationLevel>(current - 1);
+            calm_ticks_ = 0;
+            transitions_++;
+        }
+        return;
+    }
+
+    // Entre os limites: segura o nivel atual
+    calm_ticks_ = 0;
+}
+
+size_t OverloadGovernor::coarse_stride() const {
+    switch (level_) {
+        case DegradationLevel::NORMAL:      return 1;
+        case DegradationLevel::COARSE_FAR:  return 2;
+        default:                            return 4;
+    }
+}
+
+uint32_t OverloadGovernor::stationary_interval() const {
+    return level_ == DegradationLevel::DEFER_STATIONARY ? STATIONARY_INTERVAL : 1;
+}
+
+const char* OverloadGovernor::level_name(DegradationLevel level) {
+    switch (level) {
+        case DegradationLevel::NORMAL:           return "NORMAL";
+        case DegradationLevel::COARSE_FAR:       return "COARSE_FAR";
+        case DegradationLevel::COARSER_FAR:      return "COARSER_FAR";
+        case DegradationLevel::DEFER_STATIONARY: return "DEFER_STATIONARY";
+        default: return "UNKNOWN";
+    }
+}
+
+} // namespace mineguard
@@ -0,0 +1,220 @@
+#include "production_kpi.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mineguard {
+
+KpiConfig KpiConfig::create_default() {
+    return KpiConfig{
+        .short_window = 60.0,
+        .medium_window = 900.0,
+        .shift_window = 12.0 * 3600.0,
+        .buckets = 30,
+        .publish_interval = 10.0
+    };
+}
+
+void KpiTotals::add(const KpiTotals& other) {
+    cycles += other.cycles;
+    cycle_seconds += other.cycle_seconds;
+    tonnes += other.tonnes;
+    queues += other.queues;
+    queue_seconds += other.queue_seconds;
+    fuel_liters += other.fuel_liters;
+}
+
+void KpiTotals::subtract(const KpiTotals& other) {
+    cycles -= other.cycles;
+    cycle_seconds -= other.cycle_seconds;
+    tonnes -= other.tonnes;
+    queues -= other.queues;
+    queue_seconds -= other.queue_seconds;
+    fuel_liters -= other.fuel_liters;
+}
+
+// ============================================================
+// Janela deslizante: anel de baldes + soma corrente
+//
+// O balde k cobre [k * largura, (k + 1) * largura). Avancar ate um
+// balde novo tira da soma os baldes que sairam e os zera; o custo e
+// proporcional aos baldes expirados, nunca ao numero de eventos.
+// ============================================================
+
+RollingWindow::RollingWindow(double length, size_t buckets)
+    : buckets_(std::max<size_t>(buckets, 1))
+    , width_(length / static_cast<double>(std::max<size_t>(buckets, 1)))
+    , head_(0)
+{
+}
+
+void RollingWindow::advance(double now) {
+    int64_t target = static_cast<int64_t>(std::floor(now / width_));
+    if (target <= head_) return;
+
+    const int64_t n = static_cast<int64_t>(buckets_.size());
+    if (target - head_ >= n) {
+        std::fill(buckets_.begin(), buckets_.end(), KpiTotals{});
+        sum_ = KpiTotals{};
+    } else {
+        for (int64_t k = head_ + 1; k <= target; k++) {
+            KpiTotals& expired = buckets_[static_cast<size_t>(k % n)];
+            sum_.subtract(expired);
+            expired = KpiTotals{};
+        }
+    }
+    head_ = target;
+}
+
+void RollingWindow::add(const KpiTotals& delta, double now) {
+    advance(now);
+    buckets_[static_cast<size_t>(head_ % static_cast<int64_t>(buckets_.size()))].add(delta);
+    sum_.add(delta);
+}
+
+void RollingWindow::merge(const RollingWindow& other) {
+    for (size_t i = 0; i < buckets_.size() && i < other.buckets_.size(); i++) {
+        buckets_[i].add(other.buckets_[i]);
+    }
+    sum_.add(other.sum_);
+}
+
+// ============================================================
+// Eventos do ciclo
+// ============================================================
+
+ProductionKpi::ProductionKpi(const KpiConfig& config, double start)
+    : config_(config)
+    , start_(start)
+    , lengths_{config.short_window, config.medium_window, config.shift_window}
+    , next_publish_(start)
+{
+    reset_windows(retired_, start);
+}
+
+void ProductionKpi::reset_windows(RollingWindow (&windows)[KPI_WINDOWS], double now) const {
+    for (size_t w = 0; w < KPI_WINDOWS; w++) {
+        windows[w] = RollingWindow(lengths_[w], config_.buckets);
+        windows[w].advance(now);
+    }
+}
+
+double ProductionKpi::fuel_liters(const Vehicle& vehicle) {
+    return vehicle.telemetry().fuel_level / 100.0 * vehicle.spec().fuel_capacity;
+}
+
+void ProductionKpi::on_spawn(uint32_t slot, const Vehicle& vehicle, double now) {
+    if (slot >= slots_.size()) slots_.resize(slot + 1);
+
+    VehicleKpi& k = slots_[slot];
+    k.tracked = vehicle.type() == VehicleType::HAUL_TRUCK;
+    if (!k.tracked) return;
+
+    k.id = vehicle.id();
+    k.last_fuel = fuel_liters(vehicle);
+    k.last_dump = -1.0;
+    k.arrival = -1.0;
+    reset_windows(k.windows, now);
+}
+
+void ProductionKpi::on_despawn(uint32_t slot, double now) {
+    if (slot >= slots_.size() || !slots_[slot].tracked) return;
+
+    VehicleKpi& k = slots_[slot];
+    for (size_t w = 0; w < KPI_WINDOWS; w++) {
+        k.windows[w].advance(now);
+        retired_[w].advance(now);
+        retired_[w].merge(k.windows[w]);
+    }
+    k.tracked = false;
+}
+
+void ProductionKpi::record_arrival(uint32_t slot, double now) {
+    if (slot >= slots_.size() || !slots_[slot].tracked) return;
+    slots_[slot].arrival = now;
+}
+
+void ProductionKpi::record_transition(uint32_t slot, const Vehicle& vehicle,
+                                      CycleState from, CycleState to, double now) {
+    if (slot >= slots_.size() || !slots_[slot].tracked) return;
+    VehicleKpi& k = slots_[slot];
+
+    // Combustivel desde a ultima transicao fica no balde deste evento
+    KpiTotals delta;
+    double fuel = fuel_liters(vehicle);
+    delta.fuel_liters = std::max(0.0, k.last_fuel - fuel);
+    k.last_fuel = fuel;
+
+    if (from == CycleState::DUMPING && to == CycleState::RETURNING) {
+        // Carga entregue: um ciclo fecha no fim de cada descarga
+        delta.tonnes = vehicle.spec().max_payload;
+        if (k.last_dump >= 0.0) {
+            delta.cycles = 1.0;
+            delta.cycle_seconds = now - k.last_dump;
+        }
+        k.last_dump = now;
+    }
+    else if (from == CycleState::RETURNING && to == CycleState::LOADING) {
+        // Fila no pit: da chegada ao inicio da carga
+        if (k.arrival >= 0.0) {
+            delta.queues = 1.0;
+            delta.queue_seconds = now - k.arrival;
+        }
+    }
+    k.arrival = -1.0;
+
+    for (RollingWindow& window : k.windows) {
+        window.add(delta, now);
+    }
+}
+
+// ============================================================
+// Publicacao: janelas avancadas ate agora, valores derivados
+// ============================================================
+
+KpiValues ProductionKpi::values(const KpiTotals& t, double window, double now) const {
+    // Comeco da coleta: a janela ainda nao esta cheia
+    double covered = std::min(window, now - start_);
+
+    return KpiValues{
+        .cycles = static_cast<uint32_t>(std::lround(t.cycles)),
+        .cycle_time = t.cycles >= 0.5 ? t.cycle_seconds / t.cycles : NAN,
+        .tonnes = t.tonnes,
+        .tonnes_per_hour = covered > 0.0 ? t.tonnes * 3600.0 / covered : NAN,
+        .queue_time = t.queues >= 0.5 ? t.queue_seconds / t.queues : NAN,
+        .fuel_per_tonne = t.tonnes > 0.0 ? t.fuel_liters / t.tonnes : NAN
+    };
+}
+
+void ProductionKpi::publish(double now, int64_t timestamp, KpiReport& report) {
+    report.timestamp = timestamp;
+    report.vehicle_ids.clear();
+    report.vehicles.clear();
+
+    KpiTotals fleet[KPI_WINDOWS];
+    for (size_t w = 0; w < KPI_WINDOWS; w++) {
+        retired_[w].advance(now);
+        fleet[w] = retired_[w].totals();
+    }
+
+    for (VehicleKpi& k : slots_) {
+        if (!k.tracked) continue;
+
+        report.vehicle_ids.push_back(k.id);
+        for (size_t w = 0; w < KPI_WINDOWS; w++) {
+            k.windows[w].advance(now);
+            const KpiTotals& t = k.windows[w].totals();
+            fleet[w].add(t);
+            report.vehicles.push_back(values(t, lengths_[w], now));
+        }
+    }
+
+    for (size_t w = 0; w < KPI_WINDOWS; w++) {
+        report.windows[w] = lengths_[w];
+        report.fleet[w] = values(fleet[w], lengths_[w], now);
+    }
+
+    next_publish_ = now + config_.publish_interval;
+}
+
+} // namespace mineguard
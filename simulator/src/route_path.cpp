@@ -0,0 +1,124 @@
+#include "route_path.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace mineguard {
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double EARTH_RADIUS = 6371000.0;
+
+// ============================================================
+// Montagem das tabelas (startup)
+// ============================================================
+
+RoutePath RoutePath::build(const std::vector<Position>& waypoints, bool closed) {
+    RoutePath path;
+    path.closed = closed && waypoints.size() > 2;
+    path.points = waypoints;
+    if (path.closed) {
+        path.points.push_back(waypoints.front());
+    }
+
+    // Escala do plano local pela latitude do primeiro waypoint.
+    // A mina cobre poucos km, o erro da aproximacao e desprezivel.
+    double lat0 = waypoints.empty() ? 0.0 : waypoints.front().latitude;
+    path.m_per_deg_lat = EARTH_RADIUS * DEG_TO_RAD;
+    path.m_per_deg_lon = EARTH_RADIUS * DEG_TO_RAD * std::cos(lat0 * DEG_TO_RAD);
+
+    path.cumulative.reserve(path.points.size());
+    path.segment_length.reserve(path.points.size());
+
+    double total = 0.0;
+    for (size_t i = 0; i < path.points.size(); i++) {
+        path.cumulative.push_back(total);
+        if (i + 1 < path.points.size()) {
+            double len = path.distance(path.points[i], path.points[i + 1]);
+            path.segment_length.push_back(len);
+            total += len;
+        }
+    }
+
+    return path;
+}
+
+// ============================================================
+// Posicao por comprimento de arco: busca binaria + lerp
+// ============================================================
+
+Position RoutePath::position_at(double s) const {
+    if (points.empty()) return Position{};
+    if (points.size() == 1) return points.front();
+
+    double total = length();
+    if (closed && total > 0.0) {
+        s = std::fmod(s, total);
+        if (s < 0) s += total;
+    }
+    if (s <= 0.0) return points.front();
+    if (s >= total) return points.back();
+
+    // Primeiro cumulative > s; o segmento comeca no anterior
+    auto it = std::upper_bound(cumulative.begin(), cumulative.end(), s);
+    size_t seg = static_cast<size_t>(it - cumulative.begin()) - 1;
+
+    const Position& a = points[seg];
+    const Position& b = points[seg + 1];
+    double len = segment_length[seg];
+    double f = (len > 0.0) ? (s - cumulative[seg]) / len : 0.0;
+
+    return Position{
+        a.latitude + (b.latitude - a.latitude) * f,
+        a.longitude + (b.longitude - a.longitude) * f,
+        a.altitude + (b.altitude - a.altitude) * f
+    };
+}
+
+// ============================================================
+// Projecao no segmento atual (arco + desvio lateral)
+// ============================================================
+
+void RoutePath::project(const Position& p, size_t next_index, double& s, double& offset) const {
+    if (points.empty()) {
+        s = 0.0;
+        offset = 0.0;
+        return;
+    }
+    if (next_index >= points.size()) next_index = points.size() - 1;
+
+    // Indo pro inicio de rota fechada = segmento de fechamento
+    if (next_index == 0 && closed) next_index = points.size() - 1;
+
+    if (next_index == 0) {
+        s = 0.0;
+        offset = distance(p, points.front());
+        return;
+    }
+
+    size_t seg = next_index - 1;
+    const Position& a = points[seg];
+    const Position& b = points[next_index];
+
+    double ax = (b.longitude - a.longitude) * m_per_deg_lon;
+    double ay = (b.latitude - a.latitude) * m_per_deg_lat;
+    double px = (p.longitude - a.longitude) * m_per_deg_lon;
+    double py = (p.latitude - a.latitude) * m_per_deg_lat;
+
+    double len = segment_length[seg];
+    double f = (len > 0.0) ? (px * ax + py * ay) / (len * len) : 0.0;
+    if (f < 0.0) f = 0.0;
+    if (f > 1.0) f = 1.0;
+
+    double ex = px - ax * f;
+    double ey = py - ay * f;
+
+    s = cumulative[seg] + f * len;
+    offset = std::sqrt(ex * ex + ey * ey);
+}
+
+double RoutePath::distance(const Position& a, const Position& b) const {
+    double dx = (b.longitude - a.longitude) * m_per_deg_lon;
+    double dy = (b.latitude - a.latitude) * m_per_deg_lat;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+} // namespace mineguard
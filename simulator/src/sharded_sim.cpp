@@ -0,0 +1,319 @@
+#include "sharded_sim.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace mineguard {
+
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+static constexpr double EARTH_RADIUS = 6371000.0;
+
+// Folga sobre MAX_PAIR_DISTANCE: o detector projeta no proprio plano
+// local, com escala um pouco diferente da usada pelas faixas
+static constexpr double HALO_MARGIN = 5.0;   // metros
+
+// ============================================================
+// Faixas a partir da area dos waypoints
+// ============================================================
+
+ShardedSimulation::ShardedSimulation(FleetManager& fleet, size_t shard_count)
+    : fleet_(fleet)
+    , origin_{0.0, 0.0, 0.0}
+    , m_per_deg_lat_(EARTH_RADIUS * DEG_TO_RAD)
+    , m_per_deg_lon_(0.0)
+    , axis_east_(true)
+    , strip_width_(1.0)
+    , migrations_(0)
+    , delta_time_(0.0)
+    , now_(0.0)
+    , timestamp_(0)
+    , phase_(Phase::UPDATE)
+    , epoch_(0)
+    , pending_(0)
+    , stopping_(false)
+{
+    if (shard_count == 0) shard_count = 1;
+
+    double min_lat = std::numeric_limits<double>::max();
+    double max_lat = std::numeric_limits<double>::lowest();
+    double min_lon = std::numeric_limits<double>::max();
+    double max_lon = std::numeric_limits<double>::lowest();
+    for (const auto& entry : fleet_.mine().waypoints) {
+        min_lat = std::min(min_lat, entry.second.latitude);
+        max_lat = std::max(max_lat, entry.second.latitude);
+        min_lon = std::min(min_lon, entry.second.longitude);
+        max_lon = std::max(max_lon, entry.second.longitude);
+    }
+    if (fleet_.mine().waypoints.empty()) {
+        min_lat = max_lat = min_lon = max_lon = 0.0;
+    }
+
+    origin_ = Position{min_lat, min_lon, 0.0};
+    m_per_deg_lon_ = m_per_deg_lat_ * std::cos(0.5 * (min_lat + max_lat) * DEG_TO_RAD);
+
+    // Faixas cortam o eixo mais comprido da mina
+    double extent_east = (max_lon - min_lon) * m_per_deg_lon_;
+    double extent_north = (max_lat - min_lat) * m_per_deg_lat_;
+    axis_east_ = extent_east >= extent_north;
+    double extent = std::max(extent_east, extent_north);
+    strip_width_ = std::max(extent / shard_count, 1.0);
+
+    shards_.resize(shard_count);
+    for (size_t s = 0; s < shard_count; s++) {
+        shards_[s].owned = 0;
+        shards_[s].upper = (s + 1) * strip_width_;
+        shards_[s].detector.set_conflict_zones(&fleet_.conflict_zones());
+    }
+
+    for (size_t s = 1; s < shard_count; s++) {
+        workers_.emplace_back(&ShardedSimulation::worker_loop, this, s);
+    }
+}
+
+ShardedSimulation::~ShardedSimulation() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+double ShardedSimulation::axis_coordinate(const Position& p) const {
+    return axis_east_
+        ? (p.longitude - origin_.longitude) * m_per_deg_lon_
+        : (p.latitude - origin_.latitude) * m_per_deg_lat_;
+}
+
+size_t ShardedSimulation::shard_for(double u) const {
+    if (u <= 0.0) return 0;
+    size_t s = static_cast<size_t>(u / strip_width_);
+    return std::min(s, shards_.size() - 1);
+}
+
+// ============================================================
+// Tick: update e colisao por shard
+// ============================================================
+
+void ShardedSimulation::update(double delta_time) {
+    delta_time_ = delta_time;
+    fleet_.advance_clock(delta_time);
+    assign();
+    run_parallel(Phase::UPDATE);
+}
+
+void ShardedSimulation::check_all(double now, int64_t timestamp, std::vector<CollisionAlert>& out) {
+    now_ = now;
+    timestamp_ = timestamp;
+
+    // Posicoes mudaram no update: quem cruzou a borda migra agora
+    assign();
+    build_halos();
+    run_parallel(Phase::DETECT);
+
+    out.clear();
+    for (const auto& shard : shards_) {
+        out.insert(out.end(), shard.alerts.begin(), shard.alerts.end());
+    }
+}
+
+// ============================================================
+// Migracao e halo
+//
+// assign refaz as listas dos shards a partir da lista compacta da
+// frota (cobre spawn/despawn sem aviso). As listas mantem a
+// capacidade; com 1 shard a ordem e a mesma de fleet.vehicles().
+// ============================================================
+
+void ShardedSimulation::assign() {
+    const auto& vehicles = fleet_.vehicles();
+    const auto& slots = fleet_.active_slots();
+
+    for (auto& shard : shards_) {
+        shard.slots.clear();
+        shard.vehicles.clear();
+    }
+    coordinate_.resize(vehicles.size());
+    migrations_ = 0;
+
+    for (size_t k = 0; k < vehicles.size(); k++) {
+        double u = axis_coordinate(vehicles[k]->position());
+        uint32_t s = static_cast<uint32_t>(shard_for(u));
+        coordinate_[k] = u;
+
+        // So conta migracao se o slot ainda e do mesmo veiculo
+        uint32_t slot = slots[k];
+        if (slot >= shard_of_slot_.size()) {
+            shard_of_slot_.resize(slot + 1, NO_SHARD);
+            generation_of_slot_.resize(slot + 1, 0);
+        }
+        uint32_t generation = vehicles[k]->handle().generation;
+        if (shard_of_slot_[slot] != NO_SHARD && shard_of_slot_[slot] != s &&
+            generation_of_slot_[slot] == generation) {
+            migrations_++;
+        }
+        shard_of_slot_[slot] = s;
+        generation_of_slot_[slot] = generation;
+
+        shards_[s].slots.push_back(slot);
+        shards_[s].vehicles.push_back(vehicles[k]);
+    }
+
+    for (auto& shard : shards_) {
+        shard.owned = shard.vehicles.size();
+    }
+}
+
+void ShardedSimulation::build_halos() {
+    const auto& vehicles = fleet_.vehicles();
+    const auto& slots = fleet_.active_slots();
+    const double reach = CollisionDetector::MAX_PAIR_DISTANCE + HALO_MARGIN;
+
+    // Halo so pra shards de indice menor: o par entre shards e
+    // checado no shard mais baixo dos dois
+    for (size_t k = 0; k < vehicles.size(); k++) {
+        size_t t = shard_of_slot_[slots[k]];
+        for (size_t s = t; s-- > 0;) {
+            if (coordinate_[k] - shards_[s].upper > reach) break;
+            shards_[s].vehicles.push_back(vehicles[k]);
+        }
+    }
+}
+
+size_t ShardedSimulation::halo_vehicles() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.vehicles.size() - shard.owned;
+    }
+    return total;
+}
+
+MemoryFootprint ShardedSimulation::detector_footprint() const {
+    MemoryFootprint total{
+        .vehicles = 0,
+        .per_vehicle_bytes = 0,
+        .pair_entries = 0,
+        .pair_bytes = 0,
+        .shared_bytes = 0
+    };
+
+    for (const auto& shard : shards_) {
+        MemoryFootprint fp = shard.detector.footprint();
+        total.vehicles += fp.vehicles;
+        total.per_vehicle_bytes += fp.per_vehicle_bytes;
+        total.pair_entries += fp.pair_entries;
+        total.pair_bytes += fp.pair_bytes;
+        total.shared_bytes += fp.shared_bytes + footprint::heap_bytes(shard.slots) +
+                              footprint::heap_bytes(shard.vehicles) +
+                              footprint::heap_bytes(shard.alerts);
+    }
+    total.shared_bytes += footprint::heap_bytes(shard_of_slot_) +
+                          footprint::heap_bytes(generation_of_slot_) +
+                          footprint::heap_bytes(coordinate_);
+    return total;
+}
+
+size_t ShardedSimulation::pairs_deferred() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.detector.pairs_deferred();
+    }
+    return total;
+}
+
+void ShardedSimulation::set_coarse_stride(size_t stride) {
+    for (auto& shard : shards_) {
+        shard.detector.set_coarse_stride(stride);
+    }
+}
+
+size_t ShardedSimulation::pairs_coarse() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.detector.pairs_coarse();
+    }
+    return total;
+}
+
+void ShardedSimulation::set_risk_mode(bool enabled) {
+    for (auto& shard : shards_) {
+        shard.detector.set_risk_mode(enabled);
+    }
+}
+
+size_t ShardedSimulation::pairs_monte_carlo() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.detector.pairs_monte_carlo();
+    }
+    return total;
+}
+
+// ============================================================
+// Workers
+//
+// Uma fase por vez (update ou colisao): a thread que chama roda o
+// shard 0 e espera os demais. Entre as fases so ela mexe nas listas.
+// ============================================================
+
+void ShardedSimulation::run_parallel(Phase phase) {
+    if (workers_.empty()) {
+        run_shard(0, phase);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        phase_ = phase;
+        pending_ = workers_.size();
+        epoch_++;
+    }
+    start_cv_.notify_all();
+
+    run_shard(0, phase);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_ == 0; });
+}
+
+void ShardedSimulation::run_shard(size_t index, Phase phase) {
+    Shard& shard = shards_[index];
+
+    switch (phase) {
+        case Phase::UPDATE:
+            for (uint32_t slot : shard.slots) {
+                fleet_.update_slot(slot, delta_time_);
+            }
+            break;
+
+        case Phase::DETECT:
+            shard.detector.check_all(shard.vehicles, shard.owned, now_, timestamp_, shard.alerts);
+            break;
+    }
+}
+
+void ShardedSimulation::worker_loop(size_t index) {
+    uint64_t seen = 0;
+
+    while (true) {
+        Phase phase;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&] { return stopping_ || epoch_ != seen; });
+            if (stopping_) return;
+            seen = epoch_;
+            phase = phase_;
+        }
+
+        run_shard(index, phase);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) done_cv_.notify_one();
+        }
+    }
+}
+
+} // namespace mineguard
@@ -1,18 +1,25 @@
 #include "tcp_client.hpp"
+#include "json_serializer.hpp"
 
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
+#include <poll.h>
 #include <unistd.h>
 
 namespace mineguard {
 
-TcpClient::TcpClient(const std::string& host, uint16_t port)
+TcpClient::TcpClient(const std::string& host, uint16_t port, const std::string& source_id)
     : host_(host)
     , port_(port)
+    , source_id_(source_id)
+    , session_id_(0)
+    , ack_enabled_(false)
     , socket_fd_(-1)
     , connected_(false)
 {
@@ -60,9 +67,53 @@ bool TcpClient::connect_to_server() {
         return false;
     }
 
+    // Frames pequenos e sensiveis a latencia: sem Nagle
+    int no_delay = 1;
+    setsockopt(socket_fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
     connected_ = true;
     std::cout << "[TCP] Connected to " << host_ << ":" << port_ << std::endl;
-    return true;
+
+    if (!source_id_.empty()) {
+        perform_handshake();
+    }
+
+    return connected_;
+}
+
+// ============================================================
+// Handshake da sessao
+//
+// Cliente: {"type":"hello","protocol":1,"source_id":"..."}
+// Backend: {"type":"welcome","session_id":N,"source_id":"..."}
+// Backend antigo nao responde: segue sem session_id.
+// ============================================================
+
+void TcpClient::perform_handshake() {
+    session_id_ = 0;
+
+    if (!send_message(JsonSerializer::serialize_hello(source_id_, ack_enabled_))) {
+        return;
+    }
+
+    std::string reply;
+    if (!receive_message(reply, HANDSHAKE_TIMEOUT_MS)) {
+        if (connected_) {
+            std::cerr << "[TCP] No handshake reply, continuing without session" << std::endl;
+        }
+        return;
+    }
+
+    const char* key = "\"session_id\":";
+    size_t pos = reply.find(key);
+    if (reply.find("\"welcome\"") == std::string::npos || pos == std::string::npos) {
+        std::cerr << "[TCP] Unexpected handshake reply: " << reply << std::endl;
+        return;
+    }
+
+    session_id_ = std::strtoull(reply.c_str() + pos + std::strlen(key), nullptr, 10);
+    std::cout << "[TCP] Session " << session_id_ << " opened for source '"
+              << source_id_ << "'" << std::endl;
 }
 
 // ============================================================
@@ -98,20 +149,87 @@ bool TcpClient::send_message(const std::string& json) {
     uint32_t length = static_cast<uint32_t>(json.size());
     uint32_t length_be = htonl(length); // big-endian
 
-    // Enviar header (4 bytes com o tamanho)
-    if (!send_bytes(&length_be, sizeof(length_be))) {
-        std::cerr << "[TCP] Failed to send length header, disconnecting" << std::endl;
+    // Header e payload num send so: dois writes pequenos seguidos
+    // esbarram no delayed ACK do outro lado
+    frame_buffer_.resize(sizeof(length_be) + json.size());
+    std::memcpy(&frame_buffer_[0], &length_be, sizeof(length_be));
+    std::memcpy(&frame_buffer_[sizeof(length_be)], json.data(), json.size());
+
+    if (!send_bytes(frame_buffer_.data(), frame_buffer_.size())) {
+        std::cerr << "[TCP] Failed to send frame, disconnecting" << std::endl;
+        disconnect();
+        return false;
+    }
+
+    return true;
+}
+
+// ============================================================
+// Receber mensagem com length-prefix
+// ============================================================
+
+bool TcpClient::receive_message(std::string& json, int timeout_ms) {
+    if (!connected_) return false;
+
+    // Espera o inicio do frame sem consumir nada
+    struct pollfd pfd{};
+    pfd.fd = socket_fd_;
+    pfd.events = POLLIN;
+
+    int ready = poll(&pfd, 1, timeout_ms);
+    if (ready == 0) {
+        return false;
+    }
+    if (ready < 0) {
         disconnect();
         return false;
     }
 
-    // Enviar payload JSON
-    if (!send_bytes(json.data(), json.size())) {
-        std::cerr << "[TCP] Failed to send payload, disconnecting" << std::endl;
+    uint32_t length_be = 0;
+    if (!recv_bytes(&length_be, sizeof(length_be))) {
+        return false;
+    }
+
+    uint32_t length = ntohl(length_be);
+    if (length == 0 || length > MAX_MESSAGE_LENGTH) {
+        std::cerr << "[TCP] Invalid message length " << length << ", disconnecting" << std::endl;
         disconnect();
         return false;
     }
 
+    json.resize(length);
+    return recv_bytes(&json[0], length);
+}
+
+// ============================================================
+// Receber bytes com loop. Chamado com o frame ja comecado:
+// timeout, erro ou conexao fechada desconectam.
+// ============================================================
+
+bool TcpClient::recv_bytes(void* data, size_t length) {
+    char* ptr = static_cast<char*>(data);
+    size_t remaining = length;
+
+    while (remaining > 0) {
+        struct pollfd pfd{};
+        pfd.fd = socket_fd_;
+        pfd.events = POLLIN;
+
+        if (poll(&pfd, 1, FRAME_TIMEOUT_MS) <= 0) {
+            std::cerr << "[TCP] Frame read timed out, disconnecting" << std::endl;
+            disconnect();
+            return false;
+        }
+
+        ssize_t received = recv(socket_fd_, ptr, remaining, 0);
+        if (received <= 0) {
+            disconnect();
+            return false;
+        }
+        ptr += received;
+        remaining -= received;
+    }
+
     return true;
 }
 
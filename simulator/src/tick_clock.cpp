@@ -0,0 +1,153 @@
+#include "tick_clock.hpp"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <thread>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+namespace mineguard {
+
+// ============================================================
+// Histograma de atraso do despertar
+// ============================================================
+
+constexpr int64_t JitterHistogram::BUCKET_LIMITS[];
+
+void JitterHistogram::record(int64_t late_us) {
+    if (late_us < 0) late_us = 0;
+
+    size_t b = 0;
+    while (b < BUCKET_COUNT - 1 && late_us >= BUCKET_LIMITS[b]) b++;
+    buckets[b]++;
+
+    samples++;
+    total_us += late_us;
+    if (late_us > max_us) max_us = late_us;
+}
+
+void JitterHistogram::clear() {
+    for (auto& b : buckets) b = 0;
+    samples = 0;
+    total_us = 0;
+    max_us = 0;
+}
+
+int64_t JitterHistogram::percentile_us(double p) const {
+    if (samples == 0) return 0;
+
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * (samples - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < BUCKET_COUNT - 1; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return BUCKET_LIMITS[b];
+    }
+    return max_us;
+}
+
+// ============================================================
+// Relogio por deadline absoluto
+// ============================================================
+
+TickClock::TickClock(std::chrono::milliseconds period, std::chrono::microseconds spin)
+    : period_(std::chrono::duration_cast<Clock::duration>(period))
+    , spin_(std::chrono::duration_cast<Clock::duration>(spin))
+    , wall_start_ms_(0)
+    , tick_timestamp_ms_(0)
+    , last_late_us_(0)
+    , resyncs_(0)
+    , jitter_{}
+{
+}
+
+void TickClock::start() {
+    using namespace std::chrono;
+
+    start_ = Clock::now();
+    deadline_ = start_;
+    wall_start_ms_ = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+    last_late_us_ = 0;
+    stamp(start_);
+}
+
+void TickClock::wait_next() {
+    using namespace std::chrono;
+
+    deadline_ += period_;
+
+    Clock::time_point now = Clock::now();
+    if (now - deadline_ > period_ * MAX_LAG_TICKS) {
+        // Muito atrasado (processo parado, debugger): recomeca a grade
+        deadline_ = now;
+        resyncs_++;
+    } else {
+        sleep_until(deadline_);
+        now = Clock::now();
+    }
+
+    last_late_us_ = duration_cast<microseconds>(now - deadline_).count();
+    jitter_.record(last_late_us_);
+    stamp(now);
+}
+
+void TickClock::stamp(Clock::time_point now) {
+    using namespace std::chrono;
+    tick_timestamp_ms_ = wall_start_ms_ + duration_cast<milliseconds>(now - start_).count();
+}
+
+void TickClock::sleep_until(Clock::time_point deadline) {
+    Clock::time_point wake = deadline - spin_;
+
+#ifdef __linux__
+    // steady_clock e CLOCK_MONOTONIC no Linux: dorme ate o instante
+    // absoluto, sem recalcular o intervalo a cada sinal
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake.time_since_epoch()).count();
+    if (ns > 0) {
+        timespec ts{};
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+    }
+#else
+    std::this_thread::sleep_until(wake);
+#endif
+
+    // Ultimos us em busy-spin
+    while (Clock::now() < deadline) {
+    }
+}
+
+// ============================================================
+// Resumo no console
+// ============================================================
+
+void TickClock::print_jitter(std::ostream& out) {
+    if (jitter_.samples == 0) return;
+
+    char line[320];
+    int len = std::snprintf(line, sizeof(line),
+                            "[CLOCK] Wake late: avg %" PRId64 "us p50<%" PRId64 "us p99<%" PRId64
+                            "us max %" PRId64 "us resyncs %" PRIu64 " |",
+                            jitter_.total_us / static_cast<int64_t>(jitter_.samples),
+                            jitter_.percentile_us(50), jitter_.percentile_us(99),
+                            jitter_.max_us, resyncs_);
+    for (size_t b = 0; b < JitterHistogram::BUCKET_COUNT && len > 0 &&
+                       len < static_cast<int>(sizeof(line)); b++) {
+        if (b < JitterHistogram::BUCKET_COUNT - 1) {
+            len += std::snprintf(line + len, sizeof(line) - len, " <%" PRId64 ":%" PRIu64,
+                                 JitterHistogram::BUCKET_LIMITS[b], jitter_.buckets[b]);
+        } else {
+            len += std::snprintf(line + len, sizeof(line) - len, " >=%" PRId64 ":%" PRIu64,
+                                 JitterHistogram::BUCKET_LIMITS[b - 1], jitter_.buckets[b]);
+        }
+    }
+    out << line << '\n';
+
+    jitter_.clear();
+}
+
+} // namespace mineguard
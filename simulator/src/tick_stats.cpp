@@ -0,0 +1,175 @@
+#include "tick_stats.hpp"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace mineguard {
+
+// ============================================================
+// Memoria por veiculo / por par
+// ============================================================
+
+MemoryReport MemoryReport::from(const MemoryFootprint& fleet, const MemoryFootprint& detector) {
+    size_t vehicles = fleet.vehicles;
+    size_t per_vehicle = fleet.per_vehicle_bytes + detector.per_vehicle_bytes;
+    size_t pairs = detector.pair_entries;
+
+    return MemoryReport{
+        .vehicles = vehicles,
+        .bytes_per_vehicle = vehicles > 0 ? per_vehicle / vehicles : 0,
+        .pair_entries = pairs,
+        .bytes_per_pair = pairs > 0 ? detector.pair_bytes / pairs : 0,
+        .shared_bytes = fleet.shared_bytes + detector.shared_bytes,
+        .live_heap_bytes = alloc_counter::snapshot().live_bytes
+    };
+}
+
+// ============================================================
+// Medicao por estagio
+// ============================================================
+
+TickStats::TickStats()
+    : stages_{}
+    , stage_heap_{}
+    , tick_micros_(0)
+    , memory_{}
+    , interval_{}
+    , interval_ticks_(0)
+    , interval_max_micros_(0)
+    , interval_total_micros_(0)
+    , interval_max_degradation_(0)
+{
+}
+
+const char* TickStats::stage_name(TickStage stage) {
+    switch (stage) {
+        case TickStage::UPDATE:    return "update";
+        case TickStage::SENSE:     return "sense";
+        case TickStage::COLLECT:   return "collect";
+        case TickStage::DETECT:    return "detect";
+        case TickStage::SERIALIZE: return "serialize";
+        case TickStage::OUTPUT:    return "output";
+        default: return "unknown";
+    }
+}
+
+bool TickStats::open_csv(const std::string& path) {
+    csv_.open(path, std::ios::out | std::ios::trunc);
+    if (!csv_.is_open()) return false;
+
+    csv_ << "tick,wake_late_us,degradation,tick_us";
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        const char* name = stage_name(static_cast<TickStage>(s));
+        csv_ << ',' << name << "_us," << name << "_allocs," << name << "_bytes";
+    }
+    csv_ << ",vehicles,bytes_per_vehicle,pair_entries,bytes_per_pair,shared_bytes,live_heap_bytes\n";
+    return true;
+}
+
+void TickStats::begin_tick() {
+    for (auto& s : stages_) s = StageSample{0, 0, 0};
+    tick_start_ = Clock::now();
+}
+
+void TickStats::begin_stage(TickStage) {
+    stage_heap_ = alloc_counter::snapshot();
+    stage_start_ = Clock::now();
+}
+
+void TickStats::end_stage(TickStage stage) {
+    auto now = Clock::now();
+    alloc_counter::Snapshot heap = alloc_counter::snapshot() - stage_heap_;
+
+    StageSample& s = stages_[static_cast<size_t>(stage)];
+    s.micros += std::chrono::duration_cast<std::chrono::microseconds>(now - stage_start_).count();
+    s.allocations += heap.allocations;
+    s.bytes += heap.bytes;
+}
+
+void TickStats::end_tick(uint64_t tick, int64_t wake_late_us, int degradation, const MemoryReport& memory) {
+    tick_micros_ = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - tick_start_
+    ).count();
+    memory_ = memory;
+
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        interval_[s].micros += stages_[s].micros;
+        interval_[s].allocations += stages_[s].allocations;
+        interval_[s].bytes += stages_[s].bytes;
+    }
+    interval_ticks_++;
+    interval_total_micros_ += tick_micros_;
+    if (tick_micros_ > interval_max_micros_) interval_max_micros_ = tick_micros_;
+    if (degradation > interval_max_degradation_) interval_max_degradation_ = degradation;
+
+    if (!csv_.is_open()) return;
+
+    // snprintf num buffer fixo: a linha do CSV nao aloca
+    char line[512];
+    int len = std::snprintf(line, sizeof(line), "%" PRIu64 ",%" PRId64 ",%d,%" PRId64,
+                            tick, wake_late_us, degradation, tick_micros_);
+    for (size_t s = 0; s < STAGE_COUNT && len > 0 && len < static_cast<int>(sizeof(line)); s++) {
+        len += std::snprintf(line + len, sizeof(line) - len, ",%" PRId64 ",%" PRIu64 ",%" PRIu64,
+                             stages_[s].micros, stages_[s].allocations, stages_[s].bytes);
+    }
+    if (len > 0 && len < static_cast<int>(sizeof(line))) {
+        len += std::snprintf(line + len, sizeof(line) - len, ",%zu,%zu,%zu,%zu,%zu,%" PRId64 "\n",
+                             memory.vehicles, memory.bytes_per_vehicle, memory.pair_entries,
+                             memory.bytes_per_pair, memory.shared_bytes, memory.live_heap_bytes);
+    }
+    if (len > 0 && len < static_cast<int>(sizeof(line))) {
+        csv_.write(line, len);
+    }
+}
+
+// ============================================================
+// Resumo no console
+// ============================================================
+
+void TickStats::print_summary(std::ostream& out, uint64_t tick) {
+    if (interval_ticks_ == 0) return;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "[STATS] Tick %" PRIu64 ": avg %" PRId64 "us max %" PRId64
+                  "us degrade %d |",
+                  tick, interval_total_micros_ / static_cast<int64_t>(interval_ticks_),
+                  interval_max_micros_, interval_max_degradation_);
+    out << line;
+
+    bool counting = alloc_counter::enabled();
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        const StageSample& acc = interval_[s];
+        if (counting) {
+            std::snprintf(line, sizeof(line), " %s %" PRId64 "us/%.1fa",
+                          stage_name(static_cast<TickStage>(s)),
+                          acc.micros / static_cast<int64_t>(interval_ticks_),
+                          static_cast<double>(acc.allocations) / interval_ticks_);
+        } else {
+            std::snprintf(line, sizeof(line), " %s %" PRId64 "us",
+                          stage_name(static_cast<TickStage>(s)),
+                          acc.micros / static_cast<int64_t>(interval_ticks_));
+        }
+        out << line;
+    }
+    out << '\n';
+
+    std::snprintf(line, sizeof(line),
+                  "[STATS] Memory: %zu vehicles x %zuB, %zu pairs x %zuB, shared %zuB",
+                  memory_.vehicles, memory_.bytes_per_vehicle,
+                  memory_.pair_entries, memory_.bytes_per_pair, memory_.shared_bytes);
+    out << line;
+    if (counting) {
+        out << ", live heap " << memory_.live_heap_bytes << "B";
+    }
+    out << '\n';
+
+    for (auto& s : interval_) s = StageSample{0, 0, 0};
+    interval_ticks_ = 0;
+    interval_max_micros_ = 0;
+    interval_total_micros_ = 0;
+    interval_max_degradation_ = 0;
+
+    if (csv_.is_open()) csv_.flush();
+}
+
+} // namespace mineguard
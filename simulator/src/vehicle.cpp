@@ -24,7 +24,8 @@ VehicleSpec Vehicle::default_spec(VehicleType type) {
                 .fuel_consumption = 180.0,   // liters/hour
                 .safety_radius = 30.0,       // metros
                 .length = 13.0,
-                .width = 8.0
+                .width = 8.0,
+                .side_clearance = 5.0
             };
         case VehicleType::EXCAVATOR:
             return VehicleSpec{
@@ -34,7 +35,8 @@ VehicleSpec Vehicle::default_spec(VehicleType type) {
                 .fuel_consumption = 120.0,
                 .safety_radius = 25.0,
                 .length = 15.0,
-                .width = 7.0
+                .width = 7.0,
+                .side_clearance = 10.0      // giro da lanca
             };
         case VehicleType::LIGHT_VEHICLE:
             return VehicleSpec{
@@ -44,7 +46,8 @@ VehicleSpec Vehicle::default_spec(VehicleType type) {
                 .fuel_consumption = 12.0,
                 .safety_radius = 10.0,
                 .length = 5.0,
-                .width = 2.2
+                .width = 2.2,
+                .side_clearance = 3.0
             };
     }
     return VehicleSpec{};
@@ -61,9 +64,45 @@ Vehicle::Vehicle(const std::string& id, VehicleType type, Position start_pos)
     , telemetry_{0.0, 0.0, 0.0, 100.0, 800.0}
     , target_speed_(0.0)
     , active_(true)
+    , route_path_(nullptr)
+    , route_next_index_(0)
+    , route_lead_(0.0)
+    , handle_{VehicleHandle::INVALID_SLOT, 0}
+    , loader_{VehicleHandle::INVALID_SLOT, 0}
+    , gnss_(false)
+    , fix_valid_(false)
+    , has_estimate_(false)
+    , fix_(start_pos)
+    , estimate_(start_pos)
+    , estimate_telemetry_(telemetry_)
+    , estimate_route_lead_(0.0)
+    , estimate_sigma_(0.0)
 {
 }
 
+void Vehicle::reset(const std::string& id, VehicleType type, Position start_pos) {
+    id_.assign(id);
+    type_ = type;
+    cycle_state_ = CycleState::IDLE;
+    spec_ = default_spec(type);
+    position_ = start_pos;
+    telemetry_ = Telemetry{0.0, 0.0, 0.0, 100.0, 800.0};
+    target_speed_ = 0.0;
+    active_ = true;
+    route_path_ = nullptr;
+    route_next_index_ = 0;
+    route_lead_ = 0.0;
+    loader_ = VehicleHandle{VehicleHandle::INVALID_SLOT, 0};
+    gnss_ = false;
+    fix_valid_ = false;
+    has_estimate_ = false;
+    fix_ = start_pos;
+    estimate_ = start_pos;
+    estimate_telemetry_ = telemetry_;
+    estimate_route_lead_ = 0.0;
+    estimate_sigma_ = 0.0;
+}
+
 // --- Update principal (chamado a cada tick) ---
 
 void Vehicle::update(double delta_time) {
@@ -89,6 +128,7 @@ void Vehicle::update(double delta_time) {
     apply_payload_effects();
     update_position(delta_time);
     update_fuel(delta_time);
+    refresh_route_lead();
 
     // RPM proporcional a velocidade
     double speed_ratio = telemetry_.speed / spec_.max_speed;
@@ -161,25 +201,82 @@ void Vehicle::apply_payload_effects() {
 // --- Predicao de posicao futura ---
 
 Position Vehicle::predict_position(double seconds_ahead) const {
-    double speed_ms = telemetry_.speed * KMH_TO_MS;
-    if (speed_ms < 0.01) return position_;
+    return predict_from(position_, telemetry_, route_lead_, seconds_ahead);
+}
+
+Position Vehicle::predict_sensed_position(double seconds_ahead) const {
+    if (!has_estimate_) return predict_position(seconds_ahead);
+    return predict_from(estimate_, estimate_telemetry_, estimate_route_lead_, seconds_ahead);
+}
+
+Position Vehicle::predict_from(const Position& origin, const Telemetry& telemetry,
+                               double lead, double seconds_ahead) const {
+    double speed_ms = telemetry.speed * KMH_TO_MS;
+    if (speed_ms < 0.01) return origin;
 
     double distance = speed_ms * seconds_ahead;
-    double heading_rad = telemetry_.heading * DEG_TO_RAD;
+
+    // Seguindo rota: anda pela polilinha em vez de extrapolar o heading
+    if (route_path_) return predict_along_route(origin, lead, distance);
+
+    double heading_rad = telemetry.heading * DEG_TO_RAD;
 
     double dx = distance * std::sin(heading_rad);
     double dy = distance * std::cos(heading_rad);
 
     double dlat = dy / EARTH_RADIUS * RAD_TO_DEG;
-    double dlon = dx / (EARTH_RADIUS * std::cos(position_.latitude * DEG_TO_RAD)) * RAD_TO_DEG;
+    double dlon = dx / (EARTH_RADIUS * std::cos(origin.latitude * DEG_TO_RAD)) * RAD_TO_DEG;
 
     return Position{
-        position_.latitude + dlat,
-        position_.longitude + dlon,
-        position_.altitude
+        origin.latitude + dlat,
+        origin.longitude + dlon,
+        origin.altitude
     };
 }
 
+// --- Predicao ao longo da polilinha da rota ---
+//
+// Primeiro trecho: posicao atual -> proximo waypoint (route_lead_).
+// Depois disso, s = cumulative[proximo] + restante, resolvido pela
+// tabela de comprimento acumulado da rota.
+
+Position Vehicle::predict_along_route(const Position& origin, double lead, double distance) const {
+    const Position& target = route_path_->points[route_next_index_];
+
+    if (distance < lead) {
+        double f = distance / lead;
+        return Position{
+            origin.latitude + (target.latitude - origin.latitude) * f,
+            origin.longitude + (target.longitude - origin.longitude) * f,
+            origin.altitude + (target.altitude - origin.altitude) * f
+        };
+    }
+
+    double s = route_path_->cumulative[route_next_index_] + (distance - lead);
+    return route_path_->position_at(s);
+}
+
+void Vehicle::set_route_path(const RoutePath* path, size_t next_index) {
+    if (path && path->points.empty()) path = nullptr;
+
+    route_path_ = path;
+    route_next_index_ = 0;
+    if (route_path_) {
+        // Fim de rota aberta: segura no ultimo waypoint
+        size_t last = route_path_->points.size() - 1;
+        route_next_index_ = (next_index > last) ? last : next_index;
+    }
+    refresh_route_lead();
+}
+
+void Vehicle::refresh_route_lead() {
+    if (!route_path_) {
+        route_lead_ = 0.0;
+        return;
+    }
+    route_lead_ = route_path_->distance(position_, route_path_->points[route_next_index_]);
+}
+
 // --- Gerar pacote de telemetria ---
 
 TelemetryPacket Vehicle::generate_packet() const {
@@ -188,14 +285,38 @@ TelemetryPacket Vehicle::generate_packet() const {
         system_clock::now().time_since_epoch()
     ).count();
 
-    return TelemetryPacket{
-        .vehicle_id = id_,
-        .timestamp = ts,
-        .position = position_,
-        .telemetry = telemetry_,
-        .vehicle_type = static_cast<int>(type_),
-        .cycle_state = static_cast<int>(cycle_state_)
-    };
+    TelemetryPacket packet{};
+    fill_packet(packet, ts);
+    return packet;
+}
+
+void Vehicle::fill_packet(TelemetryPacket& out, int64_t timestamp) const {
+    out.vehicle_id.assign(id_);
+    out.timestamp = timestamp;
+    out.position = gnss_ ? fix_ : position_;
+    out.telemetry = telemetry_;
+    out.vehicle_type = static_cast<int>(type_);
+    out.cycle_state = static_cast<int>(cycle_state_);
+}
+
+// --- Pipeline de GNSS ---
+
+void Vehicle::set_gnss_fix(const Position& fix, bool valid) {
+    gnss_ = true;
+    fix_valid_ = valid;
+    if (valid) fix_ = fix;
+}
+
+void Vehicle::set_estimate(const Position& position, double speed, double heading, double position_sigma) {
+    has_estimate_ = true;
+    estimate_ = position;
+    estimate_sigma_ = position_sigma;
+    estimate_telemetry_ = telemetry_;
+    estimate_telemetry_.speed = speed;
+    estimate_telemetry_.heading = heading;
+    estimate_route_lead_ = route_path_
+        ? route_path_->distance(estimate_, route_path_->points[route_next_index_])
+        : 0.0;
 }
 
 // --- Setters ---